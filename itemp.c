@@ -27,6 +27,8 @@
 // includes
 
 #include "itemp.h"
+#include "itemp_counters.h"
+#include "itemp_trace.h"
 
 // =============================================================================
 // local types and definitions
@@ -36,32 +38,128 @@
 #define F_100_SLOPE 5
 #define C_100_SLOPE 9
 
+#define ITEMP_MAX 65535
+
+#ifdef ITEMP_NARROW
+// For 8 and 16 bit targets: round with 16 bit arithmetic and a 16 x 16 bit
+// multiply instead of rquo()'s 32 bit division.  With d = o << pre, o odd,
+// u / d == ((u >> pre) * m) >> shift for every uint16_t u when
+// shift = 16 + floor(log2(o)) and m = ceil(2^shift / o), which fits in 16
+// bits.  The self test checks every u.
+#define NARROW(d, pre, shift) \
+  (d), (pre), (shift), NARROW_M((d) >> (pre), shift)
+#define NARROW_M(o, shift) \
+  (uint16_t)((((uint32_t)1 << (shift)) + (o) - 1) / (o))
+#define DIVIDE_BY_5 NARROW(5, 0, 18)
+#define DIVIDE_BY_9 NARROW(9, 0, 19)
+#define DIVIDE_BY_10 NARROW(10, 1, 18)
+#define DIVIDE_BY_50 NARROW(50, 1, 20)
+#define DIVIDE_BY_90 NARROW(90, 1, 21)
+#define DIVIDE_BY_100 NARROW(100, 2, 20)
+#define DIVIDE_BY_500 NARROW(500, 2, 22)
+#define DIVIDE_BY_900 NARROW(900, 2, 23)
+#define RQUO(x, divide_by) rquo_narrow((x), divide_by)
+#define RQUO_DELTA(x, divide_by) rquo_delta_narrow(clamp_delta(x), divide_by)
+#else
+#define DIVIDE_BY_5 5
+#define DIVIDE_BY_9 9
+#define DIVIDE_BY_10 10
+#define DIVIDE_BY_50 50
+#define DIVIDE_BY_90 90
+#define DIVIDE_BY_100 100
+#define DIVIDE_BY_500 500
+#define DIVIDE_BY_900 900
+#define RQUO(x, divide_by) rquo((x), divide_by)
+#define RQUO_DELTA(x, divide_by) rquo(clamp_delta(x), divide_by)
+#endif
+
 // =============================================================================
 // local (forward) declarations
 
 /**
  * @brief Return x/y, rounded to the nearest integer, using integer-only maths.
  *
- * Works with positive or negative x or y (4 quadrant).
+ * Works with positive or negative x or y (4 quadrant).  ITEMP_NARROW builds
+ * use it only to check their results.
  */
+#if !defined(ITEMP_NARROW) || defined(UNIT_TEST)
 static int16_t rquo(int32_t x, int32_t y);
+#endif
+
+#ifdef ITEMP_NARROW
+/**
+ * @brief Return u/d rounded to nearest, ties up, given d's NARROW() terms.
+ */
+static inline uint16_t urquo_narrow(uint16_t u, uint16_t d, uint8_t pre,
+                                    uint8_t shift, uint16_t m);
+
+/**
+ * @brief rquo(x, d) for d > 0, in 16 bits.
+ */
+static inline int16_t rquo_narrow(int16_t x, uint16_t d, uint8_t pre,
+                                  uint8_t shift, uint16_t m);
+
+/**
+ * @brief rquo(x, d) for d > 0 and |x| <= 65535, in 16 bits.
+ */
+static inline int16_t rquo_delta_narrow(int32_t x, uint16_t d, uint8_t pre,
+                                        uint8_t shift, uint16_t m);
+#endif
+
+/**
+ * @brief Clamp a delta to +/-65535, the difference of any two itemps, so that
+ * sums and rounding cannot overflow.
+ */
+static inline itemp_delta_t clamp_delta(itemp_delta_t delta);
+
+/**
+ * @brief The conversions themselves, shared by the public functions so that
+ * each call is counted once.
+ */
+static inline itemp_t f_100_to_itemp(uint16_t fahrenheit_100);
+static inline itemp_t c_100_to_itemp(uint16_t celsius_100);
+static inline int16_t itemp_to_f_100(itemp_t itemp);
+static inline int16_t itemp_to_c_100(itemp_t itemp);
+
+/**
+ * @brief Count and trace an input outside min..max, which wraps around.
+ */
+static inline void check_range(itemp_conversion_t conversion, int16_t value,
+                               int16_t min, int16_t max);
 
 // =============================================================================
 // local storage
 
+#ifdef ITEMP_USDT
+// The probe semaphores, which a tracer sets while it is attached.
+unsigned short itemp_batch__entry_semaphore __attribute__((section(".probes")));
+unsigned short itemp_batch__exit_semaphore __attribute__((section(".probes")));
+unsigned short itemp_out__of__range_semaphore
+    __attribute__((section(".probes")));
+#endif
+
 // =============================================================================
 // public code
 
 itemp_t fahrenheit_1_to_itemp(int16_t fahrenheit_1) {
-  return fahrenheit_100_to_itemp(fahrenheit_1 * 100);
+  ITEMP_COUNT_CALL(FAHRENHEIT_1_TO_ITEMP);
+  check_range(FAHRENHEIT_1_TO_ITEMP, fahrenheit_1,
+              ITEMP_MIN_FAHRENHEIT_100 / 100, ITEMP_MAX_FAHRENHEIT_100 / 100);
+  return f_100_to_itemp(fahrenheit_1 * 100u);
 }
 
 itemp_t fahrenheit_10_to_itemp(int16_t fahrenheit_10) {
-  return fahrenheit_100_to_itemp(fahrenheit_10 * 10);
+  ITEMP_COUNT_CALL(FAHRENHEIT_10_TO_ITEMP);
+  check_range(FAHRENHEIT_10_TO_ITEMP, fahrenheit_10,
+              ITEMP_MIN_FAHRENHEIT_100 / 10, ITEMP_MAX_FAHRENHEIT_100 / 10);
+  return f_100_to_itemp(fahrenheit_10 * 10u);
 }
 
 itemp_t fahrenheit_100_to_itemp(int16_t fahrenheit_100) {
-  return (fahrenheit_100 + F_100_OFFSET) * F_100_SLOPE;
+  ITEMP_COUNT_CALL(FAHRENHEIT_100_TO_ITEMP);
+  check_range(FAHRENHEIT_100_TO_ITEMP, fahrenheit_100, ITEMP_MIN_FAHRENHEIT_100,
+              ITEMP_MAX_FAHRENHEIT_100);
+  return f_100_to_itemp(fahrenheit_100);
 }
 
 itemp_t fahrenheit_to_itemp(float fahrenheit) {
@@ -69,15 +167,18 @@ itemp_t fahrenheit_to_itemp(float fahrenheit) {
 }
 
 int16_t itemp_to_fahrenheit_1(itemp_t itemp) {
-  return rquo(itemp_to_fahrenheit_100(itemp), 100);
+  ITEMP_COUNT_CALL(ITEMP_TO_FAHRENHEIT_1);
+  return RQUO(itemp_to_f_100(itemp), DIVIDE_BY_100);
 }
 
 int16_t itemp_to_fahrenheit_10(itemp_t itemp) {
-  return rquo(itemp_to_fahrenheit_100(itemp), 10);
+  ITEMP_COUNT_CALL(ITEMP_TO_FAHRENHEIT_10);
+  return RQUO(itemp_to_f_100(itemp), DIVIDE_BY_10);
 }
 
 int16_t itemp_to_fahrenheit_100(itemp_t itemp) {
-  return rquo(itemp, F_100_SLOPE) - F_100_OFFSET;
+  ITEMP_COUNT_CALL(ITEMP_TO_FAHRENHEIT_100);
+  return itemp_to_f_100(itemp);
 }
 
 float itemp_to_fahrenheit(itemp_t itemp) {
@@ -87,15 +188,24 @@ float itemp_to_fahrenheit(itemp_t itemp) {
 // celsius
 
 itemp_t celsius_1_to_itemp(int16_t celsius_1) {
-  return celsius_100_to_itemp(celsius_1 * 100);
+  ITEMP_COUNT_CALL(CELSIUS_1_TO_ITEMP);
+  check_range(CELSIUS_1_TO_ITEMP, celsius_1, ITEMP_MIN_CELSIUS_100 / 100,
+              ITEMP_MAX_CELSIUS_100 / 100);
+  return c_100_to_itemp(celsius_1 * 100u);
 }
 
 itemp_t celsius_10_to_itemp(int16_t celsius_10) {
-  return celsius_100_to_itemp(celsius_10 * 10);
+  ITEMP_COUNT_CALL(CELSIUS_10_TO_ITEMP);
+  check_range(CELSIUS_10_TO_ITEMP, celsius_10, ITEMP_MIN_CELSIUS_100 / 10,
+              ITEMP_MAX_CELSIUS_100 / 10);
+  return c_100_to_itemp(celsius_10 * 10u);
 }
 
 itemp_t celsius_100_to_itemp(int16_t celsius_100) {
-  return (celsius_100 + C_100_OFFSET) * C_100_SLOPE;
+  ITEMP_COUNT_CALL(CELSIUS_100_TO_ITEMP);
+  check_range(CELSIUS_100_TO_ITEMP, celsius_100, ITEMP_MIN_CELSIUS_100,
+              ITEMP_MAX_CELSIUS_100);
+  return c_100_to_itemp(celsius_100);
 }
 
 itemp_t celsius_to_itemp(float celsius) {
@@ -103,24 +213,165 @@ itemp_t celsius_to_itemp(float celsius) {
 }
 
 int16_t itemp_to_celsius_1(itemp_t itemp) {
-  return rquo(itemp_to_celsius_100(itemp), 100);
+  ITEMP_COUNT_CALL(ITEMP_TO_CELSIUS_1);
+  return RQUO(itemp_to_c_100(itemp), DIVIDE_BY_100);
 }
 
 int16_t itemp_to_celsius_10(itemp_t itemp) {
-  return rquo(itemp_to_celsius_100(itemp), 10);
+  ITEMP_COUNT_CALL(ITEMP_TO_CELSIUS_10);
+  return RQUO(itemp_to_c_100(itemp), DIVIDE_BY_10);
 }
 
 int16_t itemp_to_celsius_100(itemp_t itemp) {
-  return rquo(itemp, C_100_SLOPE) - C_100_OFFSET;
+  ITEMP_COUNT_CALL(ITEMP_TO_CELSIUS_100);
+  return itemp_to_c_100(itemp);
 }
 
 float itemp_to_celsius(itemp_t itemp) {
   return ((itemp / (float)C_100_SLOPE) - C_100_OFFSET) / 100.0;
 }
 
+// deltas
+
+itemp_delta_t itemp_difference(itemp_t a, itemp_t b) {
+  return (itemp_delta_t)a - (itemp_delta_t)b;
+}
+
+itemp_t itemp_add_delta(itemp_t itemp, itemp_delta_t delta) {
+  int32_t sum = itemp + clamp_delta(delta);
+  ITEMP_COUNT_DELTA(sum < 0 || sum > ITEMP_MAX);
+  return (sum < 0) ? 0 : (sum > ITEMP_MAX) ? ITEMP_MAX : (itemp_t)sum;
+}
+
+itemp_delta_t fahrenheit_1_to_itemp_delta(int16_t fahrenheit_1) {
+  return (itemp_delta_t)fahrenheit_1 * ITEMP_ONE_DEGREE_F;
+}
+
+itemp_delta_t fahrenheit_10_to_itemp_delta(int16_t fahrenheit_10) {
+  return (itemp_delta_t)fahrenheit_10 * ITEMP_ONE_TENTH_DEGREE_F;
+}
+
+itemp_delta_t fahrenheit_100_to_itemp_delta(int16_t fahrenheit_100) {
+  return (itemp_delta_t)fahrenheit_100 * ITEMP_ONE_HUNDRETH_DEGREE_F;
+}
+
+int16_t itemp_delta_to_fahrenheit_1(itemp_delta_t delta) {
+  return RQUO_DELTA(delta, DIVIDE_BY_500);
+}
+
+int16_t itemp_delta_to_fahrenheit_10(itemp_delta_t delta) {
+  return RQUO_DELTA(delta, DIVIDE_BY_50);
+}
+
+int16_t itemp_delta_to_fahrenheit_100(itemp_delta_t delta) {
+  return RQUO_DELTA(delta, DIVIDE_BY_5);
+}
+
+itemp_delta_t celsius_1_to_itemp_delta(int16_t celsius_1) {
+  return (itemp_delta_t)celsius_1 * ITEMP_ONE_DEGREE_C;
+}
+
+itemp_delta_t celsius_10_to_itemp_delta(int16_t celsius_10) {
+  return (itemp_delta_t)celsius_10 * ITEMP_ONE_TENTH_DEGREE_C;
+}
+
+itemp_delta_t celsius_100_to_itemp_delta(int16_t celsius_100) {
+  return (itemp_delta_t)celsius_100 * ITEMP_ONE_HUNDRETH_DEGREE_C;
+}
+
+int16_t itemp_delta_to_celsius_1(itemp_delta_t delta) {
+  return RQUO_DELTA(delta, DIVIDE_BY_900);
+}
+
+int16_t itemp_delta_to_celsius_10(itemp_delta_t delta) {
+  return RQUO_DELTA(delta, DIVIDE_BY_90);
+}
+
+int16_t itemp_delta_to_celsius_100(itemp_delta_t delta) {
+  return RQUO_DELTA(delta, DIVIDE_BY_9);
+}
+
+// uncounted, for itemp_tune.h
+
+uint16_t itemp_convert_value(itemp_conversion_t conversion, uint16_t value) {
+  int16_t signed_value = (int16_t)value;
+  switch (conversion) {
+  case ITEMP_TO_FAHRENHEIT_1:
+    return (uint16_t)RQUO(itemp_to_f_100(value), DIVIDE_BY_100);
+  case ITEMP_TO_FAHRENHEIT_10:
+    return (uint16_t)RQUO(itemp_to_f_100(value), DIVIDE_BY_10);
+  case ITEMP_TO_FAHRENHEIT_100:
+    return (uint16_t)itemp_to_f_100(value);
+  case ITEMP_TO_CELSIUS_1:
+    return (uint16_t)RQUO(itemp_to_c_100(value), DIVIDE_BY_100);
+  case ITEMP_TO_CELSIUS_10:
+    return (uint16_t)RQUO(itemp_to_c_100(value), DIVIDE_BY_10);
+  case ITEMP_TO_CELSIUS_100:
+    return (uint16_t)itemp_to_c_100(value);
+  case FAHRENHEIT_1_TO_ITEMP:
+    return f_100_to_itemp(signed_value * 100u);
+  case FAHRENHEIT_10_TO_ITEMP:
+    return f_100_to_itemp(signed_value * 10u);
+  case FAHRENHEIT_100_TO_ITEMP:
+    return f_100_to_itemp(value);
+  case CELSIUS_1_TO_ITEMP:
+    return c_100_to_itemp(signed_value * 100u);
+  case CELSIUS_10_TO_ITEMP:
+    return c_100_to_itemp(signed_value * 10u);
+  case CELSIUS_100_TO_ITEMP:
+    return c_100_to_itemp(value);
+  default:
+    return 0;
+  }
+}
+
 // =============================================================================
 // local (static) code
 
+// Unsigned, and so modulo 2^16 wherever int is 16 bits: out of range values
+// wrap the same way on every target.
+static inline itemp_t f_100_to_itemp(uint16_t fahrenheit_100) {
+  return (itemp_t)((fahrenheit_100 + F_100_OFFSET) * F_100_SLOPE);
+}
+
+static inline itemp_t c_100_to_itemp(uint16_t celsius_100) {
+  return (itemp_t)((celsius_100 + C_100_OFFSET) * C_100_SLOPE);
+}
+
+#ifdef ITEMP_NARROW
+static inline int16_t itemp_to_f_100(itemp_t itemp) {
+  return (int16_t)(urquo_narrow(itemp, DIVIDE_BY_5) - F_100_OFFSET);
+}
+
+static inline int16_t itemp_to_c_100(itemp_t itemp) {
+  return (int16_t)(urquo_narrow(itemp, DIVIDE_BY_9) - C_100_OFFSET);
+}
+#else
+static inline int16_t itemp_to_f_100(itemp_t itemp) {
+  return rquo(itemp, F_100_SLOPE) - F_100_OFFSET;
+}
+
+static inline int16_t itemp_to_c_100(itemp_t itemp) {
+  return rquo(itemp, C_100_SLOPE) - C_100_OFFSET;
+}
+#endif
+
+static inline void check_range(itemp_conversion_t conversion, int16_t value,
+                               int16_t min, int16_t max) {
+  ITEMP_COUNT_IF_OUT_OF_RANGE(conversion, value, min, max);
+  ITEMP_TRACE_IF_OUT_OF_RANGE(conversion, value, min, max);
+}
+
+static inline itemp_delta_t clamp_delta(itemp_delta_t delta) {
+  if (delta < -ITEMP_MAX) {
+    return -ITEMP_MAX;
+  } else if (delta > ITEMP_MAX) {
+    return ITEMP_MAX;
+  }
+  return delta;
+}
+
+#if !defined(ITEMP_NARROW) || defined(UNIT_TEST)
 static int16_t rquo(int32_t x, int32_t y) {
   if ((x ^ y) >= 0) {             // beware of operator precedence
     return (x + y/2) / y;        // signs match, positive quotient
@@ -128,63 +379,45 @@ static int16_t rquo(int32_t x, int32_t y) {
     return (x - y/2) / y;        // signs differ, negative quotient
   }
 }
+#endif
+
+#ifdef ITEMP_NARROW
+static inline uint16_t urquo_narrow(uint16_t u, uint16_t d, uint8_t pre,
+                                    uint8_t shift, uint16_t m) {
+  uint16_t q = (uint16_t)(((uint32_t)(uint16_t)(u >> pre) * m) >> shift);
+  uint16_t r = (uint16_t)(u - q * d);  // r < d, so neither side overflows
+  return q + (r >= d - r);
+}
+
+static inline int16_t rquo_narrow(int16_t x, uint16_t d, uint8_t pre,
+                                  uint8_t shift, uint16_t m) {
+  if (x < 0) {
+    return -(int16_t)urquo_narrow((uint16_t)(0u - (uint16_t)x), d, pre, shift,
+                                  m);
+  }
+  return (int16_t)urquo_narrow((uint16_t)x, d, pre, shift, m);
+}
+
+static inline int16_t rquo_delta_narrow(int32_t x, uint16_t d, uint8_t pre,
+                                        uint8_t shift, uint16_t m) {
+  if (x < 0) {
+    return -(int16_t)urquo_narrow((uint16_t)-x, d, pre, shift, m);
+  }
+  return (int16_t)urquo_narrow((uint16_t)x, d, pre, shift, m);
+}
+#endif
 
 // =============================================================================
 // self test
 
-// To run tests on a unix-like system:
+// To run tests on a unix-like system, in either build mode:
 //   cc -Wall -DUNIT_TEST -o itemp itemp.c && ./itemp && rm -f itemp
+//   cc -Wall -DUNIT_TEST -DITEMP_NARROW -o itemp itemp.c
+//   ./itemp && rm -f itemp
 
 #ifdef UNIT_TEST
 
-#include <stdio.h>
-
-#define ASSERT_INT(observed, expected)                                  \
-  unit_test_assert_eq_int((observed), (expected), #observed, #expected, \
-                          __FILE__, __LINE__)
-void unit_test_assert_eq_int(const int observed, const int expected,
-                             const char *observed_expr,
-                             const char *expected_expr, const char *const file,
-                             const int line);
-
-#define ASSERT_EPS(f0, f1, eps) \
-  unit_test_float_eps((f0), (f1), (eps), #f0, #f1, #eps, __FILE__, __LINE__)
-void unit_test_float_eps(const float f0, const float f1, const float eps,
-                         const char *const f0_expr, const char *const f1_expr,
-                         const char *const eps_expr, const char *const file,
-                         const int line);
-
-/**
- * @brief pass the test if observed_expr and expected_expr are integer equal
- */
-void unit_test_assert_eq_int(const int observed, const int expected,
-                             const char *observed_expr,
-                             const char *expected_expr, const char *const file,
-                             const int line) {
-  if (observed != expected) {
-    printf("\r\n%d != %d in %s == %s at %s:%d", observed, expected,
-           observed_expr, expected_expr, file, line);
-    fflush(stdout);
-  }
-}
-
-/**
- * @brief pass the test if f0 and f1 differ by less than eps
- */
-void unit_test_float_eps(const float f0, const float f1, const float eps,
-                         const char *const f0_expr, const char *const f1_expr,
-                         const char *const eps_expr, const char *const file,
-                         const int line) {
-  float diff = f0 - f1;
-  if (diff < 0) diff = -diff;
-  if (diff >= eps) {
-    printf(
-        "\r\n%f and %f differ by more than %f in UTEST_FLOAT_EPS(%s, %s, %s) "
-        "at %s:%d",
-        f0, f1, eps, f0_expr, f1_expr, eps_expr, file, line);
-    fflush(stdout);
-  }
-}
+#include "itemp_unit_test.h"
 
 int main() {
   printf("Beginning unit tests...");
@@ -541,6 +774,129 @@ int main() {
   ASSERT_EPS(itemp_to_celsius(8) * 100.0, itemp_to_celsius_100(8), 0.5);
   ASSERT_EPS(itemp_to_celsius(9) * 100.0, itemp_to_celsius_100(9), 0.5);
 
+  // ===========================================
+  // Deltas
+
+  ASSERT_INT(itemp_difference(0, 65535), -65535);
+  ASSERT_INT(itemp_difference(65535, 0), 65535);
+  ASSERT_INT(itemp_difference(fahrenheit_1_to_itemp(70),
+                              fahrenheit_1_to_itemp(68)),
+             fahrenheit_1_to_itemp_delta(2));
+
+  ASSERT_INT(itemp_add_delta(1000, -2 * ITEMP_ONE_DEGREE_F), 0);  // no wrap
+  ASSERT_INT(itemp_add_delta(65000, ITEMP_ONE_DEGREE_C), 65535);
+  ASSERT_INT(itemp_add_delta(1000, -1000), 0);
+  ASSERT_INT(itemp_add_delta(1000, INT32_MIN), 0);
+  ASSERT_INT(itemp_add_delta(1000, INT32_MAX), 65535);
+  ASSERT_INT(itemp_to_fahrenheit_100(itemp_add_delta(
+                 fahrenheit_1_to_itemp(70), fahrenheit_1_to_itemp_delta(-2))),
+             6800);
+  ASSERT_INT(itemp_to_celsius_100(itemp_add_delta(
+                 celsius_100_to_itemp(2000), celsius_10_to_itemp_delta(15))),
+             2150);
+
+  ASSERT_INT(fahrenheit_1_to_itemp_delta(-100), -50000);  // beyond int16_t
+  ASSERT_INT(fahrenheit_10_to_itemp_delta(-25), -1250);
+  ASSERT_INT(fahrenheit_100_to_itemp_delta(7), 35);
+  ASSERT_INT(celsius_1_to_itemp_delta(50), 45000);
+  ASSERT_INT(celsius_10_to_itemp_delta(-3), -270);
+  ASSERT_INT(celsius_100_to_itemp_delta(-7), -63);
+
+  ASSERT_INT(itemp_delta_to_fahrenheit_1(-65535), -131);
+  ASSERT_INT(itemp_delta_to_fahrenheit_1(250), 1);     // ties away from zero
+  ASSERT_INT(itemp_delta_to_fahrenheit_1(-250), -1);
+  ASSERT_INT(itemp_delta_to_fahrenheit_1(-249), 0);
+  ASSERT_INT(itemp_delta_to_fahrenheit_10(-1250), -25);
+  ASSERT_INT(itemp_delta_to_fahrenheit_100(-3), -1);
+  ASSERT_INT(itemp_delta_to_celsius_1(65535), 73);
+  ASSERT_INT(itemp_delta_to_celsius_10(-45), -1);
+  ASSERT_INT(itemp_delta_to_celsius_100(-4), 0);
+  ASSERT_INT(itemp_delta_to_celsius_100(-5), -1);
+
+  // ===========================================
+  // every input against the 32 bit reference, so -DITEMP_NARROW is checked
+  // bit for bit
+
+  int mismatches = 0;
+  for (int32_t i = 0; i <= ITEMP_MAX; i++) {
+    itemp_t itemp = (itemp_t)i;
+    int16_t value = (int16_t)(i - 32768);
+    int16_t f_100 = rquo(itemp, F_100_SLOPE) - F_100_OFFSET;
+    int16_t c_100 = rquo(itemp, C_100_SLOPE) - C_100_OFFSET;
+    mismatches += itemp_to_fahrenheit_100(itemp) != f_100;
+    mismatches += itemp_to_fahrenheit_10(itemp) != rquo(f_100, 10);
+    mismatches += itemp_to_fahrenheit_1(itemp) != rquo(f_100, 100);
+    mismatches += itemp_to_celsius_100(itemp) != c_100;
+    mismatches += itemp_to_celsius_10(itemp) != rquo(c_100, 10);
+    mismatches += itemp_to_celsius_1(itemp) != rquo(c_100, 100);
+    mismatches += fahrenheit_100_to_itemp(value) !=
+                  (itemp_t)((value + F_100_OFFSET) * F_100_SLOPE);
+    mismatches += fahrenheit_10_to_itemp(value) !=
+                  (itemp_t)(((int16_t)(value * 10) + F_100_OFFSET) *
+                            F_100_SLOPE);
+    mismatches += fahrenheit_1_to_itemp(value) !=
+                  (itemp_t)(((int16_t)(value * 100) + F_100_OFFSET) *
+                            F_100_SLOPE);
+    mismatches += celsius_100_to_itemp(value) !=
+                  (itemp_t)((value + C_100_OFFSET) * C_100_SLOPE);
+    mismatches += celsius_10_to_itemp(value) !=
+                  (itemp_t)(((int16_t)(value * 10) + C_100_OFFSET) *
+                            C_100_SLOPE);
+    mismatches += celsius_1_to_itemp(value) !=
+                  (itemp_t)(((int16_t)(value * 100) + C_100_OFFSET) *
+                            C_100_SLOPE);
+  }
+  ASSERT_INT(mismatches, 0);
+
+  // the uncounted conversions, against the counted ones
+  mismatches = 0;
+  for (int32_t i = 0; i <= ITEMP_MAX; i++) {
+    mismatches += (int16_t)itemp_convert_value(ITEMP_TO_FAHRENHEIT_1, i) !=
+                  itemp_to_fahrenheit_1(i);
+    mismatches += (int16_t)itemp_convert_value(ITEMP_TO_FAHRENHEIT_10, i) !=
+                  itemp_to_fahrenheit_10(i);
+    mismatches += (int16_t)itemp_convert_value(ITEMP_TO_FAHRENHEIT_100, i) !=
+                  itemp_to_fahrenheit_100(i);
+    mismatches += (int16_t)itemp_convert_value(ITEMP_TO_CELSIUS_1, i) !=
+                  itemp_to_celsius_1(i);
+    mismatches += (int16_t)itemp_convert_value(ITEMP_TO_CELSIUS_10, i) !=
+                  itemp_to_celsius_10(i);
+    mismatches += (int16_t)itemp_convert_value(ITEMP_TO_CELSIUS_100, i) !=
+                  itemp_to_celsius_100(i);
+    mismatches += itemp_convert_value(FAHRENHEIT_1_TO_ITEMP, i) !=
+                  fahrenheit_1_to_itemp((int16_t)i);
+    mismatches += itemp_convert_value(FAHRENHEIT_10_TO_ITEMP, i) !=
+                  fahrenheit_10_to_itemp((int16_t)i);
+    mismatches += itemp_convert_value(FAHRENHEIT_100_TO_ITEMP, i) !=
+                  fahrenheit_100_to_itemp((int16_t)i);
+    mismatches += itemp_convert_value(CELSIUS_1_TO_ITEMP, i) !=
+                  celsius_1_to_itemp((int16_t)i);
+    mismatches += itemp_convert_value(CELSIUS_10_TO_ITEMP, i) !=
+                  celsius_10_to_itemp((int16_t)i);
+    mismatches += itemp_convert_value(CELSIUS_100_TO_ITEMP, i) !=
+                  celsius_100_to_itemp((int16_t)i);
+  }
+  ASSERT_INT(mismatches, 0);
+
+  mismatches = 0;
+  for (int32_t d = -2 * ITEMP_MAX; d <= 2 * ITEMP_MAX; d++) {
+    int32_t delta = clamp_delta(d);
+    mismatches += itemp_delta_to_fahrenheit_1(d) != rquo(delta, 500);
+    mismatches += itemp_delta_to_fahrenheit_10(d) != rquo(delta, 50);
+    mismatches += itemp_delta_to_fahrenheit_100(d) != rquo(delta, 5);
+    mismatches += itemp_delta_to_celsius_1(d) != rquo(delta, 900);
+    mismatches += itemp_delta_to_celsius_10(d) != rquo(delta, 90);
+    mismatches += itemp_delta_to_celsius_100(d) != rquo(delta, 9);
+  }
+  ASSERT_INT(mismatches, 0);
+
+  // deltas past any difference of two itemps clamp rather than overflow
+  ASSERT_INT(itemp_delta_to_fahrenheit_100(INT32_MAX), 13107);
+  ASSERT_INT(itemp_delta_to_fahrenheit_100(INT32_MIN), -13107);
+  ASSERT_INT(itemp_delta_to_fahrenheit_1(INT32_MAX - 100), 131);
+  ASSERT_INT(itemp_delta_to_celsius_100(-100000), -7282);
+  ASSERT_INT(itemp_delta_to_celsius_1(INT32_MIN), -73);
+
   printf("\r\n...unit tests complete.\r\n");
 }
 
@@ -13,6 +13,10 @@
  * printf("Temperature is %dF (%dC)\n", f, c);
  * @code
  *
+ * On 8 and 16 bit microcontrollers, compile itemp.c with -DITEMP_NARROW to
+ * convert with 16 bit arithmetic and 16 x 16 bit multiplies, with no division.
+ * The results are identical.
+ *
  * @author R. Dunbar Poor
  * @version 1.0
  * @date January 2020
@@ -68,6 +72,22 @@ typedef uint16_t itemp_t;
 #define ITEMP_ONE_TENTH_DEGREE_C 90
 #define ITEMP_ONE_HUNDRETH_DEGREE_C 9
 
+// The range of temperatures that can be represented as an itemp_t.  Values
+// outside of this range wrap around when converted to itemp.
+#define ITEMP_MIN_FAHRENHEIT_100 (-1552)
+#define ITEMP_MAX_FAHRENHEIT_100 11555
+#define ITEMP_MIN_CELSIUS_100 (-2640)
+#define ITEMP_MAX_CELSIUS_100 4641
+
+/**
+ * @brief A signed difference between two itemp values, in the same units.
+ *
+ * itemp_t is unsigned, so `itemp -= 2 * ITEMP_ONE_DEGREE_F` silently wraps
+ * near the bottom of the range.  Differences need 17 bits, so itemp_delta_t
+ * is 32 bits and never wraps; itemp_add_delta() saturates instead.
+ */
+typedef int32_t itemp_delta_t;
+
 // =============================================================================
 // declarations
 
@@ -145,6 +165,48 @@ int16_t itemp_to_celsius_10(itemp_t itemp);
 int16_t itemp_to_celsius_100(itemp_t itemp);
 float itemp_to_celsius(itemp_t itemp);
 
+/**
+ * Return a - b, exactly.
+ */
+itemp_delta_t itemp_difference(itemp_t a, itemp_t b);
+
+/**
+ * Add a delta to an itemp, saturating at 0 and 65535 rather than wrapping.
+ */
+itemp_t itemp_add_delta(itemp_t itemp, itemp_delta_t delta);
+
+/**
+ * Convert a temperature difference in degrees Fahrenheit to an itemp delta.
+ *
+ * @param fahrenheit_1 Difference in degrees Fahrenheit.
+ * @returns The corresponding itemp delta.
+ */
+itemp_delta_t fahrenheit_1_to_itemp_delta(int16_t fahrenheit_1);
+itemp_delta_t fahrenheit_10_to_itemp_delta(int16_t fahrenheit_10);
+itemp_delta_t fahrenheit_100_to_itemp_delta(int16_t fahrenheit_100);
+
+/**
+ * Convert an itemp delta to degrees Fahrenheit, rounded to nearest.
+ *
+ * Deltas beyond +/-65535, more than the difference of any two itemps, are
+ * clamped to it first, as itemp_add_delta() does, so the result always fits
+ * in an int16_t.  The same holds for itemp_delta_to_celsius_xxx().
+ *
+ * @param delta A difference between itemp values.
+ * @returns The difference in degrees Fahrenheit.
+ */
+int16_t itemp_delta_to_fahrenheit_1(itemp_delta_t delta);
+int16_t itemp_delta_to_fahrenheit_10(itemp_delta_t delta);
+int16_t itemp_delta_to_fahrenheit_100(itemp_delta_t delta);
+
+itemp_delta_t celsius_1_to_itemp_delta(int16_t celsius_1);
+itemp_delta_t celsius_10_to_itemp_delta(int16_t celsius_10);
+itemp_delta_t celsius_100_to_itemp_delta(int16_t celsius_100);
+
+int16_t itemp_delta_to_celsius_1(itemp_delta_t delta);
+int16_t itemp_delta_to_celsius_10(itemp_delta_t delta);
+int16_t itemp_delta_to_celsius_100(itemp_delta_t delta);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,406 @@
+/** @file itemp_array.hpp
+ * A C++ array of itemp values whose arithmetic is evaluated lazily, so that a
+ * whole expression runs as one loop over the data with no temporary arrays:
+ *
+ * @code
+ * itemp::array a = ..., b = ..., c = ...;
+ * itemp::array avg = (a + b + c) / 3;
+ * avg += 2 * ITEMP_ONE_DEGREE_F;
+ * std::vector<int16_t> c100(avg.size());
+ * itemp::evaluate(itemp::to_celsius_100((a + b) / 2), c100.data());
+ * @endcode
+ *
+ * Inside an expression each element is an int32_t, so sums of itemps do not
+ * wrap.  Division rounds to nearest, like the conversions in itemp.c, and uses a
+ * precomputed multiplier so the loop still vectorizes.  When a result is stored
+ * it is clamped to the range of the destination type.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_ARRAY_HPP_
+#define _ITEMP_ARRAY_HPP_
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace itemp {
+
+// =============================================================================
+// types and definitions
+
+/**
+ * @brief Base of every array expression.  E is the derived type.
+ */
+template <class E>
+class expression {
+ public:
+  const E &self() const { return static_cast<const E &>(*this); }
+  size_t size() const { return self().size(); }
+  int32_t operator[](size_t i) const { return self()[i]; }
+};
+
+namespace detail {
+
+/**
+ * @brief A constant that takes part in an expression, such as an offset.
+ */
+class scalar : public expression<scalar> {
+ public:
+  explicit scalar(int32_t value) : value_(value) {}
+  static constexpr size_t size() { return std::numeric_limits<size_t>::max(); }
+  int32_t operator[](size_t) const { return value_; }
+
+ private:
+  int32_t value_;
+};
+
+/**
+ * @brief Rounded division by a divisor fixed at run time, done with a
+ * multiply and shift so that it vectorizes.
+ *
+ * Exact for any dividend whose magnitude is below 2^30.
+ */
+class divider {
+ public:
+  explicit divider(int32_t divisor) {
+    assert(divisor != 0);
+    negative_ = divisor < 0;
+    uint64_t d = negative_ ? -(int64_t)divisor : divisor;
+    unsigned log2_d = 0;
+    while ((1ull << log2_d) < d) {
+      log2_d += 1;
+    }
+    half_ = (uint32_t)(d / 2);
+    shift_ = 31 + log2_d;
+    multiplier_ = ((1ull << shift_) + d - 1) / d;
+  }
+
+  int32_t operator()(int32_t x) const {
+    bool negative = (x < 0) != negative_;
+    uint64_t magnitude = (uint32_t)(x < 0 ? -x : x) + half_;
+    int32_t quotient = (int32_t)((magnitude * multiplier_) >> shift_);
+    return negative ? -quotient : quotient;
+  }
+
+ private:
+  uint64_t multiplier_;
+  unsigned shift_;
+  uint32_t half_;
+  bool negative_;
+};
+
+template <class L, class R>
+size_t common_size(const L &l, const R &r) {
+  assert(l.size() == r.size() || l.size() == scalar::size() ||
+         r.size() == scalar::size());
+  return (l.size() < r.size()) ? l.size() : r.size();
+}
+
+}  // namespace detail
+
+class array;
+
+namespace detail {
+
+// Arrays are held by reference inside expressions, everything else by value.
+template <class E>
+struct operand {
+  using type = const E;
+};
+template <>
+struct operand<array> {
+  using type = const array &;
+};
+
+struct plus {
+  static int32_t apply(int32_t l, int32_t r) { return l + r; }
+};
+struct minus {
+  static int32_t apply(int32_t l, int32_t r) { return l - r; }
+};
+struct multiplies {
+  static int32_t apply(int32_t l, int32_t r) { return l * r; }
+};
+
+template <class L, class R, class Op>
+class binary : public expression<binary<L, R, Op>> {
+ public:
+  binary(const L &l, const R &r) : l_(l), r_(r) {}
+  size_t size() const { return common_size(l_, r_); }
+  int32_t operator[](size_t i) const { return Op::apply(l_[i], r_[i]); }
+
+ private:
+  typename operand<L>::type l_;
+  typename operand<R>::type r_;
+};
+
+template <class E>
+class quotient : public expression<quotient<E>> {
+ public:
+  quotient(const E &e, int32_t divisor) : e_(e), divider_(divisor) {}
+  size_t size() const { return e_.size(); }
+  int32_t operator[](size_t i) const { return divider_(e_[i]); }
+
+ private:
+  typename operand<E>::type e_;
+  divider divider_;
+};
+
+/**
+ * @brief Clamp v to the values an itemp_t can hold.
+ */
+inline int32_t clamp_itemp(int32_t v) {
+  return (v < 0) ? 0 : (v > UINT16_MAX) ? UINT16_MAX : v;
+}
+
+/**
+ * @brief Branch free rquo(x, y) for y > 0.
+ */
+inline int32_t rquo(int32_t x, int32_t y) {
+  return (x + ((x < 0) ? -(y / 2) : (y / 2))) / y;
+}
+
+template <int32_t Slope, int32_t Offset, int32_t Divisor>
+struct to_unit {
+  static int32_t apply(int32_t itemp) {
+    int32_t value_100 = (clamp_itemp(itemp) + Slope / 2) / Slope - Offset;
+    return (Divisor == 1) ? value_100 : rquo(value_100, Divisor);
+  }
+};
+
+template <class E, class Conversion>
+class converted : public expression<converted<E, Conversion>> {
+ public:
+  explicit converted(const E &e) : e_(e) {}
+  size_t size() const { return e_.size(); }
+  int32_t operator[](size_t i) const { return Conversion::apply(e_[i]); }
+
+ private:
+  typename operand<E>::type e_;
+};
+
+template <class T>
+T store(int32_t v) {
+  if constexpr (std::is_same_v<T, int32_t>) {
+    return v;
+  } else {
+    constexpr int32_t lo = std::numeric_limits<T>::min();
+    constexpr int32_t hi = std::numeric_limits<T>::max();
+    return (T)((v < lo) ? lo : (v > hi) ? hi : v);
+  }
+}
+
+using to_fahrenheit_1_t = to_unit<ITEMP_ONE_HUNDRETH_DEGREE_F,
+                                  -ITEMP_MIN_FAHRENHEIT_100, 100>;
+using to_fahrenheit_10_t = to_unit<ITEMP_ONE_HUNDRETH_DEGREE_F,
+                                   -ITEMP_MIN_FAHRENHEIT_100, 10>;
+using to_fahrenheit_100_t = to_unit<ITEMP_ONE_HUNDRETH_DEGREE_F,
+                                    -ITEMP_MIN_FAHRENHEIT_100, 1>;
+using to_celsius_1_t = to_unit<ITEMP_ONE_HUNDRETH_DEGREE_C,
+                               -ITEMP_MIN_CELSIUS_100, 100>;
+using to_celsius_10_t = to_unit<ITEMP_ONE_HUNDRETH_DEGREE_C,
+                                -ITEMP_MIN_CELSIUS_100, 10>;
+using to_celsius_100_t = to_unit<ITEMP_ONE_HUNDRETH_DEGREE_C,
+                                 -ITEMP_MIN_CELSIUS_100, 1>;
+
+}  // namespace detail
+
+// =============================================================================
+// evaluation
+
+/**
+ * Evaluate e in a single pass, storing e.size() values at out.  Each value is
+ * clamped to the range of T.
+ */
+template <class E, class T>
+void evaluate(const expression<E> &e, T *out) {
+  const E &x = e.self();
+  size_t n = x.size();
+  for (size_t i = 0; i < n; i++) {
+    out[i] = detail::store<T>(x[i]);
+  }
+}
+
+// =============================================================================
+// array
+
+/**
+ * @brief A resizable array of itemp values that takes part in expressions.
+ */
+class array : public expression<array> {
+ public:
+  array() = default;
+  explicit array(size_t n, itemp_t value = 0) : data_(n, value) {}
+  array(std::initializer_list<itemp_t> values) : data_(values) {}
+  array(const itemp_t *values, size_t n) : data_(values, values + n) {}
+
+  template <class E>
+  array(const expression<E> &e) : data_(e.size()) {
+    evaluate(e, data_.data());
+  }
+
+  template <class E>
+  array &operator=(const expression<E> &e) {
+    data_.resize(e.size());
+    evaluate(e, data_.data());
+    return *this;
+  }
+
+  template <class E>
+  array &operator+=(const expression<E> &e) {
+    return *this = *this + e;
+  }
+  template <class E>
+  array &operator-=(const expression<E> &e) {
+    return *this = *this - e;
+  }
+  array &operator+=(int32_t offset);
+  array &operator-=(int32_t offset);
+
+  size_t size() const { return data_.size(); }
+  int32_t operator[](size_t i) const { return data_[i]; }
+  itemp_t &operator[](size_t i) { return data_[i]; }
+  itemp_t *data() { return data_.data(); }
+  const itemp_t *data() const { return data_.data(); }
+  itemp_t *begin() { return data_.data(); }
+  itemp_t *end() { return data_.data() + data_.size(); }
+  const itemp_t *begin() const { return data_.data(); }
+  const itemp_t *end() const { return data_.data() + data_.size(); }
+
+ private:
+  std::vector<itemp_t> data_;
+};
+
+// =============================================================================
+// operators
+
+template <class L, class R>
+detail::binary<L, R, detail::plus> operator+(const expression<L> &l,
+                                             const expression<R> &r) {
+  return {l.self(), r.self()};
+}
+template <class L>
+detail::binary<L, detail::scalar, detail::plus> operator+(
+    const expression<L> &l, int32_t r) {
+  return {l.self(), detail::scalar(r)};
+}
+template <class R>
+detail::binary<detail::scalar, R, detail::plus> operator+(
+    int32_t l, const expression<R> &r) {
+  return {detail::scalar(l), r.self()};
+}
+
+template <class L, class R>
+detail::binary<L, R, detail::minus> operator-(const expression<L> &l,
+                                              const expression<R> &r) {
+  return {l.self(), r.self()};
+}
+template <class L>
+detail::binary<L, detail::scalar, detail::minus> operator-(
+    const expression<L> &l, int32_t r) {
+  return {l.self(), detail::scalar(r)};
+}
+template <class R>
+detail::binary<detail::scalar, R, detail::minus> operator-(
+    int32_t l, const expression<R> &r) {
+  return {detail::scalar(l), r.self()};
+}
+
+template <class L>
+detail::binary<L, detail::scalar, detail::multiplies> operator*(
+    const expression<L> &l, int32_t r) {
+  return {l.self(), detail::scalar(r)};
+}
+template <class R>
+detail::binary<detail::scalar, R, detail::multiplies> operator*(
+    int32_t l, const expression<R> &r) {
+  return {detail::scalar(l), r.self()};
+}
+
+/**
+ * Divide every element by divisor, rounding to nearest.
+ */
+template <class E>
+detail::quotient<E> operator/(const expression<E> &e, int32_t divisor) {
+  return {e.self(), divisor};
+}
+
+inline array &array::operator+=(int32_t offset) {
+  return *this = *this + offset;
+}
+
+inline array &array::operator-=(int32_t offset) {
+  return *this = *this - offset;
+}
+
+// =============================================================================
+// conversions
+
+/**
+ * Convert an itemp valued expression to degrees Fahrenheit.  Values outside
+ * the itemp range are clamped first.
+ */
+template <class E>
+detail::converted<E, detail::to_fahrenheit_1_t> to_fahrenheit_1(
+    const expression<E> &e) {
+  return detail::converted<E, detail::to_fahrenheit_1_t>(e.self());
+}
+template <class E>
+detail::converted<E, detail::to_fahrenheit_10_t> to_fahrenheit_10(
+    const expression<E> &e) {
+  return detail::converted<E, detail::to_fahrenheit_10_t>(e.self());
+}
+template <class E>
+detail::converted<E, detail::to_fahrenheit_100_t> to_fahrenheit_100(
+    const expression<E> &e) {
+  return detail::converted<E, detail::to_fahrenheit_100_t>(e.self());
+}
+template <class E>
+detail::converted<E, detail::to_celsius_1_t> to_celsius_1(
+    const expression<E> &e) {
+  return detail::converted<E, detail::to_celsius_1_t>(e.self());
+}
+template <class E>
+detail::converted<E, detail::to_celsius_10_t> to_celsius_10(
+    const expression<E> &e) {
+  return detail::converted<E, detail::to_celsius_10_t>(e.self());
+}
+template <class E>
+detail::converted<E, detail::to_celsius_100_t> to_celsius_100(
+    const expression<E> &e) {
+  return detail::converted<E, detail::to_celsius_100_t>(e.self());
+}
+
+}  // namespace itemp
+
+#endif /* #ifndef _ITEMP_ARRAY_HPP_ */
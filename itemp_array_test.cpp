@@ -0,0 +1,124 @@
+/** @file itemp_array_test.cpp
+ * Unit tests for itemp_array.hpp.
+ *
+ * To run tests on a unix-like system:
+ *   cc -Wall -c itemp.c
+ *   c++ -std=c++17 -Wall -o itemp_array_test itemp_array_test.cpp itemp.o && \
+ *       ./itemp_array_test
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp_array.hpp"
+#include "itemp_unit_test.h"
+#include <vector>
+
+// =============================================================================
+// self test
+
+static int32_t reference_rquo(int32_t x, int32_t y) {
+  if ((x ^ y) >= 0) {
+    return (x + y / 2) / y;
+  } else {
+    return (x - y / 2) / y;
+  }
+}
+
+int main() {
+  printf("Beginning unit tests...");
+
+  itemp::array a = {fahrenheit_1_to_itemp(70), fahrenheit_1_to_itemp(60)};
+  itemp::array b = {fahrenheit_1_to_itemp(72), fahrenheit_1_to_itemp(61)};
+  itemp::array c = {fahrenheit_1_to_itemp(74), fahrenheit_1_to_itemp(62)};
+
+  // sums do not wrap, division rounds to nearest
+  itemp::array avg = (a + b + c) / 3;
+  ASSERT_INT(avg.size(), 2);
+  ASSERT_INT(itemp_to_fahrenheit_100(avg[0]), 7200);
+  ASSERT_INT(itemp_to_fahrenheit_100(avg[1]), 6100);
+
+  itemp::array mid = (a + b) / 2;
+  ASSERT_INT(mid[1], (a[1] + b[1] + 1) / 2);
+
+  // offsets in ITEMP_ONE_xxx units
+  avg += 2 * ITEMP_ONE_DEGREE_F;
+  ASSERT_INT(itemp_to_fahrenheit_100(avg[0]), 7400);
+  avg -= 10 * ITEMP_ONE_HUNDRETH_DEGREE_C;
+  ASSERT_INT(itemp_to_fahrenheit_100(avg[0]), 7382);
+  avg += a - b;
+  ASSERT_INT(itemp_to_fahrenheit_100(avg[0]), 7182);
+
+  // results are clamped to the itemp range rather than wrapping
+  itemp::array low = a - 100 * ITEMP_ONE_DEGREE_F;
+  ASSERT_INT(low[0], 0);
+  itemp::array high = 3 * a;
+  ASSERT_INT(high[0], UINT16_MAX);
+
+  // conversions fuse into the same loop
+  std::vector<int16_t> out(a.size());
+  itemp::evaluate(itemp::to_fahrenheit_10((a + c) / 2), out.data());
+  ASSERT_INT(out[0], 720);
+  ASSERT_INT(out[1], 610);
+  itemp::evaluate(itemp::to_celsius_100(a - ITEMP_ONE_DEGREE_C), out.data());
+  ASSERT_INT(out[0], itemp_to_celsius_100(a[0]) - 100);
+
+  // the conversions match itemp.c for every itemp
+  itemp::array all(65536);
+  for (size_t i = 0; i < all.size(); i++) {
+    all[i] = (itemp_t)i;
+  }
+  std::vector<int16_t> f1(all.size()), c10(all.size()), c100(all.size());
+  itemp::evaluate(itemp::to_fahrenheit_1(all), f1.data());
+  itemp::evaluate(itemp::to_celsius_10(all), c10.data());
+  itemp::evaluate(itemp::to_celsius_100(all), c100.data());
+  int mismatches = 0;
+  for (size_t i = 0; i < all.size(); i++) {
+    mismatches += (f1[i] != itemp_to_fahrenheit_1(i));
+    mismatches += (c10[i] != itemp_to_celsius_10(i));
+    mismatches += (c100[i] != itemp_to_celsius_100(i));
+  }
+  ASSERT_INT(mismatches, 0);
+
+  // division by a run time divisor matches rquo()
+  const int32_t divisors[] = {1, 2, 3, 5, 7, 10, 100, 1000, 65535, -3, -8};
+  std::vector<int32_t> dividends(200001);
+  std::vector<int32_t> quotients(dividends.size());
+  mismatches = 0;
+  for (size_t i = 0; i < dividends.size(); i++) {
+    dividends[i] = (int32_t)i * 5 - 500000;
+  }
+  for (int32_t divisor : divisors) {
+    itemp::detail::divider divide(divisor);
+    for (int32_t x : dividends) {
+      mismatches += (divide(x) != reference_rquo(x, divisor));
+    }
+    mismatches += (divide((1 << 30) - 1) != reference_rquo((1 << 30) - 1,
+                                                           divisor));
+  }
+  ASSERT_INT(mismatches, 0);
+
+  printf("\r\n...unit tests complete.\r\n");
+}
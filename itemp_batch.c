@@ -0,0 +1,927 @@
+/** @file itemp_batch.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp_batch.h"
+#include "itemp_counters.h"
+#include "itemp_trace.h"
+#include <string.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// =============================================================================
+// local types and definitions
+
+// The same linear map as itemp.c, expressed with the public constants.
+#define F_100_OFFSET (-ITEMP_MIN_FAHRENHEIT_100)
+#define C_100_OFFSET (-ITEMP_MIN_CELSIUS_100)
+#define F_100_SLOPE ITEMP_ONE_HUNDRETH_DEGREE_F
+#define C_100_SLOPE ITEMP_ONE_HUNDRETH_DEGREE_C
+
+#define ITEMP_MAX 65535
+
+// The number of values itemp_convert_strided() gathers into a dense buffer at
+// a time.  Two such buffers live on the stack.
+#define STRIDED_CHUNK 256
+
+// Counts taken as the loops run are kept in 16 bit lanes, which vectorize
+// well, and a block of this many values cannot overflow them.
+#define COUNT_BLOCK UINT16_MAX
+
+/**
+ * @brief The inputs a conversion to itemp takes without wrapping around.
+ */
+typedef struct {
+  int16_t min;
+  int16_t max;
+} range_t;
+
+// =============================================================================
+// local (forward) declarations
+
+/**
+ * @brief Return rquo(itemp, slope) - offset.
+ *
+ * itemp is never negative, so the rounding needs no test on the sign.
+ */
+static inline int16_t to_100(itemp_t itemp, uint32_t slope, int32_t offset);
+
+/**
+ * @brief Branch free rquo(x, y) for y > 0, which vectorizes as a select.
+ */
+static inline int16_t rquo_16(int16_t x, int16_t y);
+
+/**
+ * @brief Return (value_100 + offset) * slope, truncated to an itemp.
+ */
+static inline itemp_t from_100(int16_t value_100, int32_t offset,
+                               int32_t slope);
+
+/**
+ * @brief The loop of the conversions to itemp: itemps[i] =
+ * from_100(values[i] * scale).  values and itemps may be the same buffer.
+ * @returns The number of values outside min..max, counted as they are read.
+ * A caller that ignores it does not pay for it.
+ */
+static inline uint64_t from_values(const int16_t *values, itemp_t *itemps,
+                                   size_t n, int16_t scale, int32_t offset,
+                                   int32_t slope, int16_t min, int16_t max);
+
+/**
+ * @brief A batch conversion to itemp, counted and traced.
+ */
+static inline void to_itemp_batch(itemp_conversion_t conversion,
+                                  const int16_t *values, itemp_t *itemps,
+                                  size_t n, int16_t scale, int32_t offset,
+                                  int32_t slope,
+                                  itemp_trace_backend_t backend);
+
+/**
+ * @brief The loop of the conversions from itemp: values[i] =
+ * rquo(to_100(itemps[i]), divisor).  itemps and values may be the same
+ * buffer.
+ */
+static inline void to_values(const itemp_t *itemps, int16_t *values, size_t n,
+                             uint32_t slope, int32_t offset, int16_t divisor);
+
+/**
+ * @brief Copy n 16 bit values at a byte stride into a dense buffer.
+ */
+static void gather_16(const uint8_t *src, size_t stride, uint16_t *dst,
+                      size_t n);
+
+/**
+ * @brief Copy n 16 bit values from a dense buffer out to a byte stride.
+ */
+static void scatter_16(const uint16_t *src, uint8_t *dst, size_t stride,
+                       size_t n);
+
+/**
+ * @brief Count and trace the start of a batch.
+ */
+static inline void begin_batch(itemp_conversion_t conversion, size_t n,
+                               itemp_trace_backend_t backend);
+
+/**
+ * @brief Convert one chunk of itemp_convert_strided(), values first to
+ * first + n - 1 of its batch, counting and tracing the inputs that wrap
+ * around but not the chunk itself.
+ */
+static void convert_chunk(itemp_conversion_t conversion, const uint16_t *src,
+                          uint16_t *dst, size_t first, size_t n);
+
+/**
+ * @brief Count and trace the inputs outside min..max, which wrap around, of
+ * values first to first + n - 1 of a batch.  Call this before converting in
+ * place.  The loops count as they convert, so this is for the chunks of
+ * itemp_convert_strided() and for installed backends.
+ */
+static inline void check_range_at(itemp_conversion_t conversion,
+                                  const int16_t *values, size_t first,
+                                  size_t n, int16_t min, int16_t max);
+
+/**
+ * @brief Trace the end of a batch.
+ */
+static inline void end_batch(itemp_conversion_t conversion, size_t n);
+
+/**
+ * @brief Return how itemp_convert_strided() gathers values at a stride.
+ */
+static inline itemp_trace_backend_t strided_backend(size_t stride);
+
+
+// =============================================================================
+// local storage
+
+static itemp_batch_fn_t s_backends[ITEMP_CONVERSION_COUNT];
+
+// The conversions from itemp have no range to check, and are left {0, 0}.
+static const range_t s_ranges[ITEMP_CONVERSION_COUNT] = {
+    [FAHRENHEIT_1_TO_ITEMP] = {ITEMP_MIN_FAHRENHEIT_100 / 100,
+                               ITEMP_MAX_FAHRENHEIT_100 / 100},
+    [FAHRENHEIT_10_TO_ITEMP] = {ITEMP_MIN_FAHRENHEIT_100 / 10,
+                                ITEMP_MAX_FAHRENHEIT_100 / 10},
+    [FAHRENHEIT_100_TO_ITEMP] = {ITEMP_MIN_FAHRENHEIT_100,
+                                 ITEMP_MAX_FAHRENHEIT_100},
+    [CELSIUS_1_TO_ITEMP] = {ITEMP_MIN_CELSIUS_100 / 100,
+                            ITEMP_MAX_CELSIUS_100 / 100},
+    [CELSIUS_10_TO_ITEMP] = {ITEMP_MIN_CELSIUS_100 / 10,
+                             ITEMP_MAX_CELSIUS_100 / 10},
+    [CELSIUS_100_TO_ITEMP] = {ITEMP_MIN_CELSIUS_100, ITEMP_MAX_CELSIUS_100},
+};
+
+// =============================================================================
+// public code
+
+void fahrenheit_1_to_itemp_batch(const int16_t *fahrenheit_1, itemp_t *itemps,
+                                 size_t n) {
+  to_itemp_batch(FAHRENHEIT_1_TO_ITEMP, fahrenheit_1, itemps, n, 100,
+                 F_100_OFFSET, F_100_SLOPE, ITEMP_TRACE_LOOP);
+}
+
+void fahrenheit_10_to_itemp_batch(const int16_t *fahrenheit_10,
+                                  itemp_t *itemps, size_t n) {
+  to_itemp_batch(FAHRENHEIT_10_TO_ITEMP, fahrenheit_10, itemps, n, 10,
+                 F_100_OFFSET, F_100_SLOPE, ITEMP_TRACE_LOOP);
+}
+
+void fahrenheit_100_to_itemp_batch(const int16_t *fahrenheit_100,
+                                   itemp_t *itemps, size_t n) {
+  to_itemp_batch(FAHRENHEIT_100_TO_ITEMP, fahrenheit_100, itemps, n, 1,
+                 F_100_OFFSET, F_100_SLOPE, ITEMP_TRACE_LOOP);
+}
+
+void itemp_to_fahrenheit_1_batch(const itemp_t *itemps, int16_t *fahrenheit_1,
+                                 size_t n) {
+  begin_batch(ITEMP_TO_FAHRENHEIT_1, n, ITEMP_TRACE_LOOP);
+  to_values(itemps, fahrenheit_1, n, F_100_SLOPE, F_100_OFFSET, 100);
+  end_batch(ITEMP_TO_FAHRENHEIT_1, n);
+}
+
+void itemp_to_fahrenheit_10_batch(const itemp_t *itemps,
+                                  int16_t *fahrenheit_10, size_t n) {
+  begin_batch(ITEMP_TO_FAHRENHEIT_10, n, ITEMP_TRACE_LOOP);
+  to_values(itemps, fahrenheit_10, n, F_100_SLOPE, F_100_OFFSET, 10);
+  end_batch(ITEMP_TO_FAHRENHEIT_10, n);
+}
+
+void itemp_to_fahrenheit_100_batch(const itemp_t *itemps,
+                                   int16_t *fahrenheit_100, size_t n) {
+  begin_batch(ITEMP_TO_FAHRENHEIT_100, n, ITEMP_TRACE_LOOP);
+  to_values(itemps, fahrenheit_100, n, F_100_SLOPE, F_100_OFFSET, 1);
+  end_batch(ITEMP_TO_FAHRENHEIT_100, n);
+}
+
+// celsius
+
+void celsius_1_to_itemp_batch(const int16_t *celsius_1, itemp_t *itemps,
+                              size_t n) {
+  to_itemp_batch(CELSIUS_1_TO_ITEMP, celsius_1, itemps, n, 100, C_100_OFFSET,
+                 C_100_SLOPE, ITEMP_TRACE_LOOP);
+}
+
+void celsius_10_to_itemp_batch(const int16_t *celsius_10, itemp_t *itemps,
+                               size_t n) {
+  to_itemp_batch(CELSIUS_10_TO_ITEMP, celsius_10, itemps, n, 10, C_100_OFFSET,
+                 C_100_SLOPE, ITEMP_TRACE_LOOP);
+}
+
+void celsius_100_to_itemp_batch(const int16_t *celsius_100, itemp_t *itemps,
+                                size_t n) {
+  to_itemp_batch(CELSIUS_100_TO_ITEMP, celsius_100, itemps, n, 1, C_100_OFFSET,
+                 C_100_SLOPE, ITEMP_TRACE_LOOP);
+}
+
+void itemp_to_celsius_1_batch(const itemp_t *itemps, int16_t *celsius_1,
+                              size_t n) {
+  begin_batch(ITEMP_TO_CELSIUS_1, n, ITEMP_TRACE_LOOP);
+  to_values(itemps, celsius_1, n, C_100_SLOPE, C_100_OFFSET, 100);
+  end_batch(ITEMP_TO_CELSIUS_1, n);
+}
+
+void itemp_to_celsius_10_batch(const itemp_t *itemps, int16_t *celsius_10,
+                               size_t n) {
+  begin_batch(ITEMP_TO_CELSIUS_10, n, ITEMP_TRACE_LOOP);
+  to_values(itemps, celsius_10, n, C_100_SLOPE, C_100_OFFSET, 10);
+  end_batch(ITEMP_TO_CELSIUS_10, n);
+}
+
+void itemp_to_celsius_100_batch(const itemp_t *itemps, int16_t *celsius_100,
+                                size_t n) {
+  begin_batch(ITEMP_TO_CELSIUS_100, n, ITEMP_TRACE_LOOP);
+  to_values(itemps, celsius_100, n, C_100_SLOPE, C_100_OFFSET, 1);
+  end_batch(ITEMP_TO_CELSIUS_100, n);
+}
+
+// in place.  itemp_t and int16_t are the unsigned and signed forms of the same
+// type, so they may alias, and each value is read before it is overwritten.
+
+itemp_t *fahrenheit_100_to_itemp_inplace(int16_t *buf, size_t n) {
+  itemp_t *itemps = (itemp_t *)buf;
+  to_itemp_batch(FAHRENHEIT_100_TO_ITEMP, buf, itemps, n, 1, F_100_OFFSET,
+                 F_100_SLOPE, ITEMP_TRACE_IN_PLACE);
+  return itemps;
+}
+
+itemp_t *celsius_100_to_itemp_inplace(int16_t *buf, size_t n) {
+  itemp_t *itemps = (itemp_t *)buf;
+  to_itemp_batch(CELSIUS_100_TO_ITEMP, buf, itemps, n, 1, C_100_OFFSET,
+                 C_100_SLOPE, ITEMP_TRACE_IN_PLACE);
+  return itemps;
+}
+
+int16_t *itemp_to_fahrenheit_100_inplace(itemp_t *buf, size_t n) {
+  begin_batch(ITEMP_TO_FAHRENHEIT_100, n, ITEMP_TRACE_IN_PLACE);
+  int16_t *values = (int16_t *)buf;
+  to_values(buf, values, n, F_100_SLOPE, F_100_OFFSET, 1);
+  end_batch(ITEMP_TO_FAHRENHEIT_100, n);
+  return values;
+}
+
+int16_t *itemp_to_celsius_100_inplace(itemp_t *buf, size_t n) {
+  begin_batch(ITEMP_TO_CELSIUS_100, n, ITEMP_TRACE_IN_PLACE);
+  int16_t *values = (int16_t *)buf;
+  to_values(buf, values, n, C_100_SLOPE, C_100_OFFSET, 1);
+  end_batch(ITEMP_TO_CELSIUS_100, n);
+  return values;
+}
+
+// deltas
+
+void itemp_add_delta_batch(const itemp_t *itemps, itemp_delta_t delta,
+                           itemp_t *out, size_t n) {
+  uint64_t saturated = 0;
+  // With the delta clamped to 16 bits, these are unsigned saturating adds and
+  // subtracts, which have their own vector instructions.
+  if (delta >= 0) {
+    itemp_t d = (delta > ITEMP_MAX) ? ITEMP_MAX : (itemp_t)delta;
+    for (size_t start = 0; start < n; start += COUNT_BLOCK) {
+      size_t end = (n - start < COUNT_BLOCK) ? n : start + COUNT_BLOCK;
+      uint16_t block = 0;
+      for (size_t i = start; i < end; i++) {
+        itemp_t sum = itemps[i] + d;
+        block += sum < d;
+        out[i] = (sum < d) ? ITEMP_MAX : sum;
+      }
+      saturated += block;
+    }
+  } else {
+    itemp_t d = (delta < -ITEMP_MAX) ? ITEMP_MAX : (itemp_t)-delta;
+    for (size_t start = 0; start < n; start += COUNT_BLOCK) {
+      size_t end = (n - start < COUNT_BLOCK) ? n : start + COUNT_BLOCK;
+      uint16_t block = 0;
+      for (size_t i = start; i < end; i++) {
+        block += itemps[i] < d;
+        out[i] = (itemps[i] > d) ? itemps[i] - d : 0;
+      }
+      saturated += block;
+    }
+  }
+  ITEMP_COUNT_DELTAS(n, saturated);
+}
+
+void itemp_sub_delta_batch(const itemp_t *itemps, itemp_delta_t delta,
+                           itemp_t *out, size_t n) {
+  delta = (delta < -ITEMP_MAX) ? -ITEMP_MAX : delta;
+  itemp_add_delta_batch(itemps, -delta, out, n);
+}
+
+void itemp_add_deltas_batch(const itemp_t *itemps, const itemp_delta_t *deltas,
+                            itemp_t *out, size_t n) {
+  uint64_t saturated = 0;
+  for (size_t start = 0; start < n; start += COUNT_BLOCK) {
+    size_t end = (n - start < COUNT_BLOCK) ? n : start + COUNT_BLOCK;
+    uint16_t block = 0;
+    for (size_t i = start; i < end; i++) {
+      int32_t d = deltas[i];
+      d = (d < -ITEMP_MAX) ? -ITEMP_MAX : (d > ITEMP_MAX) ? ITEMP_MAX : d;
+      int32_t sum = itemps[i] + d;
+      block += (sum < 0) | (sum > ITEMP_MAX);
+      out[i] = (sum < 0) ? 0 : (sum > ITEMP_MAX) ? ITEMP_MAX : sum;
+    }
+    saturated += block;
+  }
+  ITEMP_COUNT_DELTAS(n, saturated);
+}
+
+void itemp_difference_batch(const itemp_t *a, const itemp_t *b,
+                            itemp_delta_t *deltas, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    deltas[i] = (itemp_delta_t)a[i] - (itemp_delta_t)b[i];
+  }
+}
+
+void itemp_convert_batch(itemp_conversion_t conversion, const void *src,
+                         void *dst, size_t n) {
+  if ((unsigned)conversion < ITEMP_CONVERSION_COUNT &&
+      s_backends[conversion] != NULL) {
+    begin_batch(conversion, n, ITEMP_TRACE_INSTALLED);
+    if (conversion >= FAHRENHEIT_1_TO_ITEMP) {
+      check_range_at(conversion, src, 0, n, s_ranges[conversion].min,
+                     s_ranges[conversion].max);
+    }
+    s_backends[conversion](src, dst, n);
+    end_batch(conversion, n);
+    return;
+  }
+  switch (conversion) {
+  case ITEMP_TO_FAHRENHEIT_1:
+    itemp_to_fahrenheit_1_batch(src, dst, n);
+    break;
+  case ITEMP_TO_FAHRENHEIT_10:
+    itemp_to_fahrenheit_10_batch(src, dst, n);
+    break;
+  case ITEMP_TO_FAHRENHEIT_100:
+    itemp_to_fahrenheit_100_batch(src, dst, n);
+    break;
+  case ITEMP_TO_CELSIUS_1:
+    itemp_to_celsius_1_batch(src, dst, n);
+    break;
+  case ITEMP_TO_CELSIUS_10:
+    itemp_to_celsius_10_batch(src, dst, n);
+    break;
+  case ITEMP_TO_CELSIUS_100:
+    itemp_to_celsius_100_batch(src, dst, n);
+    break;
+  case FAHRENHEIT_1_TO_ITEMP:
+    fahrenheit_1_to_itemp_batch(src, dst, n);
+    break;
+  case FAHRENHEIT_10_TO_ITEMP:
+    fahrenheit_10_to_itemp_batch(src, dst, n);
+    break;
+  case FAHRENHEIT_100_TO_ITEMP:
+    fahrenheit_100_to_itemp_batch(src, dst, n);
+    break;
+  case CELSIUS_1_TO_ITEMP:
+    celsius_1_to_itemp_batch(src, dst, n);
+    break;
+  case CELSIUS_10_TO_ITEMP:
+    celsius_10_to_itemp_batch(src, dst, n);
+    break;
+  case CELSIUS_100_TO_ITEMP:
+    celsius_100_to_itemp_batch(src, dst, n);
+    break;
+  default:
+    break;
+  }
+}
+
+void itemp_convert_strided(itemp_conversion_t conversion, const void *src,
+                           size_t src_stride, void *dst, size_t dst_stride,
+                           size_t n) {
+  const uint8_t *s = src;
+  uint8_t *d = dst;
+  uint16_t in[STRIDED_CHUNK];
+  uint16_t out[STRIDED_CHUNK];
+
+  if (src_stride == sizeof(uint16_t) && dst_stride == sizeof(uint16_t) &&
+      ((uintptr_t)src | (uintptr_t)dst) % sizeof(uint16_t) == 0) {
+    // already dense and aligned
+    itemp_convert_batch(conversion, src, dst, n);
+    return;
+  }
+  // one batch, however many chunks it takes
+  begin_batch(conversion, n, strided_backend(src_stride));
+  for (size_t done = 0; done < n;) {
+    size_t chunk = (n - done < STRIDED_CHUNK) ? n - done : STRIDED_CHUNK;
+    gather_16(s, src_stride, in, chunk);
+    convert_chunk(conversion, in, out, done, chunk);
+    scatter_16(out, d, dst_stride, chunk);
+    s += chunk * src_stride;
+    d += chunk * dst_stride;
+    done += chunk;
+  }
+  end_batch(conversion, n);
+}
+
+void itemp_convert_loop(itemp_conversion_t conversion, const void *src,
+                        void *dst, size_t n) {
+  // With the whole of int16_t as the range, from_values() counts nothing.
+  switch (conversion) {
+  case ITEMP_TO_FAHRENHEIT_1:
+    to_values(src, dst, n, F_100_SLOPE, F_100_OFFSET, 100);
+    break;
+  case ITEMP_TO_FAHRENHEIT_10:
+    to_values(src, dst, n, F_100_SLOPE, F_100_OFFSET, 10);
+    break;
+  case ITEMP_TO_FAHRENHEIT_100:
+    to_values(src, dst, n, F_100_SLOPE, F_100_OFFSET, 1);
+    break;
+  case ITEMP_TO_CELSIUS_1:
+    to_values(src, dst, n, C_100_SLOPE, C_100_OFFSET, 100);
+    break;
+  case ITEMP_TO_CELSIUS_10:
+    to_values(src, dst, n, C_100_SLOPE, C_100_OFFSET, 10);
+    break;
+  case ITEMP_TO_CELSIUS_100:
+    to_values(src, dst, n, C_100_SLOPE, C_100_OFFSET, 1);
+    break;
+  case FAHRENHEIT_1_TO_ITEMP:
+    (void)from_values(src, dst, n, 100, F_100_OFFSET, F_100_SLOPE, INT16_MIN,
+                      INT16_MAX);
+    break;
+  case FAHRENHEIT_10_TO_ITEMP:
+    (void)from_values(src, dst, n, 10, F_100_OFFSET, F_100_SLOPE, INT16_MIN,
+                      INT16_MAX);
+    break;
+  case FAHRENHEIT_100_TO_ITEMP:
+    (void)from_values(src, dst, n, 1, F_100_OFFSET, F_100_SLOPE, INT16_MIN,
+                      INT16_MAX);
+    break;
+  case CELSIUS_1_TO_ITEMP:
+    (void)from_values(src, dst, n, 100, C_100_OFFSET, C_100_SLOPE, INT16_MIN,
+                      INT16_MAX);
+    break;
+  case CELSIUS_10_TO_ITEMP:
+    (void)from_values(src, dst, n, 10, C_100_OFFSET, C_100_SLOPE, INT16_MIN,
+                      INT16_MAX);
+    break;
+  case CELSIUS_100_TO_ITEMP:
+    (void)from_values(src, dst, n, 1, C_100_OFFSET, C_100_SLOPE, INT16_MIN,
+                      INT16_MAX);
+    break;
+  default:
+    break;
+  }
+}
+
+void itemp_set_batch_backend(itemp_conversion_t conversion,
+                             itemp_batch_fn_t fn) {
+  if ((unsigned)conversion < ITEMP_CONVERSION_COUNT) {
+    s_backends[conversion] = fn;
+  }
+}
+
+// =============================================================================
+// local (static) code
+
+static inline int16_t to_100(itemp_t itemp, uint32_t slope, int32_t offset) {
+  return (int16_t)((int32_t)(((uint32_t)itemp + slope / 2) / slope) - offset);
+}
+
+static inline int16_t rquo_16(int16_t x, int16_t y) {
+  int16_t half = (x < 0) ? -(y / 2) : (y / 2);
+  return (int16_t)((x + half) / y);
+}
+
+static inline itemp_t from_100(int16_t value_100, int32_t offset,
+                               int32_t slope) {
+  return (itemp_t)((value_100 + offset) * slope);
+}
+
+static inline uint64_t from_values(const int16_t *values, itemp_t *itemps,
+                                   size_t n, int16_t scale, int32_t offset,
+                                   int32_t slope, int16_t min, int16_t max) {
+  // One unsigned compare tests both ends.  Counting the values in range
+  // saves SSE2, which only has an equality test on unsigned lanes, an
+  // instruction.
+  const uint16_t range = (uint16_t)(max - min);
+  uint64_t wrapped = 0;
+  for (size_t start = 0; start < n; start += COUNT_BLOCK) {
+    size_t end = (n - start < COUNT_BLOCK) ? n : start + COUNT_BLOCK;
+    uint16_t in_range = 0;
+    for (size_t i = start; i < end; i++) {
+      int16_t value = values[i];
+      in_range += (uint16_t)(value - min) <= range;
+      itemps[i] = from_100(value * scale, offset, slope);
+    }
+    wrapped += (end - start) - in_range;
+  }
+  return wrapped;
+}
+
+static inline void to_itemp_batch(itemp_conversion_t conversion,
+                                  const int16_t *values, itemp_t *itemps,
+                                  size_t n, int16_t scale, int32_t offset,
+                                  int32_t slope,
+                                  itemp_trace_backend_t backend) {
+  const range_t range = s_ranges[conversion];
+  begin_batch(conversion, n, backend);
+  ITEMP_TRACE_OUT_OF_RANGE_BATCH(conversion, values, 0, n, range.min,
+                                 range.max);
+  uint64_t wrapped = from_values(values, itemps, n, scale, offset, slope,
+                                 range.min, range.max);
+  ITEMP_COUNT_OUT_OF_RANGE(conversion, wrapped);
+  end_batch(conversion, n);
+}
+
+static inline void to_values(const itemp_t *itemps, int16_t *values, size_t n,
+                             uint32_t slope, int32_t offset, int16_t divisor) {
+  for (size_t i = 0; i < n; i++) {
+    values[i] = rquo_16(to_100(itemps[i], slope, offset), divisor);
+  }
+}
+
+// Constant strides let the compiler turn these loops into shuffles, so the
+// common record sizes get their own instances.
+
+static inline void gather_16_fixed(const uint8_t *src, size_t stride,
+                                   uint16_t *dst, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    memcpy(&dst[i], src + i * stride, sizeof(uint16_t));
+  }
+}
+
+static inline void scatter_16_fixed(const uint16_t *src, uint8_t *dst,
+                                    size_t stride, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    memcpy(dst + i * stride, &src[i], sizeof(uint16_t));
+  }
+}
+
+static void gather_16(const uint8_t *src, size_t stride, uint16_t *dst,
+                      size_t n) {
+  size_t i = 0;
+
+  switch (stride) {
+  case 2:
+    memcpy(dst, src, n * sizeof(uint16_t));
+    return;
+  case 4:
+    gather_16_fixed(src, 4, dst, n);
+    return;
+  case 8:
+    gather_16_fixed(src, 8, dst, n);
+    return;
+  case 16:
+    gather_16_fixed(src, 16, dst, n);
+    return;
+  default:
+    break;
+  }
+
+#ifdef __AVX2__
+  // Each lane loads 32 bits and keeps the low 16.  The two extra bytes lie in
+  // the following record, so the last value is always left to the scalar
+  // loop lest it read past the end of the caller's array.
+  if (stride <= INT32_MAX / 8) {
+    const __m256i offsets = _mm256_mullo_epi32(
+        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+        _mm256_set1_epi32((int32_t)stride));
+    const __m256i low_16 = _mm256_set1_epi32(0xffff);
+    for (; i + 8 < n; i += 8) {
+      __m256i v = _mm256_i32gather_epi32((const int *)(src + i * stride),
+                                         offsets, 1);
+      v = _mm256_and_si256(v, low_16);
+      __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(v),
+                                        _mm256_extracti128_si256(v, 1));
+      _mm_storeu_si128((__m128i *)&dst[i], packed);
+    }
+  }
+#endif
+
+  gather_16_fixed(src + i * stride, stride, dst + i, n - i);
+}
+
+static void scatter_16(const uint16_t *src, uint8_t *dst, size_t stride,
+                       size_t n) {
+  // There is no 16 bit scatter instruction, even in AVX-512, and a 32 bit
+  // scatter would clobber the neighbouring field.
+  switch (stride) {
+  case 2:
+    memcpy(dst, src, n * sizeof(uint16_t));
+    break;
+  case 4:
+    scatter_16_fixed(src, dst, 4, n);
+    break;
+  case 8:
+    scatter_16_fixed(src, dst, 8, n);
+    break;
+  case 16:
+    scatter_16_fixed(src, dst, 16, n);
+    break;
+  default:
+    scatter_16_fixed(src, dst, stride, n);
+    break;
+  }
+}
+
+static inline void begin_batch(itemp_conversion_t conversion, size_t n,
+                               itemp_trace_backend_t backend) {
+  ITEMP_COUNT_BATCH(conversion, n);
+  ITEMP_TRACE_BATCH_ENTRY(conversion, n, backend);
+}
+
+static inline void check_range_at(itemp_conversion_t conversion,
+                                  const int16_t *values, size_t first,
+                                  size_t n, int16_t min, int16_t max) {
+  ITEMP_COUNT_OUT_OF_RANGE_BATCH(conversion, values, n, min, max);
+  ITEMP_TRACE_OUT_OF_RANGE_BATCH(conversion, values, first, n, min, max);
+}
+
+static void convert_chunk(itemp_conversion_t conversion, const uint16_t *src,
+                          uint16_t *dst, size_t first, size_t n) {
+  if (conversion >= FAHRENHEIT_1_TO_ITEMP &&
+      conversion < ITEMP_CONVERSION_COUNT) {
+    check_range_at(conversion, (const int16_t *)src, first, n,
+                   s_ranges[conversion].min, s_ranges[conversion].max);
+  }
+  if ((unsigned)conversion < ITEMP_CONVERSION_COUNT &&
+      s_backends[conversion] != NULL) {
+    s_backends[conversion](src, dst, n);
+  } else {
+    itemp_convert_loop(conversion, src, dst, n);
+  }
+}
+
+static inline void end_batch(itemp_conversion_t conversion, size_t n) {
+  ITEMP_TRACE_BATCH_EXIT(conversion, n);
+}
+
+static inline itemp_trace_backend_t strided_backend(size_t stride) {
+  // the same choices as gather_16()
+  if (stride == 2 || stride == 4 || stride == 8 || stride == 16) {
+    return ITEMP_TRACE_GATHER_FIXED;
+  }
+#ifdef __AVX2__
+  if (stride <= INT32_MAX / 8) {
+    return ITEMP_TRACE_GATHER_AVX2;
+  }
+#endif
+  return ITEMP_TRACE_GATHER_SCALAR;
+}
+
+// =============================================================================
+// self test
+
+// To run tests on a unix-like system:
+//   cc -Wall -c itemp.c
+//   cc -Wall -DUNIT_TEST -o itemp_batch itemp_batch.c itemp.o && ./itemp_batch
+
+#ifdef UNIT_TEST
+
+#include "itemp_unit_test.h"
+
+#define N_ITEMPS 65536
+
+static itemp_t s_itemps[N_ITEMPS];
+static int16_t s_values[N_ITEMPS];
+static int16_t s_out_values[N_ITEMPS];
+static itemp_t s_out_itemps[N_ITEMPS];
+
+static int count_to_mismatches(void (*batch)(const itemp_t *, int16_t *,
+                                             size_t),
+                               int16_t (*scalar)(itemp_t)) {
+  int mismatches = 0;
+  batch(s_itemps, s_out_values, N_ITEMPS);
+  for (int i = 0; i < N_ITEMPS; i++) {
+    mismatches += (s_out_values[i] != scalar(s_itemps[i]));
+  }
+  return mismatches;
+}
+
+static int count_from_mismatches(void (*batch)(const int16_t *, itemp_t *,
+                                               size_t),
+                                 itemp_t (*scalar)(int16_t)) {
+  int mismatches = 0;
+  batch(s_values, s_out_itemps, N_ITEMPS);
+  for (int i = 0; i < N_ITEMPS; i++) {
+    mismatches += (s_out_itemps[i] != scalar(s_values[i]));
+  }
+  return mismatches;
+}
+
+// An interleaved record of the kind a foreign producer might hand us.
+typedef struct {
+  uint32_t sensor_id;
+  itemp_t itemp;
+  int16_t value;
+  uint8_t flags;
+} record_t;
+
+static record_t s_records[N_ITEMPS];
+
+/**
+ * @brief Convert every itemp at each stride from 2 to 40 bytes, starting at
+ * an odd address, and compare against the dense conversion.
+ */
+static int count_strided_mismatches(itemp_conversion_t conversion) {
+  static uint8_t buf[40 * 1000 + 1];
+  int mismatches = 0;
+  for (size_t stride = 2; stride <= 40; stride++) {
+    size_t n = (sizeof(buf) - 1) / stride;
+    for (size_t i = 0; i < n; i++) {
+      memcpy(buf + 1 + i * stride, &s_itemps[(i * 61) % N_ITEMPS], 2);
+    }
+    // in place: read and write the same field
+    itemp_convert_strided(conversion, buf + 1, stride, buf + 1, stride, n);
+    for (size_t i = 0; i < n; i++) {
+      uint16_t expected, observed;
+      itemp_convert_batch(conversion, &s_itemps[(i * 61) % N_ITEMPS],
+                          &expected, 1);
+      memcpy(&observed, buf + 1 + i * stride, 2);
+      mismatches += (observed != expected);
+    }
+  }
+  return mismatches;
+}
+
+int main() {
+  printf("Beginning unit tests...");
+
+  // every itemp, and every int16_t (including ones that wrap around)
+  for (int i = 0; i < N_ITEMPS; i++) {
+    s_itemps[i] = (itemp_t)i;
+    s_values[i] = (int16_t)(i - 32768);
+  }
+
+  ASSERT_INT(count_to_mismatches(itemp_to_fahrenheit_1_batch,
+                                 itemp_to_fahrenheit_1), 0);
+  ASSERT_INT(count_to_mismatches(itemp_to_fahrenheit_10_batch,
+                                 itemp_to_fahrenheit_10), 0);
+  ASSERT_INT(count_to_mismatches(itemp_to_fahrenheit_100_batch,
+                                 itemp_to_fahrenheit_100), 0);
+  ASSERT_INT(count_to_mismatches(itemp_to_celsius_1_batch,
+                                 itemp_to_celsius_1), 0);
+  ASSERT_INT(count_to_mismatches(itemp_to_celsius_10_batch,
+                                 itemp_to_celsius_10), 0);
+  ASSERT_INT(count_to_mismatches(itemp_to_celsius_100_batch,
+                                 itemp_to_celsius_100), 0);
+
+  ASSERT_INT(count_from_mismatches(fahrenheit_1_to_itemp_batch,
+                                   fahrenheit_1_to_itemp), 0);
+  ASSERT_INT(count_from_mismatches(fahrenheit_10_to_itemp_batch,
+                                   fahrenheit_10_to_itemp), 0);
+  ASSERT_INT(count_from_mismatches(fahrenheit_100_to_itemp_batch,
+                                   fahrenheit_100_to_itemp), 0);
+  ASSERT_INT(count_from_mismatches(celsius_1_to_itemp_batch,
+                                   celsius_1_to_itemp), 0);
+  ASSERT_INT(count_from_mismatches(celsius_10_to_itemp_batch,
+                                   celsius_10_to_itemp), 0);
+  ASSERT_INT(count_from_mismatches(celsius_100_to_itemp_batch,
+                                   celsius_100_to_itemp), 0);
+
+  // in place, over every value
+  {
+    int mismatches = 0;
+    memcpy(s_out_values, s_values, sizeof(s_values));
+    itemp_t *itemps = fahrenheit_100_to_itemp_inplace(s_out_values, N_ITEMPS);
+    for (int i = 0; i < N_ITEMPS; i++) {
+      mismatches += (itemps[i] != fahrenheit_100_to_itemp(s_values[i]));
+    }
+    memcpy(s_out_values, s_values, sizeof(s_values));
+    itemps = celsius_100_to_itemp_inplace(s_out_values, N_ITEMPS);
+    for (int i = 0; i < N_ITEMPS; i++) {
+      mismatches += (itemps[i] != celsius_100_to_itemp(s_values[i]));
+    }
+    memcpy(s_out_itemps, s_itemps, sizeof(s_itemps));
+    int16_t *values = itemp_to_fahrenheit_100_inplace(s_out_itemps, N_ITEMPS);
+    for (int i = 0; i < N_ITEMPS; i++) {
+      mismatches += (values[i] != itemp_to_fahrenheit_100(s_itemps[i]));
+    }
+    memcpy(s_out_itemps, s_itemps, sizeof(s_itemps));
+    values = itemp_to_celsius_100_inplace(s_out_itemps, N_ITEMPS);
+    for (int i = 0; i < N_ITEMPS; i++) {
+      mismatches += (values[i] != itemp_to_celsius_100(s_itemps[i]));
+    }
+    ASSERT_INT(mismatches, 0);
+  }
+
+  // saturating deltas, against the scalar function
+  {
+    static const itemp_delta_t deltas[] = {
+        0, 1, -1, 500, -500, 32767, -32768, 65535, -65535, 70000, -70000,
+        INT32_MAX, INT32_MIN};
+    static itemp_delta_t s_deltas[N_ITEMPS];
+    const size_t n_deltas = sizeof(deltas) / sizeof(deltas[0]);
+    int mismatches = 0;
+    for (size_t d = 0; d < n_deltas; d++) {
+      itemp_add_delta_batch(s_itemps, deltas[d], s_out_itemps, N_ITEMPS);
+      for (int i = 0; i < N_ITEMPS; i++) {
+        mismatches += (s_out_itemps[i] != itemp_add_delta(i, deltas[d]));
+      }
+      itemp_sub_delta_batch(s_itemps, deltas[d], s_out_itemps, N_ITEMPS);
+      for (int i = 0; i < N_ITEMPS; i++) {
+        itemp_delta_t negated = (deltas[d] == INT32_MIN) ? INT32_MAX
+                                                         : -deltas[d];
+        mismatches += (s_out_itemps[i] != itemp_add_delta(i, negated));
+      }
+    }
+    for (int i = 0; i < N_ITEMPS; i++) {
+      s_deltas[i] = deltas[i % n_deltas] / 2 + i;
+    }
+    itemp_add_deltas_batch(s_itemps, s_deltas, s_out_itemps, N_ITEMPS);
+    for (int i = 0; i < N_ITEMPS; i++) {
+      mismatches += (s_out_itemps[i] != itemp_add_delta(i, s_deltas[i]));
+    }
+    // in place
+    memcpy(s_out_itemps, s_itemps, sizeof(s_itemps));
+    itemp_add_delta_batch(s_out_itemps, -ITEMP_ONE_DEGREE_F, s_out_itemps,
+                          N_ITEMPS);
+    itemp_difference_batch(s_itemps, s_out_itemps, s_deltas, N_ITEMPS);
+    for (int i = 0; i < N_ITEMPS; i++) {
+      mismatches += (s_deltas[i] != ((i < ITEMP_ONE_DEGREE_F) ? i : 500));
+    }
+    ASSERT_INT(mismatches, 0);
+  }
+
+  // the run time choice matches the named functions
+  itemp_convert_batch(ITEMP_TO_CELSIUS_10, s_itemps, s_out_values, N_ITEMPS);
+  ASSERT_INT(s_out_values[12345], itemp_to_celsius_10(12345));
+  itemp_convert_batch(FAHRENHEIT_10_TO_ITEMP, s_values, s_out_itemps, N_ITEMPS);
+  ASSERT_INT(s_out_itemps[40000], fahrenheit_10_to_itemp(s_values[40000]));
+
+  // the uncounted loops give the same results
+  {
+    int mismatches = 0;
+    for (int c = 0; c < ITEMP_CONVERSION_COUNT; c++) {
+      itemp_convert_batch(c, s_itemps, s_out_values, N_ITEMPS);
+      itemp_convert_loop(c, s_itemps, s_out_itemps, N_ITEMPS);
+      mismatches += memcmp(s_out_values, s_out_itemps, sizeof(s_itemps)) != 0;
+    }
+    ASSERT_INT(mismatches, 0);
+  }
+
+  // array of structs, from one field to another
+  for (int i = 0; i < N_ITEMPS; i++) {
+    s_records[i].sensor_id = (uint32_t)i;
+    s_records[i].itemp = s_itemps[i];
+    s_records[i].value = 0;
+    s_records[i].flags = 0x5a;
+  }
+  itemp_convert_strided(ITEMP_TO_FAHRENHEIT_100, &s_records[0].itemp,
+                        sizeof(record_t), &s_records[0].value,
+                        sizeof(record_t), N_ITEMPS);
+  {
+    int mismatches = 0;
+    for (int i = 0; i < N_ITEMPS; i++) {
+      mismatches +=
+          (s_records[i].value != itemp_to_fahrenheit_100(s_itemps[i]));
+      mismatches += (s_records[i].itemp != s_itemps[i]);
+      mismatches += (s_records[i].sensor_id != (uint32_t)i);
+      mismatches += (s_records[i].flags != 0x5a);
+    }
+    ASSERT_INT(mismatches, 0);
+  }
+
+  // from a dense array out to a stride, and back
+  itemp_convert_strided(ITEMP_TO_CELSIUS_100, s_itemps, sizeof(itemp_t),
+                        &s_records[0].value, sizeof(record_t), N_ITEMPS);
+  itemp_convert_strided(CELSIUS_100_TO_ITEMP, &s_records[0].value,
+                        sizeof(record_t), s_out_itemps, sizeof(itemp_t),
+                        N_ITEMPS);
+  {
+    int mismatches = 0;
+    for (int i = 0; i < N_ITEMPS; i++) {
+      mismatches += (s_records[i].value != itemp_to_celsius_100(s_itemps[i]));
+      mismatches +=
+          (s_out_itemps[i] != celsius_100_to_itemp(s_records[i].value));
+    }
+    ASSERT_INT(mismatches, 0);
+  }
+
+  ASSERT_INT(count_strided_mismatches(ITEMP_TO_FAHRENHEIT_1), 0);
+  ASSERT_INT(count_strided_mismatches(ITEMP_TO_CELSIUS_100), 0);
+  ASSERT_INT(count_strided_mismatches(FAHRENHEIT_100_TO_ITEMP), 0);
+
+  printf("\r\n...unit tests complete.\r\n");
+}
+
+#endif
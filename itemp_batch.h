@@ -0,0 +1,250 @@
+/** @file itemp_batch.h
+ * Batch versions of the itemp conversions, converting whole arrays at a time.
+ * Each produces exactly the same values as calling the scalar function in
+ * itemp.h on every element, but is written so that the compiler can turn it into
+ * SIMD code (build with -O3, or -O2 -ftree-vectorize).
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_BATCH_H_
+#define _ITEMP_BATCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// types and definitions
+
+/**
+ * @brief Names one of the batch conversions, for the functions below that
+ * choose a conversion at run time.
+ */
+typedef enum {
+  ITEMP_TO_FAHRENHEIT_1,
+  ITEMP_TO_FAHRENHEIT_10,
+  ITEMP_TO_FAHRENHEIT_100,
+  ITEMP_TO_CELSIUS_1,
+  ITEMP_TO_CELSIUS_10,
+  ITEMP_TO_CELSIUS_100,
+  FAHRENHEIT_1_TO_ITEMP,
+  FAHRENHEIT_10_TO_ITEMP,
+  FAHRENHEIT_100_TO_ITEMP,
+  CELSIUS_1_TO_ITEMP,
+  CELSIUS_10_TO_ITEMP,
+  CELSIUS_100_TO_ITEMP,
+  ITEMP_CONVERSION_COUNT
+} itemp_conversion_t;
+
+/**
+ * @brief A dense batch conversion, for itemp_set_batch_backend().  src and
+ * dst hold n itemp_t or int16_t values, as the conversion requires.
+ */
+typedef void (*itemp_batch_fn_t)(const void *src, void *dst, size_t n);
+
+// =============================================================================
+// declarations
+
+/**
+ * Convert n values from degrees Fahrenheit to itemp.
+ */
+void fahrenheit_1_to_itemp_batch(const int16_t *fahrenheit_1, itemp_t *itemps,
+                                 size_t n);
+
+/**
+ * Convert n values from tenths of a degree Fahrenheit to itemp.
+ */
+void fahrenheit_10_to_itemp_batch(const int16_t *fahrenheit_10,
+                                  itemp_t *itemps, size_t n);
+
+/**
+ * Convert n values from hundreths of a degree Fahrenheit to itemp.
+ */
+void fahrenheit_100_to_itemp_batch(const int16_t *fahrenheit_100,
+                                   itemp_t *itemps, size_t n);
+
+/**
+ * Convert n itemp values to degrees Fahrenheit.
+ */
+void itemp_to_fahrenheit_1_batch(const itemp_t *itemps, int16_t *fahrenheit_1,
+                                 size_t n);
+
+/**
+ * Convert n itemp values to tenths of a degree Fahrenheit.
+ */
+void itemp_to_fahrenheit_10_batch(const itemp_t *itemps,
+                                  int16_t *fahrenheit_10, size_t n);
+
+/**
+ * Convert n itemp values to hundreths of a degree Fahrenheit.
+ */
+void itemp_to_fahrenheit_100_batch(const itemp_t *itemps,
+                                   int16_t *fahrenheit_100, size_t n);
+
+void celsius_1_to_itemp_batch(const int16_t *celsius_1, itemp_t *itemps,
+                              size_t n);
+void celsius_10_to_itemp_batch(const int16_t *celsius_10, itemp_t *itemps,
+                               size_t n);
+void celsius_100_to_itemp_batch(const int16_t *celsius_100, itemp_t *itemps,
+                                size_t n);
+
+void itemp_to_celsius_1_batch(const itemp_t *itemps, int16_t *celsius_1,
+                              size_t n);
+void itemp_to_celsius_10_batch(const itemp_t *itemps, int16_t *celsius_10,
+                               size_t n);
+void itemp_to_celsius_100_batch(const itemp_t *itemps, int16_t *celsius_100,
+                                size_t n);
+
+/**
+ * Convert n values from hundreths of a degree Fahrenheit to itemp, in place.
+ * Both are 16 bits, so the buffer is reused rather than copied.
+ *
+ * @param buf n values in hundreths of a degree Fahrenheit.
+ * @param n The number of values.
+ * @returns buf, which now holds n itemp values.
+ */
+itemp_t *fahrenheit_100_to_itemp_inplace(int16_t *buf, size_t n);
+
+/**
+ * Convert n values from hundreths of a degree Celsius to itemp, in place.
+ *
+ * @param buf n values in hundreths of a degree Celsius.
+ * @param n The number of values.
+ * @returns buf, which now holds n itemp values.
+ */
+itemp_t *celsius_100_to_itemp_inplace(int16_t *buf, size_t n);
+
+/**
+ * Convert n itemp values to hundreths of a degree Fahrenheit, in place.
+ *
+ * @param buf n itemp values.
+ * @param n The number of values.
+ * @returns buf, which now holds n values in hundreths of a degree Fahrenheit.
+ */
+int16_t *itemp_to_fahrenheit_100_inplace(itemp_t *buf, size_t n);
+
+/**
+ * Convert n itemp values to hundreths of a degree Celsius, in place.
+ *
+ * @param buf n itemp values.
+ * @param n The number of values.
+ * @returns buf, which now holds n values in hundreths of a degree Celsius.
+ */
+int16_t *itemp_to_celsius_100_inplace(itemp_t *buf, size_t n);
+
+/**
+ * Add delta to n itemp values, saturating at 0 and 65535 rather than
+ * wrapping.  itemps and out may be the same array.
+ */
+void itemp_add_delta_batch(const itemp_t *itemps, itemp_delta_t delta,
+                           itemp_t *out, size_t n);
+
+/**
+ * Subtract delta from n itemp values, saturating at 0 and 65535.
+ */
+void itemp_sub_delta_batch(const itemp_t *itemps, itemp_delta_t delta,
+                           itemp_t *out, size_t n);
+
+/**
+ * Add deltas[i] to itemps[i], saturating at 0 and 65535.
+ */
+void itemp_add_deltas_batch(const itemp_t *itemps, const itemp_delta_t *deltas,
+                            itemp_t *out, size_t n);
+
+/**
+ * Set deltas[i] = a[i] - b[i], exactly.
+ */
+void itemp_difference_batch(const itemp_t *a, const itemp_t *b,
+                            itemp_delta_t *deltas, size_t n);
+
+/**
+ * Convert n dense values with the named conversion.  src and dst hold n
+ * itemp_t or int16_t values, as the conversion requires.
+ */
+void itemp_convert_batch(itemp_conversion_t conversion, const void *src,
+                         void *dst, size_t n);
+
+/**
+ * Convert n values that sit at a fixed byte stride, such as a field inside an
+ * array of structs.  Value i is read from src + i * src_stride and written to
+ * dst + i * dst_stride; neither needs to be aligned.
+ *
+ * Values are converted in chunks through a small dense buffer, so src and dst
+ * may name the same field of the same records to convert in place.  Other
+ * overlap between src and dst is not allowed.
+ *
+ * @param conversion The conversion to apply.
+ * @param src Address of the first input value.
+ * @param src_stride Bytes from one input value to the next, at least 2.
+ * @param dst Address of the first output value.
+ * @param dst_stride Bytes from one output value to the next, at least 2.
+ * @param n The number of values.
+ */
+void itemp_convert_strided(itemp_conversion_t conversion, const void *src,
+                           size_t src_stride, void *dst, size_t dst_stride,
+                           size_t n);
+
+/**
+ * Convert n dense values with the loop above, as itemp_convert_batch() does
+ * when no backend is installed, but without counting or tracing them.
+ * itemp_tune.h builds and checks its backends with this, so that tuning does
+ * not show up in itemp_counters.h or in a trace.
+ */
+void itemp_convert_loop(itemp_conversion_t conversion, const void *src,
+                        void *dst, size_t n);
+
+/**
+ * Convert one value as the scalar function in itemp.h does, without counting
+ * or tracing it.  This is defined in itemp.c.
+ *
+ * @param value An itemp_t or int16_t, as the conversion requires.
+ * @returns An int16_t or itemp_t, as the conversion requires.
+ */
+uint16_t itemp_convert_value(itemp_conversion_t conversion, uint16_t value);
+
+/**
+ * Make itemp_convert_batch() and itemp_convert_strided() call fn for one
+ * conversion, in place of the loop above.  fn must give the same results.
+ * itemp_tune.h uses this to install the fastest backend for the host.
+ *
+ * This is not thread safe: set backends before other threads convert.
+ *
+ * @param conversion The conversion to replace.
+ * @param fn The replacement, or NULL to restore the loop.
+ */
+void itemp_set_batch_backend(itemp_conversion_t conversion,
+                             itemp_batch_fn_t fn);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _ITEMP_BATCH_H_ */
@@ -0,0 +1,1184 @@
+/** @file itemp_bench.c
+ * Benchmarks for the itemp kernels.
+ *
+ * To build on a unix-like system:
+ *   cc -O3 -Wall -DITEMP_USE_IO_URING -o itemp_bench itemp_bench.c \
+ *      itemp_batch.c itemp_correlate.c itemp_ct.c itemp_reader.c \
+ *      itemp_scale.c itemp_select.c itemp_stats.c itemp_tune.c \
+ *      itemp_workload.c itemp.c -lm -lpthread
+ *
+ *   ./itemp_bench                   time every kernel, in ns per element
+ *   ./itemp_bench -k stats          time kernels whose name contains "stats"
+ *   ./itemp_bench -p                add hardware counters per element
+ *   ./itemp_bench -W                feed the kernels synthetic sensor readings
+ *                                   rather than uniformly random itemps
+ *   ./itemp_bench -w base.json      save each kernel's median as a baseline
+ *   ./itemp_bench -c base.json      compare against a baseline: exit 1 if a
+ *                                   kernel is significantly slower
+ *   ./itemp_bench -R [file ...]     compare pread and io_uring file scans
+ *   ./itemp_bench -T tune.cache     time each backend as itemp_tune_init()
+ *                                   does, and save the choices
+ *   ./itemp_bench -C                the spread of call times over all inputs,
+ *                                   for itemp.h and its itemp_ct.h versions
+ *
+ * Uniform inputs exercise every code path equally; -W inputs, from
+ * itemp_workload.h, cluster around room temperature with occasional spikes,
+ * dropouts and out of range excursions, as a fleet of real sensors would.
+ * Branches, range checks and histograms behave differently on each.
+ *
+ * Without files, -R writes a set of scratch files first.  Those are likely to
+ * be served from the page cache, so point it at real data to measure a drive.
+ *
+ * -p reads cycles, instructions, L1 data and last level cache read misses and
+ * branch misses through perf_event_open(2), on Linux, counting user space
+ * only.  Counters the host does not offer, as in many virtual machines, or
+ * that perf_event_paranoid forbids, are shown as "-".
+ *
+ * -C times each function once per input, for every input of its domain: all
+ * 65536 itemps or int16_t values, a float for every hundredth of a degree
+ * mixed with subnormals, infinities and NaNs, or a mix of small and large
+ * deltas.  Each input is timed as a chain of dependent calls, in a shuffled
+ * order, and keeps its fastest time over -r repetitions, so that what is left
+ * is the cost of the input rather than of interrupts.  A constant time
+ * function has p99.9 and max close to its median.  Times are in TSC ticks on
+ * x86 and ns elsewhere, and include the timer's own overhead, which is the
+ * same for both versions of a function.
+ *
+ * A kernel has regressed when the low end of the 95% confidence interval of
+ * its median is more than -t percent (default 10) above the high end of the
+ * baseline's interval, so noise on either side does not fail the gate.  The
+ * interval comes from order statistics, so use -r 21 or more for a tight one.
+ * Baselines only compare like with like: the same host, compiler and flags.
+ * -c refuses, with exit status 2, a baseline measured over a different -n or
+ * with -W set differently.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include "itemp_batch.h"
+#include "itemp_correlate.h"
+#include "itemp_ct.h"
+#include "itemp_reader.h"
+#include "itemp_scale.h"
+#include "itemp_select.h"
+#include "itemp_stats.h"
+#include "itemp_tune.h"
+#include "itemp_workload.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#define HAVE_PERF_EVENTS 1
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_RDTSC 1
+#include <x86intrin.h>
+#endif
+
+// =============================================================================
+// local types and definitions
+
+#define DEFAULT_ELEMENTS (1 << 20)
+#define DEFAULT_REPETITIONS 11
+#define DEFAULT_THRESHOLD_PERCENT 10.0
+#define WORKLOAD_SENSORS 64
+#define WORKLOAD_SEED 0x1234567
+#define MAX_REPETITIONS 101
+
+#define SCRATCH_FILES 64
+#define SCRATCH_FILE_BYTES (4 << 20)
+
+// -C: each domain has SPREAD_INPUTS inputs, each timed as SPREAD_CHAIN calls.
+#define SPREAD_INPUTS 65536
+#define SPREAD_CHAIN 4
+
+// The largest record used by the strided kernels.  Each record holds an itemp
+// at offset 0 and receives its converted value at offset 2.
+#define RECORD_MAX 12
+
+typedef struct {
+  size_t n;
+  itemp_t *itemps;        // input for kernels that consume itemps
+  int16_t *values_100;    // input for kernels that produce itemps
+  int16_t *out_100;       // output of kernels that produce hundredths
+  itemp_t *out_itemps;    // output of kernels that produce itemps
+  int32_t *out_32;        // output of kernels that produce 32 bit values
+  uint8_t *records;       // n records of up to RECORD_MAX bytes, itemp first
+  itemp_scale_t kelvin_100;
+  itemp_stats_t stats;
+  itemp_histogram_t *histogram;
+  itemp_workload_t workload;  // a fleet for k_workload_fleet()
+} bench_data_t;
+
+typedef struct {
+  const char *name;
+  void (*fn)(bench_data_t *data);
+} kernel_t;
+
+// The timing of one kernel, in ns per element.
+typedef struct {
+  bool ran;
+  double best;
+  double median;
+  double ci_low;  // a 95% confidence interval for the median
+  double ci_high;
+} result_t;
+
+// The inputs of a -C function, encoded as uint32_t.
+typedef enum {
+  SPREAD_ITEMP,
+  SPREAD_INT16,
+  SPREAD_FLOAT,  // the bits of a float
+  SPREAD_DELTA,
+  SPREAD_SUM,  // an itemp in the low half, a delta / 2 in the high half
+  SPREAD_DOMAINS
+} spread_domain_t;
+
+// A function from itemp.h and its constant time version, for -C.
+typedef struct {
+  const char *name;
+  spread_domain_t domain;
+  uint32_t (*fn)(uint32_t input);
+  uint32_t (*fn_ct)(uint32_t input);
+} spread_pair_t;
+
+// The hardware counters read by -p.
+typedef enum {
+  COUNTER_CYCLES,
+  COUNTER_INSTRUCTIONS,
+  COUNTER_L1D_MISSES,
+  COUNTER_LLC_MISSES,
+  COUNTER_BRANCH_MISSES,
+  N_COUNTERS
+} counter_t;
+
+typedef struct {
+  int fds[N_COUNTERS];      // -1 where a counter is unavailable
+  double values[N_COUNTERS]; // since counters_start(), scaled if multiplexed
+  bool valid[N_COUNTERS];
+} counters_t;
+
+// =============================================================================
+// local (forward) declarations
+
+static void usage(const char *program);
+static uint64_t now_ns(void);
+static uint32_t xorshift32(uint32_t *state);
+static int compare_double(const void *a, const void *b);
+static bool bench_data_init(bench_data_t *data, size_t n, bool use_workload);
+static void bench_data_free(bench_data_t *data);
+static void run_kernels(const char *filter, size_t n, int repetitions,
+                        bool use_counters, bool use_workload,
+                        result_t *results);
+
+/**
+ * @brief Set the median of the sorted samples and a 95% confidence interval
+ * for it, from the order statistics (no assumption about the distribution).
+ */
+static void median_ci(const double *sorted, int count, result_t *result);
+
+/**
+ * @brief Write the results as JSON, with the settings they were measured
+ * with.
+ */
+static int write_baseline(const char *path, const result_t *results, size_t n,
+                          int repetitions, bool use_workload);
+
+/**
+ * @brief Compare the results with a baseline written by write_baseline() and
+ * return 1 if any kernel has regressed by more than threshold percent, or 2
+ * if the baseline was measured over other inputs.
+ */
+static int compare_baseline(const char *path, const result_t *results,
+                            size_t n, bool use_workload, double threshold);
+
+/**
+ * @brief Open the hardware counters for this thread, disabled, and return how
+ * many are available.
+ */
+static int counters_open(counters_t *counters);
+static void counters_start(counters_t *counters);
+static void counters_stop(counters_t *counters);
+static void counters_close(counters_t *counters);
+static int run_reader(int n_paths, char *paths[], int repetitions);
+
+/**
+ * @brief Time the itemp_tune.h backends, print the timings and save the
+ * choices to path.
+ */
+static int run_tune(const char *path);
+
+/**
+ * @brief Print the spread of call times of each spread_pair_t over its domain.
+ */
+static int run_spread(int repetitions);
+static void spread_inputs(spread_domain_t domain, uint32_t *inputs);
+static void spread_time(uint32_t (*fn)(uint32_t), const uint32_t *inputs,
+                        const uint32_t *order, int repetitions,
+                        uint64_t *ticks);
+static void spread_print(const char *name, uint64_t *ticks);
+static uint64_t spread_ticks(void);
+static int compare_uint64(const void *a, const void *b);
+static uint32_t float_bits(float f);
+static float bits_float(uint32_t bits);
+static void reader_accumulate(void *arg, size_t file_index, uint64_t offset,
+                              const itemp_t *itemps, size_t n);
+
+static void k_itemp_to_fahrenheit_100(bench_data_t *data);
+static void k_itemp_to_fahrenheit_1(bench_data_t *data);
+static void k_itemp_to_celsius_100(bench_data_t *data);
+static void k_fahrenheit_100_to_itemp(bench_data_t *data);
+static void k_itemp_to_fahrenheit_100_batch(bench_data_t *data);
+static void k_itemp_to_fahrenheit_1_batch(bench_data_t *data);
+static void k_itemp_to_celsius_100_batch(bench_data_t *data);
+static void k_fahrenheit_100_to_itemp_batch(bench_data_t *data);
+static void k_fahrenheit_100_round_trip_inplace(bench_data_t *data);
+static void k_itemp_to_kelvin_100_scale_batch(bench_data_t *data);
+static void k_itemp_to_celsius_100_stride_8(bench_data_t *data);
+static void k_itemp_to_celsius_100_stride_12(bench_data_t *data);
+static void k_argmax(bench_data_t *data);
+static void k_top_100(bench_data_t *data);
+static void k_correlate_64(bench_data_t *data);
+static void k_stats_update(bench_data_t *data);
+static void k_histogram_update(bench_data_t *data);
+static void k_workload_fleet(bench_data_t *data);
+
+// spread_fn() and spread_fn_ct() call fn() and fn_ct() with an input decoded
+// from a uint32_t, and encode the result as one.
+#define SPREAD_ADAPTERS(fn, decode, encode)                 \
+  static uint32_t spread_##fn(uint32_t input) {             \
+    return encode(fn(decode(input)));                       \
+  }                                                         \
+  static uint32_t spread_##fn##_ct(uint32_t input) {        \
+    return encode(fn##_ct(decode(input)));                  \
+  }
+#define AS_ITEMP(input) ((itemp_t)(input))
+#define AS_INT16(input) ((int16_t)(input))
+#define AS_DELTA(input) ((itemp_delta_t)(input))
+#define AS_UINT32(output) ((uint32_t)(output))
+
+SPREAD_ADAPTERS(itemp_to_fahrenheit_1, AS_ITEMP, AS_UINT32)
+SPREAD_ADAPTERS(itemp_to_fahrenheit_10, AS_ITEMP, AS_UINT32)
+SPREAD_ADAPTERS(itemp_to_fahrenheit_100, AS_ITEMP, AS_UINT32)
+SPREAD_ADAPTERS(itemp_to_fahrenheit, AS_ITEMP, float_bits)
+SPREAD_ADAPTERS(itemp_to_celsius_1, AS_ITEMP, AS_UINT32)
+SPREAD_ADAPTERS(itemp_to_celsius_10, AS_ITEMP, AS_UINT32)
+SPREAD_ADAPTERS(itemp_to_celsius_100, AS_ITEMP, AS_UINT32)
+SPREAD_ADAPTERS(itemp_to_celsius, AS_ITEMP, float_bits)
+SPREAD_ADAPTERS(fahrenheit_1_to_itemp, AS_INT16, AS_UINT32)
+SPREAD_ADAPTERS(fahrenheit_10_to_itemp, AS_INT16, AS_UINT32)
+SPREAD_ADAPTERS(fahrenheit_100_to_itemp, AS_INT16, AS_UINT32)
+SPREAD_ADAPTERS(fahrenheit_to_itemp, bits_float, AS_UINT32)
+SPREAD_ADAPTERS(celsius_1_to_itemp, AS_INT16, AS_UINT32)
+SPREAD_ADAPTERS(celsius_10_to_itemp, AS_INT16, AS_UINT32)
+SPREAD_ADAPTERS(celsius_100_to_itemp, AS_INT16, AS_UINT32)
+SPREAD_ADAPTERS(celsius_to_itemp, bits_float, AS_UINT32)
+SPREAD_ADAPTERS(itemp_delta_to_fahrenheit_1, AS_DELTA, AS_UINT32)
+SPREAD_ADAPTERS(itemp_delta_to_fahrenheit_10, AS_DELTA, AS_UINT32)
+SPREAD_ADAPTERS(itemp_delta_to_fahrenheit_100, AS_DELTA, AS_UINT32)
+SPREAD_ADAPTERS(itemp_delta_to_celsius_1, AS_DELTA, AS_UINT32)
+SPREAD_ADAPTERS(itemp_delta_to_celsius_10, AS_DELTA, AS_UINT32)
+SPREAD_ADAPTERS(itemp_delta_to_celsius_100, AS_DELTA, AS_UINT32)
+
+static uint32_t spread_itemp_add_delta(uint32_t input) {
+  return itemp_add_delta((itemp_t)input, (int16_t)(input >> 16) * 2);
+}
+
+static uint32_t spread_itemp_add_delta_ct(uint32_t input) {
+  return itemp_add_delta_ct((itemp_t)input, (int16_t)(input >> 16) * 2);
+}
+
+// =============================================================================
+// local storage
+
+static const kernel_t s_kernels[] = {
+    {"itemp_to_fahrenheit_100", k_itemp_to_fahrenheit_100},
+    {"itemp_to_fahrenheit_1", k_itemp_to_fahrenheit_1},
+    {"itemp_to_celsius_100", k_itemp_to_celsius_100},
+    {"fahrenheit_100_to_itemp", k_fahrenheit_100_to_itemp},
+    {"itemp_to_fahrenheit_100_batch", k_itemp_to_fahrenheit_100_batch},
+    {"itemp_to_fahrenheit_1_batch", k_itemp_to_fahrenheit_1_batch},
+    {"itemp_to_celsius_100_batch", k_itemp_to_celsius_100_batch},
+    {"fahrenheit_100_to_itemp_batch", k_fahrenheit_100_to_itemp_batch},
+    {"fahrenheit_100_round_trip_inplace",
+     k_fahrenheit_100_round_trip_inplace},
+    {"itemp_to_kelvin_100_scale_batch", k_itemp_to_kelvin_100_scale_batch},
+    {"itemp_to_celsius_100_stride_8", k_itemp_to_celsius_100_stride_8},
+    {"itemp_to_celsius_100_stride_12", k_itemp_to_celsius_100_stride_12},
+    {"itemp_argmax", k_argmax},
+    {"itemp_top_100", k_top_100},
+    {"itemp_correlate_64", k_correlate_64},
+    {"itemp_stats_update", k_stats_update},
+    {"itemp_histogram_update", k_histogram_update},
+    {"itemp_workload_fleet", k_workload_fleet},
+};
+#define N_KERNELS (sizeof(s_kernels) / sizeof(s_kernels[0]))
+
+#define SPREAD_PAIR(fn, domain) {#fn, domain, spread_##fn, spread_##fn##_ct}
+
+static const spread_pair_t s_spread_pairs[] = {
+    SPREAD_PAIR(itemp_to_fahrenheit_1, SPREAD_ITEMP),
+    SPREAD_PAIR(itemp_to_fahrenheit_10, SPREAD_ITEMP),
+    SPREAD_PAIR(itemp_to_fahrenheit_100, SPREAD_ITEMP),
+    SPREAD_PAIR(itemp_to_fahrenheit, SPREAD_ITEMP),
+    SPREAD_PAIR(itemp_to_celsius_1, SPREAD_ITEMP),
+    SPREAD_PAIR(itemp_to_celsius_10, SPREAD_ITEMP),
+    SPREAD_PAIR(itemp_to_celsius_100, SPREAD_ITEMP),
+    SPREAD_PAIR(itemp_to_celsius, SPREAD_ITEMP),
+    SPREAD_PAIR(fahrenheit_1_to_itemp, SPREAD_INT16),
+    SPREAD_PAIR(fahrenheit_10_to_itemp, SPREAD_INT16),
+    SPREAD_PAIR(fahrenheit_100_to_itemp, SPREAD_INT16),
+    SPREAD_PAIR(fahrenheit_to_itemp, SPREAD_FLOAT),
+    SPREAD_PAIR(celsius_1_to_itemp, SPREAD_INT16),
+    SPREAD_PAIR(celsius_10_to_itemp, SPREAD_INT16),
+    SPREAD_PAIR(celsius_100_to_itemp, SPREAD_INT16),
+    SPREAD_PAIR(celsius_to_itemp, SPREAD_FLOAT),
+    SPREAD_PAIR(itemp_add_delta, SPREAD_SUM),
+    SPREAD_PAIR(itemp_delta_to_fahrenheit_1, SPREAD_DELTA),
+    SPREAD_PAIR(itemp_delta_to_fahrenheit_10, SPREAD_DELTA),
+    SPREAD_PAIR(itemp_delta_to_fahrenheit_100, SPREAD_DELTA),
+    SPREAD_PAIR(itemp_delta_to_celsius_1, SPREAD_DELTA),
+    SPREAD_PAIR(itemp_delta_to_celsius_10, SPREAD_DELTA),
+    SPREAD_PAIR(itemp_delta_to_celsius_100, SPREAD_DELTA),
+};
+#define N_SPREAD_PAIRS (sizeof(s_spread_pairs) / sizeof(s_spread_pairs[0]))
+
+// Read once per chain, so that the compiler cannot tell that each call's
+// input does not depend on the previous call's result.
+static volatile uint32_t s_spread_zero = 0;
+
+// =============================================================================
+// public code
+
+int main(int argc, char *argv[]) {
+  const char *filter = NULL;
+  size_t n = DEFAULT_ELEMENTS;
+  int repetitions = DEFAULT_REPETITIONS;
+  bool reader = false;
+  bool spread = false;
+  bool use_counters = false;
+  bool use_workload = false;
+  const char *write_path = NULL;
+  const char *compare_path = NULL;
+  const char *tune_path = NULL;
+  double threshold = DEFAULT_THRESHOLD_PERCENT;
+  result_t results[N_KERNELS];
+  int status = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "c:Ck:n:pr:Rt:T:w:W")) != -1) {
+    switch (opt) {
+    case 'k':
+      filter = optarg;
+      break;
+    case 'n':
+      n = strtoul(optarg, NULL, 0);
+      break;
+    case 'p':
+      use_counters = true;
+      break;
+    case 'r':
+      repetitions = atoi(optarg);
+      break;
+    case 'R':
+      reader = true;
+      break;
+    case 'c':
+      compare_path = optarg;
+      break;
+    case 'C':
+      spread = true;
+      break;
+    case 't':
+      threshold = atof(optarg);
+      break;
+    case 'T':
+      tune_path = optarg;
+      break;
+    case 'w':
+      write_path = optarg;
+      break;
+    case 'W':
+      use_workload = true;
+      break;
+    default:
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (n == 0 || repetitions < 1 || repetitions > MAX_REPETITIONS ||
+      threshold < 0) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  if (reader) {
+    return run_reader(argc - optind, &argv[optind], repetitions);
+  }
+  if (tune_path != NULL) {
+    return run_tune(tune_path);
+  }
+  if (spread) {
+    return run_spread(repetitions);
+  }
+  run_kernels(filter, n, repetitions, use_counters, use_workload, results);
+  if (write_path != NULL) {
+    status = write_baseline(write_path, results, n, repetitions,
+                            use_workload);
+  }
+  if (status == 0 && compare_path != NULL) {
+    status = compare_baseline(compare_path, results, n, use_workload,
+                              threshold);
+  }
+  return status;
+}
+
+// =============================================================================
+// local (static) code
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "usage: %s [-k filter] [-n elements] [-p] [-r repetitions] [-W]\n"
+          "          [-w baseline.json] [-c baseline.json [-t percent]]\n"
+          "       %s -R [-r repetitions] [file ...]\n"
+          "       %s -T tune.cache\n"
+          "       %s -C [-r repetitions]\n",
+          program, program, program, program);
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static uint32_t xorshift32(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *state = x;
+}
+
+static int compare_double(const void *a, const void *b) {
+  double da = *(const double *)a;
+  double db = *(const double *)b;
+  return (da > db) - (da < db);
+}
+
+static bool bench_data_init(bench_data_t *data, size_t n, bool use_workload) {
+  itemp_workload_config_t config;
+  uint32_t seed = WORKLOAD_SEED;
+
+  data->n = n;
+  data->itemps = malloc(n * sizeof(itemp_t));
+  data->values_100 = malloc(n * sizeof(int16_t));
+  data->out_100 = malloc(n * sizeof(int16_t));
+  data->out_itemps = malloc(n * sizeof(itemp_t));
+  data->out_32 = malloc(n * sizeof(int32_t));
+  data->records = calloc(n, RECORD_MAX);
+  data->histogram = malloc(sizeof(itemp_histogram_t));
+  itemp_workload_config_init(&config, WORKLOAD_SENSORS, WORKLOAD_SEED);
+  if (!data->itemps || !data->values_100 || !data->out_100 ||
+      !data->out_itemps || !data->out_32 || !data->records ||
+      !data->histogram || !itemp_workload_init(&data->workload, &config)) {
+    return false;
+  }
+  if (use_workload) {
+    itemp_workload_generate_fleet(&data->workload, data->itemps, NULL, NULL,
+                                  n);
+  }
+  for (size_t i = 0; i < n; i++) {
+    if (!use_workload) {
+      data->itemps[i] = (itemp_t)xorshift32(&seed);
+    }
+    data->values_100[i] = itemp_to_fahrenheit_100(data->itemps[i]);
+  }
+  for (size_t i = 0; i < n * RECORD_MAX / sizeof(itemp_t); i++) {
+    // every 16 bit word is a plausible itemp, whatever the record size
+    memcpy(data->records + i * sizeof(itemp_t), &data->itemps[i % n],
+           sizeof(itemp_t));
+  }
+  itemp_scale_init(&data->kelvin_100, 100, 27315, 1);
+  itemp_stats_init(&data->stats);
+  itemp_histogram_init(data->histogram);
+  return true;
+}
+
+static void bench_data_free(bench_data_t *data) {
+  free(data->itemps);
+  free(data->values_100);
+  free(data->out_100);
+  free(data->out_itemps);
+  free(data->out_32);
+  free(data->records);
+  free(data->histogram);
+  itemp_workload_free(&data->workload);
+}
+
+static void run_kernels(const char *filter, size_t n, int repetitions,
+                        bool use_counters, bool use_workload,
+                        result_t *results) {
+  static const char *counter_names[N_COUNTERS] = {
+      "cycles/el", "instr/el", "L1D miss/el", "LLC miss/el", "br miss/el"};
+  bench_data_t data;
+  double ns_per_element[MAX_REPETITIONS];
+  counters_t counters;
+
+  if (!bench_data_init(&data, n, use_workload)) {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+  if (use_counters && counters_open(&counters) == 0) {
+    fprintf(stderr, "no hardware counters: the host may lack a PMU, or "
+                    "/proc/sys/kernel/perf_event_paranoid forbids them\n");
+    use_counters = false;
+  }
+  printf("%-34s %12s %12s", "kernel", "best ns/el", "median ns/el");
+  for (int c = 0; use_counters && c < N_COUNTERS; c++) {
+    printf(" %11s", counter_names[c]);
+  }
+  printf("\n");
+  for (size_t k = 0; k < N_KERNELS; k++) {
+    const kernel_t *kernel = &s_kernels[k];
+    results[k].ran = false;
+    if (filter != NULL && strstr(kernel->name, filter) == NULL) {
+      continue;
+    }
+    kernel->fn(&data);  // warm up caches and page in the buffers
+    if (use_counters) {
+      counters_start(&counters);
+    }
+    for (int r = 0; r < repetitions; r++) {
+      uint64_t start = now_ns();
+      kernel->fn(&data);
+      ns_per_element[r] = (double)(now_ns() - start) / n;
+    }
+    if (use_counters) {
+      counters_stop(&counters);
+    }
+    qsort(ns_per_element, repetitions, sizeof(double), compare_double);
+    median_ci(ns_per_element, repetitions, &results[k]);
+    printf("%-34s %12.3f %12.3f", kernel->name, results[k].best,
+           results[k].median);
+    for (int c = 0; use_counters && c < N_COUNTERS; c++) {
+      if (counters.valid[c]) {
+        printf(" %11.3f", counters.values[c] / ((double)n * repetitions));
+      } else {
+        printf(" %11s", "-");
+      }
+    }
+    printf("\n");
+  }
+  if (use_counters) {
+    counters_close(&counters);
+  }
+  bench_data_free(&data);
+}
+
+static void median_ci(const double *sorted, int count, result_t *result) {
+  // The ranks (from 1) n/2 -/+ 1.96 sqrt(n)/2 bracket the median with 95%
+  // confidence; the normal approximation to the binomial is close enough.
+  double half_width = 0.98 * sqrt((double)count);
+  int lo = (int)floor(count / 2.0 - half_width);
+  int hi = (int)ceil(count / 2.0 + 1.0 + half_width);
+  lo = (lo < 1) ? 1 : lo;
+  hi = (hi > count) ? count : hi;
+
+  result->ran = true;
+  result->best = sorted[0];
+  result->median = sorted[count / 2];
+  if (count % 2 == 0) {
+    result->median = (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+  }
+  result->ci_low = sorted[lo - 1];
+  result->ci_high = sorted[hi - 1];
+}
+
+static int write_baseline(const char *path, const result_t *results, size_t n,
+                          int repetitions, bool use_workload) {
+  FILE *fp = fopen(path, "w");
+  if (fp == NULL) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return 2;
+  }
+  fprintf(fp, "{\n  \"elements\": %zu,\n  \"repetitions\": %d,\n", n,
+          repetitions);
+  fprintf(fp, "  \"workload\": %s,\n", use_workload ? "true" : "false");
+#ifdef __VERSION__
+  fprintf(fp, "  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+  fprintf(fp, "  \"kernels\": [");
+  const char *separator = "\n";
+  for (size_t k = 0; k < N_KERNELS; k++) {
+    if (!results[k].ran) {
+      continue;
+    }
+    fprintf(fp,
+            "%s    {\"name\": \"%s\", \"median\": %.4f, \"ci_low\": %.4f, "
+            "\"ci_high\": %.4f}",
+            separator, s_kernels[k].name, results[k].median,
+            results[k].ci_low, results[k].ci_high);
+    separator = ",\n";
+  }
+  fprintf(fp, "\n  ]\n}\n");
+  if (fclose(fp) != 0) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return 2;
+  }
+  return 0;
+}
+
+static int compare_baseline(const char *path, const result_t *results,
+                            size_t n, bool use_workload, double threshold) {
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return 2;
+  }
+  result_t baseline[N_KERNELS];
+  for (size_t k = 0; k < N_KERNELS; k++) {
+    baseline[k].ran = false;
+  }
+  // Only the format write_baseline() produces is understood: one setting or
+  // kernel per line, with its fields in order.
+  char line[512];
+  size_t then_n = 0;
+  char then_workload[8] = "";
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    char name[128];
+    result_t r;
+    if (sscanf(line, " \"elements\": %zu", &then_n) == 1 ||
+        sscanf(line, " \"workload\": %7[a-z]", then_workload) == 1) {
+      continue;
+    }
+    if (sscanf(line,
+               " {\"name\": \"%127[^\"]\", \"median\": %lf, \"ci_low\": %lf, "
+               "\"ci_high\": %lf}",
+               name, &r.median, &r.ci_low, &r.ci_high) != 4) {
+      continue;
+    }
+    for (size_t k = 0; k < N_KERNELS; k++) {
+      if (strcmp(name, s_kernels[k].name) == 0) {
+        r.ran = true;
+        baseline[k] = r;
+      }
+    }
+  }
+  fclose(fp);
+
+  // Per element times depend on whether the data fits in cache, and on how
+  // branches and range checks behave on the inputs, so only compare runs
+  // over the same inputs.
+  const char *workload = use_workload ? "true" : "false";
+  if (then_n == 0 || then_workload[0] == '\0') {
+    fprintf(stderr, "%s: does not record -n and -W; rewrite it with -w\n",
+            path);
+    return 2;
+  }
+  if (then_n != n || strcmp(then_workload, workload) != 0) {
+    fprintf(stderr,
+            "%s: measured with -n %zu%s, not -n %zu%s; not comparing\n",
+            path, then_n, strcmp(then_workload, "true") == 0 ? " -W" : "", n,
+            use_workload ? " -W" : "");
+    return 2;
+  }
+
+  int status = 0;
+  printf("\n%-34s %12s %12s %8s\n", "kernel", "baseline", "median", "change");
+  for (size_t k = 0; k < N_KERNELS; k++) {
+    const result_t *now = &results[k];
+    const result_t *then = &baseline[k];
+    if (!now->ran) {
+      continue;
+    }
+    if (!then->ran) {
+      printf("%-34s %12s %12.3f %8s  new\n", s_kernels[k].name, "-",
+             now->median, "-");
+      continue;
+    }
+    double change = 100.0 * (now->median - then->median) / then->median;
+    const char *verdict = "ok";
+    if (now->ci_low > then->ci_high * (1.0 + threshold / 100.0)) {
+      verdict = "REGRESSED";
+      status = 1;
+    } else if (now->ci_high * (1.0 + threshold / 100.0) < then->ci_low) {
+      verdict = "faster";
+    }
+    printf("%-34s %12.3f %12.3f %+7.1f%%  %s\n", s_kernels[k].name,
+           then->median, now->median, change, verdict);
+  }
+  return status;
+}
+
+static int counters_open(counters_t *counters) {
+  int opened = 0;
+  for (int c = 0; c < N_COUNTERS; c++) {
+    counters->fds[c] = -1;
+    counters->valid[c] = false;
+  }
+#ifdef HAVE_PERF_EVENTS
+  static const struct {
+    uint32_t type;
+    uint64_t config;
+  } events[N_COUNTERS] = {
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+      {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                               (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+      {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL |
+                               (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+      {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+  };
+  for (int c = 0; c < N_COUNTERS; c++) {
+    // Each counter is opened on its own rather than as a group, so that one
+    // the host lacks does not take the others with it.  If the PMU has too
+    // few registers the kernel multiplexes them, which counters_stop()
+    // corrects for.
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = events[c].type;
+    attr.config = events[c].config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;  // allowed at perf_event_paranoid 2
+    attr.exclude_hv = 1;
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    counters->fds[c] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (counters->fds[c] >= 0) {
+      opened++;
+    }
+  }
+#endif
+  return opened;
+}
+
+static void counters_start(counters_t *counters) {
+#ifdef HAVE_PERF_EVENTS
+  for (int c = 0; c < N_COUNTERS; c++) {
+    if (counters->fds[c] >= 0) {
+      ioctl(counters->fds[c], PERF_EVENT_IOC_RESET, 0);
+      ioctl(counters->fds[c], PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+#else
+  (void)counters;
+#endif
+}
+
+static void counters_stop(counters_t *counters) {
+  for (int c = 0; c < N_COUNTERS; c++) {
+    counters->valid[c] = false;
+#ifdef HAVE_PERF_EVENTS
+    // value, time enabled, time running
+    uint64_t buf[3];
+    if (counters->fds[c] < 0) {
+      continue;
+    }
+    ioctl(counters->fds[c], PERF_EVENT_IOC_DISABLE, 0);
+    if (read(counters->fds[c], buf, sizeof(buf)) == sizeof(buf) &&
+        buf[2] > 0) {
+      counters->values[c] = (double)buf[0] * buf[1] / buf[2];
+      counters->valid[c] = true;
+    }
+#endif
+  }
+}
+
+static void counters_close(counters_t *counters) {
+  for (int c = 0; c < N_COUNTERS; c++) {
+    if (counters->fds[c] >= 0) {
+      close(counters->fds[c]);
+    }
+  }
+}
+
+static int run_tune(const char *path) {
+  itemp_tune_t tune;
+
+  if (!itemp_tune_measure(&tune, ITEMP_TUNE_ELEMENTS,
+                          ITEMP_TUNE_REPETITIONS)) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  printf("%s\n\n%-24s", tune.signature, "kernel (ns/el)");
+  for (int b = 0; b < ITEMP_TUNE_BACKEND_COUNT; b++) {
+    printf(" %8s", itemp_tune_backend_name((itemp_tune_backend_t)b));
+  }
+  printf("  chosen\n");
+  for (int k = 0; k < ITEMP_TUNE_KERNELS; k++) {
+    printf("%-24s", itemp_tune_kernel_name(k));
+    for (int b = 0; b < ITEMP_TUNE_BACKEND_COUNT; b++) {
+      double ns = tune.ns[k][b];
+      if (ns > 0) {
+        printf(" %8.3f", ns);
+      } else {
+        printf(" %8s", ns < 0 ? "differs" : "-");
+      }
+    }
+    printf("  %s\n", itemp_tune_backend_name(tune.backends[k]));
+  }
+  if (!itemp_tune_save(&tune, path)) {
+    fprintf(stderr, "%s: %s\n", path, strerror(errno));
+    return 1;
+  }
+  return 0;
+}
+
+static int run_spread(int repetitions) {
+  uint32_t *inputs = malloc(SPREAD_INPUTS * sizeof(uint32_t));
+  uint32_t *order = malloc(SPREAD_INPUTS * sizeof(uint32_t));
+  uint64_t *ticks = malloc(SPREAD_INPUTS * sizeof(uint64_t));
+  uint32_t seed = WORKLOAD_SEED;
+  char name[64];
+
+  if (!inputs || !order || !ticks) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  // the same shuffled order for every function, so they see the same
+  // sequence of branch outcomes and cache lines
+  for (uint32_t i = 0; i < SPREAD_INPUTS; i++) {
+    order[i] = i;
+  }
+  for (uint32_t i = SPREAD_INPUTS - 1; i > 0; i--) {
+    uint32_t j = xorshift32(&seed) % (i + 1);
+    uint32_t t = order[i];
+    order[i] = order[j];
+    order[j] = t;
+  }
+  printf("%-34s %9s %9s %9s %9s %9s\n",
+#ifdef HAVE_RDTSC
+         "function (ticks per call)",
+#else
+         "function (ns per call)",
+#endif
+         "median", "p99", "p99.9", "max", "spread");
+  for (size_t p = 0; p < N_SPREAD_PAIRS; p++) {
+    const spread_pair_t *pair = &s_spread_pairs[p];
+    spread_inputs(pair->domain, inputs);
+    spread_time(pair->fn, inputs, order, repetitions, ticks);
+    spread_print(pair->name, ticks);
+    snprintf(name, sizeof(name), "%s_ct", pair->name);
+    spread_time(pair->fn_ct, inputs, order, repetitions, ticks);
+    spread_print(name, ticks);
+  }
+  free(inputs);
+  free(order);
+  free(ticks);
+  return 0;
+}
+
+static void spread_inputs(spread_domain_t domain, uint32_t *inputs) {
+  // the floats that take slow paths or must be clamped
+  static const uint32_t special_floats[] = {
+      0x00000001, 0x807fffff, 0x00000000, 0x80000000, 0x7f800000,
+      0xff800000, 0x7fc00000, 0x7149f2ca, 0xf149f2ca,  // +/-1e30
+  };
+  uint32_t seed = WORKLOAD_SEED;
+
+  for (uint32_t i = 0; i < SPREAD_INPUTS; i++) {
+    uint32_t random = xorshift32(&seed);
+    switch (domain) {
+    case SPREAD_ITEMP:
+    case SPREAD_INT16:
+      inputs[i] = i;
+      break;
+    case SPREAD_FLOAT:
+      // one input in 16 is special
+      inputs[i] = (i % 16 == 0)
+                      ? special_floats[(i / 16) % (sizeof(special_floats) /
+                                                   sizeof(special_floats[0]))]
+                      : float_bits((int16_t)i / 100.0f);
+      break;
+    case SPREAD_DELTA:
+      // half within +/-32767, half up to +/-2^30
+      inputs[i] = (i & 1) ? (uint32_t)(int16_t)i
+                          : (uint32_t)((int32_t)random >> 1);
+      break;
+    case SPREAD_SUM:
+    default:
+      inputs[i] = random;
+      break;
+    }
+  }
+}
+
+static void spread_time(uint32_t (*fn)(uint32_t), const uint32_t *inputs,
+                        const uint32_t *order, int repetitions,
+                        uint64_t *ticks) {
+  for (uint32_t i = 0; i < SPREAD_INPUTS; i++) {
+    ticks[i] = UINT64_MAX;
+  }
+  for (int r = 0; r < repetitions; r++) {
+    for (uint32_t i = 0; i < SPREAD_INPUTS; i++) {
+      uint32_t input = inputs[order[i]];
+      uint32_t zero = s_spread_zero;
+      uint32_t output = 0;
+      uint64_t start = spread_ticks();
+      for (int c = 0; c < SPREAD_CHAIN; c++) {
+        output = fn(input ^ (output & zero));
+      }
+      uint64_t elapsed = spread_ticks() - start + (output & zero);
+      if (elapsed < ticks[order[i]]) {
+        ticks[order[i]] = elapsed;
+      }
+    }
+  }
+}
+
+static void spread_print(const char *name, uint64_t *ticks) {
+  qsort(ticks, SPREAD_INPUTS, sizeof(uint64_t), compare_uint64);
+  double median = (double)ticks[SPREAD_INPUTS / 2] / SPREAD_CHAIN;
+  double p99 = (double)ticks[SPREAD_INPUTS * 99 / 100] / SPREAD_CHAIN;
+  double p999 = (double)ticks[SPREAD_INPUTS * 999 / 1000] / SPREAD_CHAIN;
+  double max = (double)ticks[SPREAD_INPUTS - 1] / SPREAD_CHAIN;
+  printf("%-34s %9.2f %9.2f %9.2f %9.2f %9.2f\n", name, median, p99, p999,
+         max, max - median);
+}
+
+static uint64_t spread_ticks(void) {
+#ifdef HAVE_RDTSC
+  // keep the timed calls between the two reads
+  _mm_lfence();
+  uint64_t ticks = __rdtsc();
+  _mm_lfence();
+  return ticks;
+#else
+  return now_ns();
+#endif
+}
+
+static int compare_uint64(const void *a, const void *b) {
+  uint64_t ua = *(const uint64_t *)a;
+  uint64_t ub = *(const uint64_t *)b;
+  return (ua > ub) - (ua < ub);
+}
+
+static uint32_t float_bits(float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  return bits;
+}
+
+static float bits_float(uint32_t bits) {
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+static int run_reader(int n_paths, char *paths[], int repetitions) {
+  char dir[] = "/tmp/itemp_bench_XXXXXX";
+  char *scratch[SCRATCH_FILES];
+  bool made_scratch = (n_paths == 0);
+  itemp_reader_backend_t backends[] = {ITEMP_READER_PREAD,
+                                       ITEMP_READER_IO_URING};
+  const char *names[] = {"pread", "io_uring"};
+  int status = 0;
+
+  if (made_scratch) {
+    uint32_t seed = 0x89abcdef;
+    itemp_t *block = malloc(SCRATCH_FILE_BYTES);
+    if (block == NULL || mkdtemp(dir) == NULL) {
+      fprintf(stderr, "cannot create scratch files\n");
+      return 1;
+    }
+    for (size_t i = 0; i < SCRATCH_FILE_BYTES / sizeof(itemp_t); i++) {
+      block[i] = (itemp_t)xorshift32(&seed);
+    }
+    for (int f = 0; f < SCRATCH_FILES; f++) {
+      scratch[f] = malloc(sizeof(dir) + 16);
+      snprintf(scratch[f], sizeof(dir) + 16, "%s/%d.bin", dir, f);
+      FILE *fp = fopen(scratch[f], "wb");
+      if (fp == NULL) {
+        fprintf(stderr, "%s: %s\n", scratch[f], strerror(errno));
+        return 1;
+      }
+      fwrite(block, 1, SCRATCH_FILE_BYTES, fp);
+      fclose(fp);
+    }
+    free(block);
+    n_paths = SCRATCH_FILES;
+    paths = scratch;
+  }
+
+  if (!itemp_reader_has_io_uring()) {
+    printf("io_uring unavailable: that backend falls back to pread\n");
+  }
+  printf("%-10s %12s %12s %12s\n", "backend", "MB/s", "Msamples/s", "seconds");
+  for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++) {
+    itemp_reader_config_t config;
+    double best = 0.0;
+    itemp_stats_t stats;
+
+    itemp_reader_config_init(&config);
+    config.backend = backends[b];
+    for (int r = 0; r < repetitions; r++) {
+      itemp_stats_init(&stats);
+      uint64_t start = now_ns();
+      int err = itemp_reader_scan(&config, (const char *const *)paths,
+                                  n_paths, reader_accumulate, &stats);
+      double seconds = (now_ns() - start) / 1e9;
+      if (err != 0) {
+        fprintf(stderr, "%s: %s\n", names[b], strerror(-err));
+        status = 1;
+        break;
+      }
+      if (r == 0 || seconds < best) {
+        best = seconds;
+      }
+    }
+    if (status == 0) {
+      double bytes = (double)stats.count * sizeof(itemp_t);
+      printf("%-10s %12.1f %12.1f %12.4f\n", names[b], bytes / best / 1e6,
+             stats.count / best / 1e6, best);
+    }
+  }
+
+  if (made_scratch) {
+    for (int f = 0; f < SCRATCH_FILES; f++) {
+      remove(scratch[f]);
+      free(scratch[f]);
+    }
+    rmdir(dir);
+  }
+  return status;
+}
+
+static void reader_accumulate(void *arg, size_t file_index, uint64_t offset,
+                              const itemp_t *itemps, size_t n) {
+  (void)file_index;
+  (void)offset;
+  itemp_stats_update(arg, itemps, n);
+}
+
+// =============================================================================
+// kernels
+
+static void k_itemp_to_fahrenheit_100(bench_data_t *data) {
+  for (size_t i = 0; i < data->n; i++) {
+    data->out_100[i] = itemp_to_fahrenheit_100(data->itemps[i]);
+  }
+}
+
+static void k_itemp_to_fahrenheit_1(bench_data_t *data) {
+  for (size_t i = 0; i < data->n; i++) {
+    data->out_100[i] = itemp_to_fahrenheit_1(data->itemps[i]);
+  }
+}
+
+static void k_itemp_to_celsius_100(bench_data_t *data) {
+  for (size_t i = 0; i < data->n; i++) {
+    data->out_100[i] = itemp_to_celsius_100(data->itemps[i]);
+  }
+}
+
+static void k_fahrenheit_100_to_itemp(bench_data_t *data) {
+  for (size_t i = 0; i < data->n; i++) {
+    data->out_itemps[i] = fahrenheit_100_to_itemp(data->values_100[i]);
+  }
+}
+
+static void k_itemp_to_fahrenheit_100_batch(bench_data_t *data) {
+  itemp_to_fahrenheit_100_batch(data->itemps, data->out_100, data->n);
+}
+
+static void k_itemp_to_fahrenheit_1_batch(bench_data_t *data) {
+  itemp_to_fahrenheit_1_batch(data->itemps, data->out_100, data->n);
+}
+
+static void k_itemp_to_celsius_100_batch(bench_data_t *data) {
+  itemp_to_celsius_100_batch(data->itemps, data->out_100, data->n);
+}
+
+static void k_fahrenheit_100_to_itemp_batch(bench_data_t *data) {
+  fahrenheit_100_to_itemp_batch(data->values_100, data->out_itemps, data->n);
+}
+
+static void k_fahrenheit_100_round_trip_inplace(bench_data_t *data) {
+  // two conversions per element, leaving the buffer as it was
+  itemp_t *itemps = fahrenheit_100_to_itemp_inplace(data->values_100, data->n);
+  itemp_to_fahrenheit_100_inplace(itemps, data->n);
+}
+
+static void k_itemp_to_kelvin_100_scale_batch(bench_data_t *data) {
+  itemp_to_scale_batch(&data->kelvin_100, data->itemps, data->out_32, data->n);
+}
+
+static void k_itemp_to_celsius_100_stride_8(bench_data_t *data) {
+  itemp_convert_strided(ITEMP_TO_CELSIUS_100, data->records, 8,
+                        data->records + 2, 8, data->n);
+}
+
+static void k_itemp_to_celsius_100_stride_12(bench_data_t *data) {
+  itemp_convert_strided(ITEMP_TO_CELSIUS_100, data->records, 12,
+                        data->records + 2, 12, data->n);
+}
+
+static void k_argmax(bench_data_t *data) {
+  data->out_32[0] = (int32_t)itemp_argmax(data->itemps, data->n);
+}
+
+static void k_top_100(bench_data_t *data) {
+  size_t indices[100];
+  itemp_top_k(data->itemps, data->n, 100, indices, data->out_itemps);
+}
+
+static void k_correlate_64(bench_data_t *data) {
+  // the data as 64 series; ns per element covers all 2080 pairs
+  static double matrix[64 * 64];
+  const itemp_t *columns[64];
+  for (int j = 0; j < 64; j++) {
+    columns[j] = data->itemps + j * (data->n / 64);
+  }
+  itemp_correlate(columns, 64, data->n / 64, matrix, 1);
+}
+
+static void k_stats_update(bench_data_t *data) {
+  itemp_stats_update(&data->stats, data->itemps, data->n);
+}
+
+static void k_histogram_update(bench_data_t *data) {
+  itemp_histogram_update(data->histogram, data->itemps, data->n);
+}
+
+static void k_workload_fleet(bench_data_t *data) {
+  itemp_workload_generate_fleet(&data->workload, data->out_itemps, NULL, NULL,
+                                data->n);
+}
@@ -0,0 +1,138 @@
+/** @file itemp_convert.hpp
+ * Conversions between itemp and a (unit, resolution) pair chosen at compile
+ * time:
+ *
+ * @code
+ * int16_t f = itemp::convert<itemp::fahrenheit, 1>::from_itemp(itemp);
+ * itemp_t t = itemp::convert<itemp::celsius, 10>::to_itemp(c10);
+ * itemp::convert<itemp::celsius, 100>::from_itemp(itemps, c100, n);
+ * @endcode
+ *
+ * itemp_to_fahrenheit_1() and friends round to hundredths first and then round
+ * again to the requested resolution.  Here the two roundings are folded into a
+ * single division by a constant, with the same results, which the compiler
+ * turns into a multiply and shift.  Requires C++17.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_CONVERT_HPP_
+#define _ITEMP_CONVERT_HPP_
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace itemp {
+
+// =============================================================================
+// types and definitions
+
+/**
+ * @brief Unit tags: value_100 = rquo(itemp, slope) - offset.
+ */
+struct fahrenheit {
+  static constexpr int32_t slope = ITEMP_ONE_HUNDRETH_DEGREE_F;
+  static constexpr int32_t offset = -ITEMP_MIN_FAHRENHEIT_100;
+};
+
+struct celsius {
+  static constexpr int32_t slope = ITEMP_ONE_HUNDRETH_DEGREE_C;
+  static constexpr int32_t offset = -ITEMP_MIN_CELSIUS_100;
+};
+
+/**
+ * @brief Conversion between itemp and whole degrees (Resolution 1), tenths
+ * (10) or hundredths (100) of Unit.
+ */
+template <class Unit, int Resolution>
+struct convert {
+  static_assert(Resolution == 1 || Resolution == 10 || Resolution == 100,
+                "Resolution must be 1, 10 or 100");
+
+  // Hundredths per output step, and the combined divisor.
+  static constexpr int32_t step = 100 / Resolution;
+  static constexpr uint32_t divisor = Unit::slope * step;
+
+  // rquo(itemp, slope) rounds up at slope / 2 and is never negative, so it is
+  // floor((itemp + slope / 2) / slope).  rquo(value_100, step) is
+  // floor((value_100 + step / 2) / step) when value_100 >= 0 and
+  // floor((value_100 + step - 1 - step / 2) / step) when it is negative.
+  // Nested floors of integers compose, so the result is a single
+  // floor((itemp + add) / divisor), with add chosen by the sign of
+  // value_100.  bias multiples of divisor keep the numerator positive.
+  static constexpr uint32_t threshold =
+      Unit::offset * Unit::slope - Unit::slope / 2;
+  static constexpr int32_t bias =
+      (Unit::offset * Unit::slope + divisor - 1) / divisor;
+  static constexpr uint32_t add_pos = Unit::slope / 2 +
+                                      (step / 2 - Unit::offset) * Unit::slope +
+                                      bias * divisor;
+  static constexpr uint32_t add_neg =
+      Unit::slope / 2 + (step - 1 - step / 2 - Unit::offset) * Unit::slope +
+      bias * divisor;
+
+  /**
+   * Convert an itemp value to Unit at Resolution.  The same as, e.g.,
+   * itemp_to_fahrenheit_1() but with one division instead of two.
+   */
+  static constexpr int16_t from_itemp(itemp_t itemp) {
+    uint32_t t = itemp;
+    uint32_t add = (t >= threshold) ? add_pos : add_neg;
+    return (int16_t)((int32_t)((t + add) / divisor) - bias);
+  }
+
+  /**
+   * Convert a value in Unit at Resolution to itemp, wrapping like, e.g.,
+   * fahrenheit_1_to_itemp().
+   */
+  static constexpr itemp_t to_itemp(int16_t value) {
+    return (itemp_t)(value * (step * Unit::slope) +
+                     Unit::offset * Unit::slope);
+  }
+
+  /**
+   * Convert n itemp values.
+   */
+  static void from_itemp(const itemp_t *itemps, int16_t *values, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      values[i] = from_itemp(itemps[i]);
+    }
+  }
+
+  /**
+   * Convert n values to itemp.
+   */
+  static void to_itemp(const int16_t *values, itemp_t *itemps, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+      itemps[i] = to_itemp(values[i]);
+    }
+  }
+};
+
+}  // namespace itemp
+
+#endif /* #ifndef _ITEMP_CONVERT_HPP_ */
@@ -0,0 +1,100 @@
+/** @file itemp_convert_test.cpp
+ * Unit tests for itemp_convert.hpp.
+ *
+ * To run tests on a unix-like system:
+ *   cc -Wall -c itemp.c
+ *   c++ -std=c++17 -Wall -o itemp_convert_test itemp_convert_test.cpp itemp.o
+ *   ./itemp_convert_test
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp_convert.hpp"
+#include "itemp_unit_test.h"
+#include <vector>
+
+// =============================================================================
+// self test
+
+using f_1 = itemp::convert<itemp::fahrenheit, 1>;
+using f_10 = itemp::convert<itemp::fahrenheit, 10>;
+using f_100 = itemp::convert<itemp::fahrenheit, 100>;
+using c_1 = itemp::convert<itemp::celsius, 1>;
+using c_10 = itemp::convert<itemp::celsius, 10>;
+using c_100 = itemp::convert<itemp::celsius, 100>;
+
+// usable in constant expressions
+static_assert(f_1::from_itemp(f_1::to_itemp(72)) == 72, "");
+static_assert(c_10::from_itemp(c_10::to_itemp(-125)) == -125, "");
+
+/**
+ * @brief Compare a conversion against the chained functions in itemp.c, for
+ * every itemp and every int16_t.
+ */
+template <class Convert>
+static int count_mismatches(int16_t (*to)(itemp_t), itemp_t (*from)(int16_t)) {
+  std::vector<itemp_t> itemps(65536), out_itemps(65536);
+  std::vector<int16_t> values(65536), out_values(65536);
+  int mismatches = 0;
+
+  for (int i = 0; i < 65536; i++) {
+    itemps[i] = (itemp_t)i;
+    values[i] = (int16_t)(i - 32768);
+  }
+  Convert::from_itemp(itemps.data(), out_values.data(), itemps.size());
+  Convert::to_itemp(values.data(), out_itemps.data(), values.size());
+  for (int i = 0; i < 65536; i++) {
+    mismatches += (Convert::from_itemp(itemps[i]) != to(itemps[i]));
+    mismatches += (out_values[i] != to(itemps[i]));
+    mismatches += (Convert::to_itemp(values[i]) != from(values[i]));
+    mismatches += (out_itemps[i] != from(values[i]));
+  }
+  return mismatches;
+}
+
+int main() {
+  printf("Beginning unit tests...");
+
+  ASSERT_INT(count_mismatches<f_1>(itemp_to_fahrenheit_1,
+                                   fahrenheit_1_to_itemp), 0);
+  ASSERT_INT(count_mismatches<f_10>(itemp_to_fahrenheit_10,
+                                    fahrenheit_10_to_itemp), 0);
+  ASSERT_INT(count_mismatches<f_100>(itemp_to_fahrenheit_100,
+                                     fahrenheit_100_to_itemp), 0);
+  ASSERT_INT(count_mismatches<c_1>(itemp_to_celsius_1, celsius_1_to_itemp), 0);
+  ASSERT_INT(count_mismatches<c_10>(itemp_to_celsius_10,
+                                    celsius_10_to_itemp), 0);
+  ASSERT_INT(count_mismatches<c_100>(itemp_to_celsius_100,
+                                     celsius_100_to_itemp), 0);
+
+  // ties round away from zero on both sides of zero
+  ASSERT_INT(f_1::from_itemp(fahrenheit_100_to_itemp(50)), 1);
+  ASSERT_INT(f_1::from_itemp(fahrenheit_100_to_itemp(-50)), -1);
+  ASSERT_INT(c_10::from_itemp(celsius_100_to_itemp(-15)), -2);
+  ASSERT_INT(c_10::from_itemp(celsius_100_to_itemp(-14)), -1);
+
+  printf("\r\n...unit tests complete.\r\n");
+}
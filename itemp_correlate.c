@@ -0,0 +1,438 @@
+/** @file itemp_correlate.c
+ * Pearson correlation between aligned series of itemp values.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp_correlate.h"
+#include "itemp_stats.h"
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+// =============================================================================
+// local types and definitions
+
+// Columns per tile, and values per column centered at a time.  Two tiles of
+// centered values (2 * 16 * 2048 * 4 bytes at most) stay in L2 while every
+// pair between them is multiplied.
+#define TILE_COLUMNS 16
+#define CHUNK_VALUES 2048
+#define DOT_LANES 16
+
+#define MAX_THREADS 64
+
+typedef struct {
+  const itemp_t *const *columns;
+  size_t n_columns;
+  size_t n;
+  const int32_t *centers;  // rounded mean of each column
+  const int32_t *spans;    // largest |value - center| in each column
+  bool narrow;             // every centered value fits in 16 bits
+  int64_t *products;       // sum of centered products, row by row
+  int n_threads;
+} job_t;
+
+typedef struct {
+  job_t *job;
+  int thread;
+  int result;
+} worker_t;
+
+// =============================================================================
+// local (forward) declarations
+
+/**
+ * @brief Accumulate the products for this worker's share of the tile pairs.
+ */
+static void *correlate_worker(void *arg);
+
+/**
+ * @brief Copy values [start, start + len) of the columns of a tile into buf,
+ * less their centers, one column after another.
+ */
+static void center_tile(const job_t *job, size_t tile, size_t start,
+                        size_t len, void *buf);
+
+/**
+ * @brief Return the sum of a[i] * b[i], with each of DOT_LANES 32 bit
+ * partial sums holding at most `block` products before it is flushed.
+ */
+static int64_t dot_16(const int16_t *a, const int16_t *b, size_t n,
+                      size_t block);
+
+/**
+ * @brief Return the sum of a[i] * b[i] in 64 bits.
+ */
+static int64_t dot_32(const int32_t *a, const int32_t *b, size_t n);
+
+// =============================================================================
+// local storage
+
+// =============================================================================
+// public code
+
+int itemp_correlate(const itemp_t *const *columns, size_t n_columns, size_t n,
+                    double *matrix, int n_threads) {
+  size_t m = n_columns;
+  int32_t *centers = malloc(m * sizeof(int32_t));
+  int32_t *spans = malloc(m * sizeof(int32_t));
+  int64_t *sums = malloc(m * sizeof(int64_t));
+  int64_t *products = calloc(m * m, sizeof(int64_t));
+  worker_t workers[MAX_THREADS];
+  pthread_t threads[MAX_THREADS];
+  job_t job;
+  int result = 0;
+
+  if (!centers || !spans || !sums || !products) {
+    result = -ENOMEM;
+    goto done;
+  }
+
+  // center each column on its rounded mean
+  job.narrow = true;
+  for (size_t j = 0; j < m; j++) {
+    itemp_stats_t stats;
+    itemp_stats_init(&stats);
+    itemp_stats_update(&stats, columns[j], n);
+    centers[j] = itemp_stats_mean(&stats);
+    spans[j] = centers[j] - stats.min;
+    if (stats.max - centers[j] > spans[j]) {
+      spans[j] = stats.max - centers[j];
+    }
+    // -32768 is excluded so that a pair of products cannot reach 2^31
+    job.narrow = job.narrow && spans[j] <= INT16_MAX;
+    // the sum of the centered values, which is small but rarely zero
+    sums[j] = (int64_t)(stats.sum - (uint64_t)n * (uint64_t)centers[j]);
+  }
+
+  job.columns = columns;
+  job.n_columns = m;
+  job.n = n;
+  job.centers = centers;
+  job.spans = spans;
+  job.products = products;
+  job.n_threads = (n_threads < 1) ? 1 : (n_threads > MAX_THREADS)
+                                            ? MAX_THREADS
+                                            : n_threads;
+  for (int i = 0; i < job.n_threads; i++) {
+    workers[i].job = &job;
+    workers[i].thread = i;
+    workers[i].result = 0;
+    if (i == 0 || pthread_create(&threads[i], NULL, correlate_worker,
+                                 &workers[i]) != 0) {
+      // thread 0, or one that could not start, runs on this thread later
+      threads[i] = pthread_self();
+    }
+  }
+  for (int i = 0; i < job.n_threads; i++) {
+    if (pthread_equal(threads[i], pthread_self())) {
+      correlate_worker(&workers[i]);
+    }
+  }
+  for (int i = 0; i < job.n_threads; i++) {
+    if (!pthread_equal(threads[i], pthread_self())) {
+      pthread_join(threads[i], NULL);
+    }
+    if (workers[i].result != 0) {
+      result = workers[i].result;
+    }
+  }
+  if (result != 0) {
+    goto done;
+  }
+
+  // The sums are about the rounded means c rather than the true means, so
+  // remove the difference: sum((x - mx)(y - my)) = sum((x - cx)(y - cy)) -
+  // sx * sy / n, with sx = sum(x - cx).
+  for (size_t i = 0; i < m; i++) {
+    for (size_t j = i; j < m; j++) {
+      double cov = (double)products[i * m + j] -
+                   (double)sums[i] * (double)sums[j] / (double)n;
+      double var_i = (double)products[i * m + i] -
+                     (double)sums[i] * (double)sums[i] / (double)n;
+      double var_j = (double)products[j * m + j] -
+                     (double)sums[j] * (double)sums[j] / (double)n;
+      double r = (var_i > 0.0 && var_j > 0.0) ? cov / sqrt(var_i * var_j)
+                                               : NAN;
+      // rounding can carry |r| a hair past 1
+      r = (r > 1.0) ? 1.0 : (r < -1.0) ? -1.0 : r;
+      matrix[i * m + j] = r;
+      matrix[j * m + i] = r;
+    }
+  }
+
+done:
+  free(centers);
+  free(spans);
+  free(sums);
+  free(products);
+  return result;
+}
+
+// =============================================================================
+// local (static) code
+
+static void *correlate_worker(void *arg) {
+  worker_t *worker = arg;
+  const job_t *job = worker->job;
+  size_t m = job->n_columns;
+  size_t n_tiles = (m + TILE_COLUMNS - 1) / TILE_COLUMNS;
+  size_t buf_bytes = TILE_COLUMNS * CHUNK_VALUES * sizeof(int32_t);
+  void *a_buf = malloc(buf_bytes);
+  void *b_buf = malloc(buf_bytes);
+  size_t pair = 0;
+
+  if (!a_buf || !b_buf) {
+    worker->result = -ENOMEM;
+    goto done;
+  }
+
+  // tile pairs (ti, tj) with ti <= tj are dealt out round robin
+  for (size_t ti = 0; ti < n_tiles; ti++) {
+    for (size_t tj = ti; tj < n_tiles; tj++, pair++) {
+      if (pair % job->n_threads != (size_t)worker->thread) {
+        continue;
+      }
+      size_t i0 = ti * TILE_COLUMNS;
+      size_t j0 = tj * TILE_COLUMNS;
+      size_t i1 = (i0 + TILE_COLUMNS < m) ? i0 + TILE_COLUMNS : m;
+      size_t j1 = (j0 + TILE_COLUMNS < m) ? j0 + TILE_COLUMNS : m;
+
+      for (size_t start = 0; start < job->n; start += CHUNK_VALUES) {
+        size_t len =
+            (job->n - start < CHUNK_VALUES) ? job->n - start : CHUNK_VALUES;
+        center_tile(job, ti, start, len, a_buf);
+        if (tj != ti) {
+          center_tile(job, tj, start, len, b_buf);
+        }
+        const void *b_tile = (tj != ti) ? b_buf : a_buf;
+
+        for (size_t i = i0; i < i1; i++) {
+          for (size_t j = (ti == tj) ? i : j0; j < j1; j++) {
+            size_t ai = (i - i0) * CHUNK_VALUES;
+            size_t bj = (j - j0) * CHUNK_VALUES;
+            int64_t product;
+            if (job->narrow) {
+              // each lane sum <= block * span_i * span_j < 2^31
+              int64_t bound = (int64_t)job->spans[i] * job->spans[j];
+              size_t block = (bound > 0) ? (size_t)(INT32_MAX / bound) : len;
+              product = dot_16((const int16_t *)a_buf + ai,
+                               (const int16_t *)b_tile + bj, len,
+                               (block > 0) ? block : 1);
+            } else {
+              product = dot_32((const int32_t *)a_buf + ai,
+                               (const int32_t *)b_tile + bj, len);
+            }
+            job->products[i * m + j] += product;
+          }
+        }
+      }
+    }
+  }
+
+done:
+  free(a_buf);
+  free(b_buf);
+  return NULL;
+}
+
+static void center_tile(const job_t *job, size_t tile, size_t start,
+                        size_t len, void *buf) {
+  size_t j0 = tile * TILE_COLUMNS;
+  size_t j1 = (j0 + TILE_COLUMNS < job->n_columns) ? j0 + TILE_COLUMNS
+                                                   : job->n_columns;
+  for (size_t j = j0; j < j1; j++) {
+    const itemp_t *column = job->columns[j] + start;
+    int32_t center = job->centers[j];
+    if (job->narrow) {
+      int16_t *out = (int16_t *)buf + (j - j0) * CHUNK_VALUES;
+      for (size_t k = 0; k < len; k++) {
+        out[k] = (int16_t)(column[k] - center);
+      }
+    } else {
+      int32_t *out = (int32_t *)buf + (j - j0) * CHUNK_VALUES;
+      for (size_t k = 0; k < len; k++) {
+        out[k] = column[k] - center;
+      }
+    }
+  }
+}
+
+static int64_t dot_16(const int16_t *a, const int16_t *b, size_t n,
+                      size_t block) {
+  int64_t total = 0;
+  size_t i = 0;
+  // Each of the DOT_LANES partial sums holds at most `block` products, so the
+  // blocks are DOT_LANES times longer than with a single 32 bit sum.  The
+  // fixed lane layout compiles to pmaddwd (vpdpwssd with AVX-VNNI).
+  while (n - i >= DOT_LANES) {
+    int32_t lanes[DOT_LANES] = {0};
+    size_t rows = (n - i) / DOT_LANES;
+    size_t stop = i + ((rows < block) ? rows : block) * DOT_LANES;
+    for (; i < stop; i += DOT_LANES) {
+      for (size_t l = 0; l < DOT_LANES; l++) {
+        lanes[l] += a[i + l] * b[i + l];
+      }
+    }
+    for (size_t l = 0; l < DOT_LANES; l++) {
+      total += lanes[l];
+    }
+  }
+  for (; i < n; i++) {
+    total += a[i] * b[i];
+  }
+  return total;
+}
+
+static int64_t dot_32(const int32_t *a, const int32_t *b, size_t n) {
+  int64_t sum = 0;
+  for (size_t i = 0; i < n; i++) {
+    sum += (int64_t)a[i] * b[i];
+  }
+  return sum;
+}
+
+// =============================================================================
+// self test
+
+// To run tests on a unix-like system:
+//   cc -Wall -c itemp.c itemp_stats.c
+//   cc -Wall -DUNIT_TEST -c itemp_correlate.c
+//   cc -o itemp_correlate itemp_correlate.o itemp.o itemp_stats.o -lm -lpthread
+//   ./itemp_correlate
+
+#ifdef UNIT_TEST
+
+#include "itemp_unit_test.h"
+#include <stdio.h>
+
+#define N_COLUMNS 37
+#define N_VALUES 10007
+
+static itemp_t s_values[N_COLUMNS][N_VALUES];
+static const itemp_t *s_columns[N_COLUMNS];
+static double s_matrix[N_COLUMNS * N_COLUMNS];
+
+/**
+ * @brief The textbook two pass correlation, in double precision.
+ */
+static double reference_correlation(size_t a, size_t b, size_t n) {
+  double ma = 0.0, mb = 0.0, sab = 0.0, saa = 0.0, sbb = 0.0;
+  for (size_t k = 0; k < n; k++) {
+    ma += s_values[a][k];
+    mb += s_values[b][k];
+  }
+  ma /= n;
+  mb /= n;
+  for (size_t k = 0; k < n; k++) {
+    double da = s_values[a][k] - ma;
+    double db = s_values[b][k] - mb;
+    sab += da * db;
+    saa += da * da;
+    sbb += db * db;
+  }
+  return sab / sqrt(saa * sbb);
+}
+
+/**
+ * @brief Count the entries of s_matrix that differ from the reference by
+ * 1e-9 or more.
+ */
+static int count_mismatches(size_t m, size_t n) {
+  int mismatches = 0;
+  for (size_t i = 0; i < m; i++) {
+    for (size_t j = 0; j < m; j++) {
+      double expected = reference_correlation(i, j, n);
+      double observed = s_matrix[i * m + j];
+      if (isnan(expected) || isnan(observed)) {
+        mismatches += (isnan(expected) != isnan(observed));
+      } else {
+        mismatches += (fabs(observed - expected) >= 1e-9);
+      }
+    }
+  }
+  return mismatches;
+}
+
+int main() {
+  printf("Beginning unit tests...");
+
+  // a shared daily cycle plus sensor noise; some sensors are offset, some
+  // inverted, some unrelated, and one is stuck
+  srand(3);
+  for (size_t k = 0; k < N_VALUES; k++) {
+    double cycle = 4000.0 * sin(k * 0.01);
+    for (size_t j = 0; j < N_COLUMNS; j++) {
+      double noise = (rand() % 2001 - 1000) * (1.0 + j % 5);
+      double v = fahrenheit_1_to_itemp(60 + j);
+      if (j % 7 == 3) {
+        v -= cycle;
+      } else if (j % 7 != 5) {
+        v += cycle;
+      }
+      s_values[j][k] = (itemp_t)(v + noise);
+    }
+    s_values[N_COLUMNS - 1][k] = fahrenheit_1_to_itemp(72);
+  }
+  for (size_t j = 0; j < N_COLUMNS; j++) {
+    s_columns[j] = s_values[j];
+  }
+
+  ASSERT_INT(itemp_correlate(s_columns, N_COLUMNS, N_VALUES, s_matrix, 1), 0);
+  ASSERT_INT(count_mismatches(N_COLUMNS, N_VALUES), 0);
+  ASSERT_EPS(s_matrix[0], 1.0, 1e-12);
+  ASSERT_INT(s_matrix[3] < -0.5, 1);
+  ASSERT_INT(isnan(s_matrix[N_COLUMNS - 1]), 1);
+
+  // the same with several threads, and fewer values than one chunk
+  ASSERT_INT(itemp_correlate(s_columns, N_COLUMNS, N_VALUES, s_matrix, 4), 0);
+  ASSERT_INT(count_mismatches(N_COLUMNS, N_VALUES), 0);
+  ASSERT_INT(itemp_correlate(s_columns, 20, 100, s_matrix, 3), 0);
+  ASSERT_INT(count_mismatches(20, 100), 0);
+
+  // a column that swings across the whole itemp range takes the 32 bit path
+  for (size_t k = 0; k < N_VALUES; k++) {
+    s_values[1][k] = (k % 3 == 0) ? 0 : 65535;
+    s_values[2][k] = (k % 3 == 0) ? 1000 : 64000 + (k % 17);
+  }
+  ASSERT_INT(itemp_correlate(s_columns, N_COLUMNS, N_VALUES, s_matrix, 2), 0);
+  ASSERT_INT(count_mismatches(N_COLUMNS, N_VALUES), 0);
+
+  // the largest narrow spans, where each block holds a single product
+  for (size_t k = 0; k < N_VALUES; k++) {
+    s_values[1][k] = (k & 1) ? 32768 + 32767 : 32768 - 32767;
+    s_values[2][k] = (k % 3) ? 32768 + 32767 : 32768 - 32767;
+  }
+  ASSERT_INT(itemp_correlate(s_columns, 3, N_VALUES, s_matrix, 1), 0);
+  ASSERT_INT(count_mismatches(3, N_VALUES), 0);
+
+  printf("\r\n...unit tests complete.\r\n");
+}
+
+#endif
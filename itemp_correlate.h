@@ -0,0 +1,74 @@
+/** @file itemp_correlate.h
+ * Pearson correlation between aligned series of itemp values, for finding
+ * sensors that are mislabeled or drifting away from their neighbours.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_CORRELATE_H_
+#define _ITEMP_CORRELATE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// types and definitions
+
+// =============================================================================
+// declarations
+
+/**
+ * Compute the matrix of Pearson correlations between n_columns series of n
+ * itemp values each, sampled at the same times.
+ *
+ * Each series is centered on its rounded mean.  When every centered value
+ * fits in 16 bits, as it does for any series that stays within 65F of its
+ * mean, the cross products are 16 bit dot products that the compiler turns
+ * into multiply-add instructions (pmaddwd, or vpdpwssd with VNNI), summed in
+ * 32 bits over blocks short enough that they cannot overflow.  Columns are
+ * taken in tiles that stay in cache, and tiles are shared among threads.
+ *
+ * @param columns columns[j] points to the n values of series j.
+ * @param n_columns The number of series.
+ * @param n The number of values in each series.
+ * @param matrix Receives n_columns * n_columns correlations, row by row.  The
+ * correlation with a constant series is NaN.
+ * @param n_threads The number of threads to use, 1 or more.
+ * @returns 0 on success or -ENOMEM.
+ */
+int itemp_correlate(const itemp_t *const *columns, size_t n_columns, size_t n,
+                    double *matrix, int n_threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _ITEMP_CORRELATE_H_ */
@@ -0,0 +1,365 @@
+/** @file itemp_counters.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp_counters.h"
+#include <string.h>
+
+#ifdef ITEMP_INSTRUMENT
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#endif
+
+// =============================================================================
+// local types and definitions
+
+#ifdef ITEMP_INSTRUMENT
+
+/**
+ * @brief One thread's counters, linked into the list of every thread's.
+ */
+typedef struct block {
+  _Atomic uint64_t slots[ITEMP_COUNTER_SLOTS];
+  struct block *next;
+} block_t;
+
+#endif
+
+// =============================================================================
+// local (forward) declarations
+
+#ifdef ITEMP_INSTRUMENT
+
+/**
+ * @brief Return the counter that itemp_counters_countdown[index] adds to.
+ */
+static size_t countdown_slot(size_t index);
+
+/**
+ * @brief Return the calls this thread has counted down in
+ * itemp_counters_countdown[index] but not yet added to its counters.
+ */
+static uint64_t unflushed(size_t index);
+
+/**
+ * @brief Create s_exit_key, once.
+ */
+static void make_exit_key(void);
+
+/**
+ * @brief Add a thread's unflushed calls to its counters as it exits.
+ */
+static void flush_on_exit(void *block);
+
+#endif
+
+// =============================================================================
+// local storage
+
+#ifdef ITEMP_INSTRUMENT
+
+_Thread_local _Atomic uint64_t *itemp_counters_local;
+
+// Blocks are pushed at the head and never removed.
+static _Atomic(block_t *) s_blocks;
+
+// Shared by threads whose block could not be allocated.  Concurrent counts
+// into it may be lost, but never corrupt anything.
+static block_t s_fallback;
+
+// Every byte starts at 0, so a thread's first call of each kind is flushed
+// at once, which attaches its block; after that, one call in 256 is.
+_Thread_local uint8_t itemp_counters_countdown[ITEMP_CONVERSION_COUNT + 1];
+
+// Whether this thread has flushed each countdown before: the first flush
+// adds one call and the rest add 256.
+static _Thread_local bool s_flushed[ITEMP_CONVERSION_COUNT + 1];
+
+// Set to each thread's block, so that flush_on_exit() runs as it exits.
+static pthread_once_t s_exit_once = PTHREAD_ONCE_INIT;
+static pthread_key_t s_exit_key;
+static bool s_exit_key_made;
+
+#endif
+
+// =============================================================================
+// public code
+
+void itemp_counters_snapshot(itemp_counters_t *counters) {
+  memset(counters, 0, sizeof(*counters));
+#ifdef ITEMP_INSTRUMENT
+  uint64_t *sums = (uint64_t *)counters;
+  block_t *block = atomic_load_explicit(&s_blocks, memory_order_acquire);
+  for (; block != NULL; block = block->next) {
+    for (size_t i = 0; i < ITEMP_COUNTER_SLOTS; i++) {
+      sums[i] += atomic_load_explicit(&block->slots[i], memory_order_relaxed);
+    }
+  }
+  for (size_t i = 0; i < ITEMP_COUNTER_SLOTS; i++) {
+    sums[i] += atomic_load_explicit(&s_fallback.slots[i],
+                                    memory_order_relaxed);
+  }
+  for (size_t i = 0; i <= ITEMP_CONVERSION_COUNT; i++) {
+    sums[countdown_slot(i)] += unflushed(i);
+  }
+#endif
+}
+
+uint64_t itemp_counters_conversions(const itemp_counters_t *counters) {
+  uint64_t total = 0;
+  for (size_t i = 0; i < ITEMP_CONVERSION_COUNT; i++) {
+    total += counters->calls[i] + counters->batch_values[i];
+  }
+  return total;
+}
+
+#ifdef ITEMP_INSTRUMENT
+
+_Atomic uint64_t *itemp_counters_attach(void) {
+  block_t *block = calloc(1, sizeof(block_t));
+  if (block == NULL) {
+    return s_fallback.slots;
+  }
+  block->next = atomic_load_explicit(&s_blocks, memory_order_relaxed);
+  while (!atomic_compare_exchange_weak_explicit(&s_blocks, &block->next, block,
+                                                memory_order_release,
+                                                memory_order_relaxed)) {
+  }
+  itemp_counters_local = block->slots;
+  pthread_once(&s_exit_once, make_exit_key);
+  if (s_exit_key_made) {
+    pthread_setspecific(s_exit_key, block);
+  }
+  return block->slots;
+}
+
+void itemp_counters_flush(size_t index) {
+  // the countdown has already wrapped around to 255
+  itemp_counters_add(countdown_slot(index), s_flushed[index] ? 256 : 1);
+  s_flushed[index] = true;
+}
+
+uint64_t itemp_counters_out_of_range(const int16_t *values, size_t n,
+                                     int16_t min, int16_t max) {
+  // Inputs are almost always in range, and the smallest and largest are
+  // cheaper to find (a vector min and max per load) than a count.
+  int16_t lo = INT16_MAX;
+  int16_t hi = INT16_MIN;
+  for (size_t i = 0; i < n; i++) {
+    lo = (values[i] < lo) ? values[i] : lo;
+    hi = (values[i] > hi) ? values[i] : hi;
+  }
+  if (lo >= min && hi <= max) {
+    return 0;
+  }
+  // count in 16 bit lanes, a block at a time
+  uint16_t range = (uint16_t)(max - min);
+  uint64_t count = 0;
+  while (n > 0) {
+    size_t len = (n < UINT16_MAX) ? n : UINT16_MAX;
+    uint16_t block = 0;
+    for (size_t i = 0; i < len; i++) {
+      block += (uint16_t)(values[i] - min) > range;
+    }
+    count += block;
+    values += len;
+    n -= len;
+  }
+  return count;
+}
+
+#endif
+
+// =============================================================================
+// local (static) code
+
+#ifdef ITEMP_INSTRUMENT
+
+static size_t countdown_slot(size_t index) {
+  return (index < ITEMP_CONVERSION_COUNT)
+             ? ITEMP_COUNTER_SLOT(calls, index)
+             : ITEMP_COUNTER_SLOT(delta_calls, 0);
+}
+
+static uint64_t unflushed(size_t index) {
+  return s_flushed[index] ? 255 - itemp_counters_countdown[index] : 0;
+}
+
+static void make_exit_key(void) {
+  s_exit_key_made = pthread_key_create(&s_exit_key, flush_on_exit) == 0;
+}
+
+static void flush_on_exit(void *block) {
+  (void)block;
+  for (size_t i = 0; i <= ITEMP_CONVERSION_COUNT; i++) {
+    itemp_counters_add(countdown_slot(i), unflushed(i));
+    s_flushed[i] = false;
+  }
+}
+
+#endif
+
+// =============================================================================
+// self test
+
+// To run tests on a unix-like system:
+//   cc -Wall -DITEMP_INSTRUMENT -c itemp.c itemp_batch.c
+//   cc -Wall -DITEMP_INSTRUMENT -DUNIT_TEST -c itemp_counters.c
+//   cc -o itemp_counters itemp_counters.o itemp.o itemp_batch.o -lpthread
+//   ./itemp_counters
+
+#ifdef UNIT_TEST
+
+#include "itemp_unit_test.h"
+#include <pthread.h>
+
+#define THREADS 4
+#define THREAD_CALLS 1000
+
+// Stands in for a backend from itemp_tune.h.
+static void copy_backend(const void *src, void *dst, size_t n) {
+  memcpy(dst, src, n * sizeof(uint16_t));
+}
+
+static void *convert_in_thread(void *arg) {
+  (void)arg;
+  for (int i = 0; i < THREAD_CALLS; i++) {
+    (void)itemp_to_celsius_10((itemp_t)i);
+  }
+  return NULL;
+}
+
+int main() {
+  printf("Beginning unit tests...");
+
+  itemp_counters_t before;
+  itemp_counters_t after;
+  itemp_counters_snapshot(&before);
+
+  // scalar conversions, two of which wrap
+  (void)fahrenheit_100_to_itemp(ITEMP_MAX_FAHRENHEIT_100);
+  (void)fahrenheit_100_to_itemp(ITEMP_MAX_FAHRENHEIT_100 + 1);
+  (void)fahrenheit_1_to_itemp(-16);
+  (void)celsius_10_to_itemp(-264);
+  (void)itemp_to_fahrenheit_1(0);
+
+  // batches, with the out of range inputs at the ends
+  int16_t values[1000];
+  itemp_t itemps[1000];
+  for (int i = 0; i < 1000; i++) {
+    values[i] = (int16_t)(i - 500);
+  }
+  values[0] = ITEMP_MIN_CELSIUS_100 - 1;
+  values[999] = ITEMP_MAX_CELSIUS_100 + 1;
+  celsius_100_to_itemp_batch(values, itemps, 1000);
+  celsius_10_to_itemp_batch(values, itemps, 1000);
+  itemp_to_fahrenheit_100_batch(itemps, values, 3);
+  itemp_to_fahrenheit_100_batch(itemps, values, 0);
+  values[0] = 0;
+  values[1] = ITEMP_MAX_CELSIUS_100 + 1;
+  values[2] = ITEMP_MIN_CELSIUS_100;
+  (void)celsius_100_to_itemp_inplace(values, 3);
+
+  // an installed backend is counted like the loop it replaces
+  values[0] = ITEMP_MIN_FAHRENHEIT_100 / 10 - 1;
+  values[3] = ITEMP_MAX_FAHRENHEIT_100 / 10 + 1;
+  itemp_set_batch_backend(FAHRENHEIT_10_TO_ITEMP, copy_backend);
+  itemp_convert_batch(FAHRENHEIT_10_TO_ITEMP, values, itemps, 4);
+  itemp_set_batch_backend(FAHRENHEIT_10_TO_ITEMP, NULL);
+
+  // a strided conversion is one batch, however many chunks it takes
+  static uint16_t records[2 * 600];
+  itemp_convert_strided(ITEMP_TO_CELSIUS_100, records, 4, records, 4, 600);
+
+  // deltas, three of which saturate
+  (void)itemp_add_delta(1, -2);
+  (void)itemp_add_delta(1, 2);
+  itemps[0] = 0;
+  itemps[1] = 65535;
+  itemps[2] = 65500;
+  itemp_add_delta_batch(itemps, 100, itemps, 3);
+
+  // counts from threads that have exited are kept
+  pthread_t threads[THREADS];
+  for (int i = 0; i < THREADS; i++) {
+    pthread_create(&threads[i], NULL, convert_in_thread, NULL);
+  }
+  for (int i = 0; i < THREADS; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  itemp_counters_snapshot(&after);
+  uint64_t *a = (uint64_t *)&after;
+  const uint64_t *b = (const uint64_t *)&before;
+  for (size_t i = 0; i < sizeof(after) / sizeof(uint64_t); i++) {
+    a[i] -= b[i];
+  }
+
+#ifdef ITEMP_INSTRUMENT
+  ASSERT_INT(after.calls[FAHRENHEIT_100_TO_ITEMP], 2);
+  ASSERT_INT(after.calls[FAHRENHEIT_1_TO_ITEMP], 1);
+  ASSERT_INT(after.calls[CELSIUS_10_TO_ITEMP], 1);
+  ASSERT_INT(after.calls[ITEMP_TO_FAHRENHEIT_1], 1);
+  ASSERT_INT(after.calls[ITEMP_TO_FAHRENHEIT_100], 0);
+  ASSERT_INT(after.calls[ITEMP_TO_CELSIUS_10], THREADS * THREAD_CALLS);
+  ASSERT_INT(after.out_of_range[FAHRENHEIT_100_TO_ITEMP], 1);
+  ASSERT_INT(after.out_of_range[FAHRENHEIT_1_TO_ITEMP], 1);
+
+  ASSERT_INT(after.batch_calls[CELSIUS_100_TO_ITEMP], 2);
+  ASSERT_INT(after.batch_values[CELSIUS_100_TO_ITEMP], 1003);
+  ASSERT_INT(after.batch_calls[CELSIUS_10_TO_ITEMP], 1);
+  ASSERT_INT(after.batch_calls[ITEMP_TO_FAHRENHEIT_100], 2);
+  ASSERT_INT(after.batch_values[ITEMP_TO_FAHRENHEIT_100], 3);
+  ASSERT_INT(after.out_of_range[CELSIUS_100_TO_ITEMP], 3);
+  // the two ends, -499..-265 and 465..498
+  ASSERT_INT(after.out_of_range[CELSIUS_10_TO_ITEMP], 2 + 235 + 34);
+  ASSERT_INT(after.batch_calls[FAHRENHEIT_10_TO_ITEMP], 1);
+  ASSERT_INT(after.batch_values[FAHRENHEIT_10_TO_ITEMP], 4);
+  ASSERT_INT(after.out_of_range[FAHRENHEIT_10_TO_ITEMP], 2);
+  ASSERT_INT(after.batch_calls[ITEMP_TO_CELSIUS_100], 1);
+  ASSERT_INT(after.batch_values[ITEMP_TO_CELSIUS_100], 600);
+  ASSERT_INT(after.batch_sizes[0], 1);
+  ASSERT_INT(after.batch_sizes[2], 2);   // 3 values
+  ASSERT_INT(after.batch_sizes[3], 1);   // 4 values
+  ASSERT_INT(after.batch_sizes[10], 3);  // 1000 and 600 values
+
+  ASSERT_INT(after.delta_calls, 5);
+  ASSERT_INT(after.delta_saturations, 3);
+
+  ASSERT_INT(itemp_counters_conversions(&after),
+             5 + THREADS * THREAD_CALLS + 2 * 1000 + 3 + 3 + 4 + 600);
+#else
+  ASSERT_INT(itemp_counters_conversions(&after), 0);
+  ASSERT_INT(after.delta_calls, 0);
+#endif
+
+  printf("\r\n...unit tests complete.\r\n");
+  return 0;
+}
+
+#endif
@@ -0,0 +1,257 @@
+/** @file itemp_counters.h
+ * Optional counters of itemp conversions: calls per conversion, batch sizes
+ * and out of range inputs.
+ *
+ * Compile itemp.c, itemp_batch.c and itemp_counters.c with -DITEMP_INSTRUMENT
+ * to enable them.  Without it the ITEMP_COUNT_xxx() macros expand to nothing
+ * and itemp_counters_snapshot() reports zeros.
+ *
+ * Each thread counts into its own block with plain (relaxed) stores, so
+ * counting needs no locked instructions.  Blocks are never freed, so counts
+ * from threads that have exited are still included in a snapshot.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_COUNTERS_H_
+#define _ITEMP_COUNTERS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// includes
+
+#include "itemp_batch.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(ITEMP_INSTRUMENT) && !defined(__cplusplus)
+#include <stdatomic.h>
+#endif
+
+// =============================================================================
+// types and definitions
+
+/**
+ * @brief Batch sizes are counted in powers of two: bucket 0 counts empty
+ * batches and bucket b counts batches of 2^(b-1) to 2^b - 1 values.
+ */
+#define ITEMP_BATCH_SIZE_BUCKETS 65
+
+/**
+ * @brief Counts summed over every thread.  The arrays are indexed by
+ * itemp_conversion_t.
+ */
+typedef struct {
+  uint64_t calls[ITEMP_CONVERSION_COUNT];        // scalar conversions
+  uint64_t batch_calls[ITEMP_CONVERSION_COUNT];  // batch conversions
+  uint64_t batch_values[ITEMP_CONVERSION_COUNT]; // values in those batches
+  // Inputs outside ITEMP_MIN_xxx..ITEMP_MAX_xxx, which wrap around.  Only the
+  // conversions to itemp can see these.
+  uint64_t out_of_range[ITEMP_CONVERSION_COUNT];
+  uint64_t batch_sizes[ITEMP_BATCH_SIZE_BUCKETS];
+  uint64_t delta_calls;       // itemp_add_delta() and the delta batches
+  uint64_t delta_saturations; // results clamped to 0 or 65535
+} itemp_counters_t;
+
+#if defined(ITEMP_INSTRUMENT) && !defined(__cplusplus)
+
+#define ITEMP_COUNTER_SLOT(field, index) \
+  (offsetof(itemp_counters_t, field) / sizeof(uint64_t) + (size_t)(index))
+
+/**
+ * @brief Count one scalar conversion.
+ */
+#define ITEMP_COUNT_CALL(conversion) itemp_counters_call(conversion)
+
+/**
+ * @brief Count a batch of n values.
+ */
+#define ITEMP_COUNT_BATCH(conversion, n) itemp_counters_batch((conversion), (n))
+
+/**
+ * @brief Count a scalar input outside min..max.
+ */
+#define ITEMP_COUNT_IF_OUT_OF_RANGE(conversion, value, min, max)          \
+  do {                                                                    \
+    if ((value) < (min) || (value) > (max)) {                             \
+      itemp_counters_add(ITEMP_COUNTER_SLOT(out_of_range, conversion), 1); \
+    }                                                                     \
+  } while (0)
+
+/**
+ * @brief Count the inputs of a batch outside min..max.  Call this before
+ * converting in place.  The built in loops count as they convert, with
+ * ITEMP_COUNT_OUT_OF_RANGE(); this extra pass is for installed backends.
+ */
+#define ITEMP_COUNT_OUT_OF_RANGE_BATCH(conversion, values, n, min, max) \
+  itemp_counters_add(ITEMP_COUNTER_SLOT(out_of_range, conversion),      \
+                     itemp_counters_out_of_range((values), (n), (min), (max)))
+
+/**
+ * @brief Count n inputs that wrapped around.
+ */
+#define ITEMP_COUNT_OUT_OF_RANGE(conversion, n) \
+  itemp_counters_add(ITEMP_COUNTER_SLOT(out_of_range, conversion), (n))
+
+/**
+ * @brief Count one scalar delta addition, which may have been clamped.
+ */
+#define ITEMP_COUNT_DELTA(saturated)                                   \
+  do {                                                                 \
+    itemp_counters_call(ITEMP_CONVERSION_COUNT);                       \
+    if (saturated) {                                                   \
+      itemp_counters_add(ITEMP_COUNTER_SLOT(delta_saturations, 0), 1); \
+    }                                                                  \
+  } while (0)
+
+/**
+ * @brief Count n delta additions, of which `saturated` were clamped.
+ */
+#define ITEMP_COUNT_DELTAS(n, saturated)                               \
+  do {                                                                 \
+    itemp_counters_add(ITEMP_COUNTER_SLOT(delta_calls, 0), (n));       \
+    itemp_counters_add(ITEMP_COUNTER_SLOT(delta_saturations, 0),       \
+                       (saturated));                                   \
+  } while (0)
+
+#else
+
+// Each argument is still evaluated, as void, so that parameters kept for the
+// counts are not unused.  The built in loops compute the counts they name as
+// they go, and the compiler drops that work when nothing uses it.
+#define ITEMP_COUNT_CALL(conversion) ((void)(conversion))
+#define ITEMP_COUNT_BATCH(conversion, n) ((void)(conversion), (void)(n))
+#define ITEMP_COUNT_IF_OUT_OF_RANGE(conversion, value, min, max) \
+  ((void)(conversion), (void)(value), (void)(min), (void)(max))
+#define ITEMP_COUNT_OUT_OF_RANGE_BATCH(conversion, values, n, min, max) \
+  ((void)(conversion), (void)(values), (void)(n), (void)(min), (void)(max))
+#define ITEMP_COUNT_OUT_OF_RANGE(conversion, n) ((void)(conversion), (void)(n))
+#define ITEMP_COUNT_DELTA(saturated) ((void)(saturated))
+#define ITEMP_COUNT_DELTAS(n, saturated) ((void)(n), (void)(saturated))
+
+#endif
+
+// =============================================================================
+// declarations
+
+/**
+ * Sum the counters of every thread into counters.
+ *
+ * Counters are never reset; subtract an earlier snapshot to count an
+ * interval.  Each thread adds up its scalar calls 256 at a time, so the
+ * counts from other threads still converting may be up to 255 calls of each
+ * conversion behind.  The calling thread's own counts, and those of threads
+ * that have exited, are exact.
+ */
+void itemp_counters_snapshot(itemp_counters_t *counters);
+
+/**
+ * Return the number of scalar and batch conversions in a snapshot.
+ */
+uint64_t itemp_counters_conversions(const itemp_counters_t *counters);
+
+#if defined(ITEMP_INSTRUMENT) && !defined(__cplusplus)
+
+// The rest is used by the ITEMP_COUNT_xxx() macros.
+
+#define ITEMP_COUNTER_SLOTS (sizeof(itemp_counters_t) / sizeof(uint64_t))
+
+/**
+ * @brief This thread's counters, or NULL before its first count.
+ */
+extern _Thread_local _Atomic uint64_t *itemp_counters_local;
+
+/**
+ * @brief The scalar calls of each conversion, then of itemp_add_delta(), that
+ * this thread may make before it next adds them to its counters, less one.
+ */
+extern _Thread_local uint8_t
+    itemp_counters_countdown[ITEMP_CONVERSION_COUNT + 1];
+
+/**
+ * @brief Allocate this thread's counters and add them to the list summed by
+ * itemp_counters_snapshot().
+ */
+_Atomic uint64_t *itemp_counters_attach(void);
+
+/**
+ * @brief Add the scalar calls counted down by itemp_counters_countdown[index]
+ * to this thread's counters.
+ */
+void itemp_counters_flush(size_t index);
+
+/**
+ * @brief Count the values outside min..max.
+ */
+uint64_t itemp_counters_out_of_range(const int16_t *values, size_t n,
+                                     int16_t min, int16_t max);
+
+/**
+ * @brief Add n to one of this thread's counters.
+ *
+ * Only this thread writes its counters, so a relaxed load and store is enough
+ * and compiles to an ordinary add.
+ */
+static inline void itemp_counters_add(size_t slot, uint64_t n) {
+  _Atomic uint64_t *slots = itemp_counters_local;
+  if (slots == NULL) {
+    slots = itemp_counters_attach();
+  }
+  uint64_t count = atomic_load_explicit(&slots[slot], memory_order_relaxed);
+  atomic_store_explicit(&slots[slot], count + n, memory_order_relaxed);
+}
+
+/**
+ * @brief Count one scalar call.
+ *
+ * A scalar conversion is cheap enough that an add to this thread's counters
+ * would cost a quarter as much again, so calls are counted down in a byte
+ * instead and added 256 at a time.
+ */
+static inline void itemp_counters_call(size_t index) {
+  if (itemp_counters_countdown[index]-- == 0) {
+    itemp_counters_flush(index);
+  }
+}
+
+static inline void itemp_counters_batch(itemp_conversion_t conversion,
+                                        size_t n) {
+  size_t bucket = 0;
+  for (uint64_t m = n; m > 0; m >>= 1) {
+    bucket++;
+  }
+  itemp_counters_add(ITEMP_COUNTER_SLOT(batch_calls, conversion), 1);
+  itemp_counters_add(ITEMP_COUNTER_SLOT(batch_values, conversion), n);
+  itemp_counters_add(ITEMP_COUNTER_SLOT(batch_sizes, bucket), 1);
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _ITEMP_COUNTERS_H_ */
@@ -0,0 +1,403 @@
+/** @file itemp_ct.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp_ct.h"
+#include <string.h>
+
+// =============================================================================
+// local types and definitions
+
+// The same linear map as itemp.c.
+#define F_100_OFFSET (-ITEMP_MIN_FAHRENHEIT_100)
+#define C_100_OFFSET (-ITEMP_MIN_CELSIUS_100)
+#define F_100_SLOPE ITEMP_ONE_HUNDRETH_DEGREE_F
+#define C_100_SLOPE ITEMP_ONE_HUNDRETH_DEGREE_C
+#define ITEMP_AT_0F (F_100_OFFSET * F_100_SLOPE)
+#define ITEMP_AT_0C (C_100_OFFSET * C_100_SLOPE)
+
+#define ITEMP_MAX 65535
+
+// Floats are first clamped to this range, so that the scaled value fits in
+// an int32_t, then clamped to 0..ITEMP_MAX as integers.
+#define FLOAT_LIMIT 1.0e6f
+
+// u / d == (u * RECIPROCAL(d, shift)) >> shift for every 32 bit u when shift
+// is 32 + ceil(log2(d)): the reciprocal is under 2^33, so the product fits in
+// 64 bits, and its error is under d / 2^shift, too small to reach the next
+// multiple of d.
+#define RECIPROCAL(d, shift) ((((uint64_t)1 << (shift)) + (d) - 1) / (d))
+#define DIVIDE(u, d, shift) divide((u), RECIPROCAL(d, shift), (shift))
+#define RQUO(x, d, shift) rquo_ct((x), (d), RECIPROCAL(d, shift), (shift))
+#define RQUO_DELTA(x, d, shift) \
+  RQUO(clamp_ct((x), -ITEMP_MAX, ITEMP_MAX), d, shift)
+
+// =============================================================================
+// local (forward) declarations
+
+/**
+ * @brief Return x unchanged, but hide its value from the optimizer, so that
+ * it cannot turn a mask computed from x back into a branch.
+ */
+static inline uint32_t barrier(uint32_t x);
+
+/**
+ * @brief Return u / d, given d's reciprocal as made by RECIPROCAL().
+ */
+static inline uint32_t divide(uint32_t u, uint64_t reciprocal,
+                              unsigned shift);
+
+/**
+ * @brief rquo(x, d) for d > 0 without branches: round the magnitude, then
+ * restore the sign.
+ */
+static inline int16_t rquo_ct(int32_t x, uint32_t d, uint64_t reciprocal,
+                              unsigned shift);
+
+/**
+ * @brief Clamp v to lo..hi with masks.
+ */
+static inline int32_t clamp_ct(int32_t v, int32_t lo, int32_t hi);
+
+/**
+ * @brief Flush a subnormal x to 0, then clamp it to +/-FLOAT_LIMIT, all by
+ * masking its bits.  NaN becomes -FLOAT_LIMIT.
+ */
+static inline float clamp_float(float x);
+
+static inline int16_t itemp_to_f_100(itemp_t itemp);
+static inline int16_t itemp_to_c_100(itemp_t itemp);
+
+// =============================================================================
+// local storage
+
+// =============================================================================
+// public code
+
+itemp_t fahrenheit_1_to_itemp_ct(int16_t fahrenheit_1) {
+  return (itemp_t)(((int16_t)(fahrenheit_1 * 100) + F_100_OFFSET) *
+                   F_100_SLOPE);
+}
+
+itemp_t fahrenheit_10_to_itemp_ct(int16_t fahrenheit_10) {
+  return (itemp_t)(((int16_t)(fahrenheit_10 * 10) + F_100_OFFSET) *
+                   F_100_SLOPE);
+}
+
+itemp_t fahrenheit_100_to_itemp_ct(int16_t fahrenheit_100) {
+  return (itemp_t)((fahrenheit_100 + F_100_OFFSET) * F_100_SLOPE);
+}
+
+itemp_t fahrenheit_to_itemp_ct(float fahrenheit) {
+  float x = clamp_float(fahrenheit);
+  return (itemp_t)clamp_ct((int32_t)((x * 100.0 + F_100_OFFSET) * F_100_SLOPE),
+                           0, ITEMP_MAX);
+}
+
+int16_t itemp_to_fahrenheit_1_ct(itemp_t itemp) {
+  return RQUO(itemp_to_f_100(itemp), 100, 39);
+}
+
+int16_t itemp_to_fahrenheit_10_ct(itemp_t itemp) {
+  return RQUO(itemp_to_f_100(itemp), 10, 36);
+}
+
+int16_t itemp_to_fahrenheit_100_ct(itemp_t itemp) {
+  return itemp_to_f_100(itemp);
+}
+
+float itemp_to_fahrenheit_ct(itemp_t itemp) {
+  // exact until the one rounding of the multiply, and never subnormal
+  return (float)(((int32_t)itemp - ITEMP_AT_0F) *
+                 (1.0 / (100 * F_100_SLOPE)));
+}
+
+// celsius
+
+itemp_t celsius_1_to_itemp_ct(int16_t celsius_1) {
+  return (itemp_t)(((int16_t)(celsius_1 * 100) + C_100_OFFSET) * C_100_SLOPE);
+}
+
+itemp_t celsius_10_to_itemp_ct(int16_t celsius_10) {
+  return (itemp_t)(((int16_t)(celsius_10 * 10) + C_100_OFFSET) * C_100_SLOPE);
+}
+
+itemp_t celsius_100_to_itemp_ct(int16_t celsius_100) {
+  return (itemp_t)((celsius_100 + C_100_OFFSET) * C_100_SLOPE);
+}
+
+itemp_t celsius_to_itemp_ct(float celsius) {
+  float x = clamp_float(celsius);
+  return (itemp_t)clamp_ct((int32_t)((x * 100.0 + C_100_OFFSET) * C_100_SLOPE),
+                           0, ITEMP_MAX);
+}
+
+int16_t itemp_to_celsius_1_ct(itemp_t itemp) {
+  return RQUO(itemp_to_c_100(itemp), 100, 39);
+}
+
+int16_t itemp_to_celsius_10_ct(itemp_t itemp) {
+  return RQUO(itemp_to_c_100(itemp), 10, 36);
+}
+
+int16_t itemp_to_celsius_100_ct(itemp_t itemp) {
+  return itemp_to_c_100(itemp);
+}
+
+float itemp_to_celsius_ct(itemp_t itemp) {
+  return (float)(((int32_t)itemp - ITEMP_AT_0C) *
+                 (1.0 / (100 * C_100_SLOPE)));
+}
+
+// deltas
+
+itemp_t itemp_add_delta_ct(itemp_t itemp, itemp_delta_t delta) {
+  // clamp first so the sum cannot overflow
+  int32_t sum = itemp + clamp_ct(delta, -ITEMP_MAX, ITEMP_MAX);
+  return (itemp_t)clamp_ct(sum, 0, ITEMP_MAX);
+}
+
+int16_t itemp_delta_to_fahrenheit_1_ct(itemp_delta_t delta) {
+  return RQUO_DELTA(delta, ITEMP_ONE_DEGREE_F, 41);
+}
+
+int16_t itemp_delta_to_fahrenheit_10_ct(itemp_delta_t delta) {
+  return RQUO_DELTA(delta, ITEMP_ONE_TENTH_DEGREE_F, 38);
+}
+
+int16_t itemp_delta_to_fahrenheit_100_ct(itemp_delta_t delta) {
+  return RQUO_DELTA(delta, ITEMP_ONE_HUNDRETH_DEGREE_F, 35);
+}
+
+int16_t itemp_delta_to_celsius_1_ct(itemp_delta_t delta) {
+  return RQUO_DELTA(delta, ITEMP_ONE_DEGREE_C, 42);
+}
+
+int16_t itemp_delta_to_celsius_10_ct(itemp_delta_t delta) {
+  return RQUO_DELTA(delta, ITEMP_ONE_TENTH_DEGREE_C, 39);
+}
+
+int16_t itemp_delta_to_celsius_100_ct(itemp_delta_t delta) {
+  return RQUO_DELTA(delta, ITEMP_ONE_HUNDRETH_DEGREE_C, 36);
+}
+
+// =============================================================================
+// local (static) code
+
+static inline uint32_t barrier(uint32_t x) {
+#if defined(__GNUC__)
+  __asm__("" : "+r"(x));
+#endif
+  return x;
+}
+
+static inline uint32_t divide(uint32_t u, uint64_t reciprocal,
+                              unsigned shift) {
+  return (uint32_t)((u * reciprocal) >> shift);
+}
+
+static inline int16_t rquo_ct(int32_t x, uint32_t d, uint64_t reciprocal,
+                              unsigned shift) {
+  uint32_t sign = barrier((uint32_t)(x >> 31));  // all ones if x < 0
+  uint32_t magnitude = ((uint32_t)x ^ sign) - sign;
+  uint32_t quotient = divide(magnitude + d / 2, reciprocal, shift);
+  return (int16_t)((quotient ^ sign) - sign);
+}
+
+static inline int32_t clamp_ct(int32_t v, int32_t lo, int32_t hi) {
+  uint32_t below = barrier(-(uint32_t)(v < lo));
+  uint32_t above = barrier(-(uint32_t)(v > hi));
+  uint32_t u = ((uint32_t)lo & below) | ((uint32_t)v & ~below);
+  return (int32_t)(((uint32_t)hi & above) | (u & ~above));
+}
+
+static inline float clamp_float(float x) {
+  const float lo = -FLOAT_LIMIT, hi = FLOAT_LIMIT;
+  uint32_t bits, lo_bits, hi_bits;
+  memcpy(&bits, &x, sizeof(bits));
+  memcpy(&lo_bits, &lo, sizeof(lo_bits));
+  memcpy(&hi_bits, &hi, sizeof(hi_bits));
+  bits &= barrier(-(uint32_t)((bits & 0x7f800000u) != 0));
+  memcpy(&x, &bits, sizeof(x));
+  // a NaN fails both comparisons, and ends up at lo
+  uint32_t above_lo = barrier(-(uint32_t)(x > lo));
+  uint32_t below_hi = barrier(-(uint32_t)(x < hi));
+  bits = (bits & above_lo & below_hi) | (lo_bits & ~above_lo) |
+         (hi_bits & above_lo & ~below_hi);
+  memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+static inline int16_t itemp_to_f_100(itemp_t itemp) {
+  return (int16_t)(DIVIDE(itemp + F_100_SLOPE / 2, F_100_SLOPE, 35) -
+                   F_100_OFFSET);
+}
+
+static inline int16_t itemp_to_c_100(itemp_t itemp) {
+  return (int16_t)(DIVIDE(itemp + C_100_SLOPE / 2, C_100_SLOPE, 36) -
+                   C_100_OFFSET);
+}
+
+// =============================================================================
+// self test
+
+// To run the self test on a unix-like system:
+//   cc -Wall -c itemp.c
+//   cc -Wall -DUNIT_TEST -c itemp_ct.c
+//   cc -o itemp_ct itemp_ct.o itemp.o
+//   ./itemp_ct
+
+#ifdef UNIT_TEST
+
+#include "itemp_unit_test.h"
+#include <math.h>
+
+// rquo() for any int32_t, in 64 bits so that it cannot overflow
+static int16_t reference_rquo(int32_t x, int32_t y) {
+  int64_t half = (x < 0) ? -(y / 2) : y / 2;
+  return (int16_t)(((int64_t)x + half) / y);
+}
+
+int main() {
+  printf("Beginning unit tests...");
+
+  int mismatches = 0;
+
+  // every itemp and every int16_t gives the same result as itemp.h
+  for (int32_t i = 0; i <= ITEMP_MAX; i++) {
+    itemp_t itemp = (itemp_t)i;
+    int16_t value = (int16_t)(i - 32768);
+    mismatches +=
+        itemp_to_fahrenheit_1_ct(itemp) != itemp_to_fahrenheit_1(itemp);
+    mismatches +=
+        itemp_to_fahrenheit_10_ct(itemp) != itemp_to_fahrenheit_10(itemp);
+    mismatches +=
+        itemp_to_fahrenheit_100_ct(itemp) != itemp_to_fahrenheit_100(itemp);
+    mismatches += itemp_to_celsius_1_ct(itemp) != itemp_to_celsius_1(itemp);
+    mismatches += itemp_to_celsius_10_ct(itemp) != itemp_to_celsius_10(itemp);
+    mismatches += itemp_to_celsius_100_ct(itemp) != itemp_to_celsius_100(itemp);
+    mismatches +=
+        fahrenheit_1_to_itemp_ct(value) != fahrenheit_1_to_itemp(value);
+    mismatches +=
+        fahrenheit_10_to_itemp_ct(value) != fahrenheit_10_to_itemp(value);
+    mismatches +=
+        fahrenheit_100_to_itemp_ct(value) != fahrenheit_100_to_itemp(value);
+    mismatches += celsius_1_to_itemp_ct(value) != celsius_1_to_itemp(value);
+    mismatches += celsius_10_to_itemp_ct(value) != celsius_10_to_itemp(value);
+    mismatches += celsius_100_to_itemp_ct(value) != celsius_100_to_itemp(value);
+  }
+  ASSERT_INT(mismatches, 0);
+
+  // deltas: all the small ones, then a sweep of the rest of int32_t, which
+  // clamps to +/-65535 first
+  mismatches = 0;
+  for (int64_t d = INT32_MIN; d <= INT32_MAX;
+       d += (d < -(1 << 20) || d > (1 << 20)) ? 4093 : 1) {
+    itemp_delta_t delta = (itemp_delta_t)d;
+    int32_t clamped = (d < -ITEMP_MAX) ? -ITEMP_MAX
+                      : (d > ITEMP_MAX) ? ITEMP_MAX
+                                        : delta;
+    mismatches += itemp_delta_to_fahrenheit_1_ct(delta) !=
+                  reference_rquo(clamped, ITEMP_ONE_DEGREE_F);
+    mismatches += itemp_delta_to_fahrenheit_10_ct(delta) !=
+                  reference_rquo(clamped, ITEMP_ONE_TENTH_DEGREE_F);
+    mismatches += itemp_delta_to_fahrenheit_100_ct(delta) !=
+                  reference_rquo(clamped, ITEMP_ONE_HUNDRETH_DEGREE_F);
+    mismatches += itemp_delta_to_celsius_1_ct(delta) !=
+                  reference_rquo(clamped, ITEMP_ONE_DEGREE_C);
+    mismatches += itemp_delta_to_celsius_10_ct(delta) !=
+                  reference_rquo(clamped, ITEMP_ONE_TENTH_DEGREE_C);
+    mismatches += itemp_delta_to_celsius_100_ct(delta) !=
+                  reference_rquo(clamped, ITEMP_ONE_HUNDRETH_DEGREE_C);
+    mismatches += itemp_delta_to_fahrenheit_1_ct(delta) !=
+                  itemp_delta_to_fahrenheit_1(delta);
+    mismatches += itemp_delta_to_fahrenheit_100_ct(delta) !=
+                  itemp_delta_to_fahrenheit_100(delta);
+    mismatches += itemp_delta_to_celsius_10_ct(delta) !=
+                  itemp_delta_to_celsius_10(delta);
+  }
+  ASSERT_INT(mismatches, 0);
+  ASSERT_INT(itemp_delta_to_fahrenheit_100_ct(INT32_MIN), -13107);
+
+  // saturating addition
+  const itemp_delta_t deltas[] = {INT32_MIN, -65536, -65535, -1000, -1, 0,
+                                  1,         999,    65535,  65536, INT32_MAX};
+  mismatches = 0;
+  for (int32_t i = 0; i <= ITEMP_MAX; i++) {
+    for (size_t j = 0; j < sizeof(deltas) / sizeof(deltas[0]); j++) {
+      mismatches += itemp_add_delta_ct((itemp_t)i, deltas[j]) !=
+                    itemp_add_delta((itemp_t)i, deltas[j]);
+    }
+  }
+  ASSERT_INT(mismatches, 0);
+
+  // floats to itemp match in range, and clamp outside it
+  mismatches = 0;
+  for (int32_t f = ITEMP_MIN_FAHRENHEIT_100; f <= ITEMP_MAX_FAHRENHEIT_100;
+       f++) {
+    mismatches += fahrenheit_to_itemp_ct(f / 100.0f) !=
+                  fahrenheit_to_itemp(f / 100.0f);
+  }
+  for (int32_t c = ITEMP_MIN_CELSIUS_100; c <= ITEMP_MAX_CELSIUS_100; c++) {
+    mismatches +=
+        celsius_to_itemp_ct(c / 100.0f) != celsius_to_itemp(c / 100.0f);
+  }
+  for (float f = -15.52f; f <= 115.55f; f += 0.0007f) {
+    mismatches += fahrenheit_to_itemp_ct(f) != fahrenheit_to_itemp(f);
+  }
+  for (float c = -26.4f; c <= 46.4166f; c += 0.0007f) {
+    mismatches += celsius_to_itemp_ct(c) != celsius_to_itemp(c);
+  }
+  ASSERT_INT(mismatches, 0);
+  ASSERT_INT(fahrenheit_to_itemp_ct(1e-40f), fahrenheit_to_itemp(0.0f));
+  ASSERT_INT(celsius_to_itemp_ct(-1e-44f), celsius_to_itemp(0.0f));
+  ASSERT_INT(fahrenheit_to_itemp_ct(1000.0f), ITEMP_MAX);
+  ASSERT_INT(fahrenheit_to_itemp_ct(-INFINITY), 0);
+  ASSERT_INT(celsius_to_itemp_ct(INFINITY), ITEMP_MAX);
+  ASSERT_INT(celsius_to_itemp_ct(-1e30f), 0);
+  ASSERT_INT(fahrenheit_to_itemp_ct(NAN), 0);
+
+  // itemp to float: one rounding, close to itemp.h
+  mismatches = 0;
+  for (int32_t i = 0; i <= ITEMP_MAX; i++) {
+    itemp_t itemp = (itemp_t)i;
+    float exact_f = (float)((i - ITEMP_AT_0F) / 500.0);
+    float exact_c = (float)((i - ITEMP_AT_0C) / 900.0);
+    mismatches += itemp_to_fahrenheit_ct(itemp) != exact_f;
+    mismatches += itemp_to_celsius_ct(itemp) != exact_c;
+    mismatches += fabsf(itemp_to_fahrenheit_ct(itemp) -
+                        itemp_to_fahrenheit(itemp)) > 0.00001f;
+    mismatches +=
+        fabsf(itemp_to_celsius_ct(itemp) - itemp_to_celsius(itemp)) > 0.00001f;
+  }
+  ASSERT_INT(mismatches, 0);
+
+  printf("\r\n...unit tests complete.\r\n");
+  return 0;
+}
+
+#endif
@@ -0,0 +1,105 @@
+/** @file itemp_ct.h
+ * Constant time versions of the itemp conversions, for hard real-time loops
+ * that need the same worst case execution time for every input.
+ *
+ * The functions in itemp.h round with rquo(), which branches on the sign, and
+ * compilers may divide by a constant with a divide instruction whose latency
+ * depends on the operands.  Their float paths divide, too, and some cores take
+ * a slow microcode path on subnormal inputs.  The xxx_ct() versions below use
+ * only multiplies, shifts and masks, and never branch on the data:
+ *
+ * - The integer conversions give exactly the same results as those in itemp.h,
+ *   including how out of range inputs wrap around.
+ * - itemp_delta_to_xxx_ct() match too, including clamping deltas beyond
+ *   +/-65535.
+ * - itemp_add_delta_ct() saturates like itemp_add_delta().
+ * - fahrenheit_to_itemp_ct() and celsius_to_itemp_ct() match for inputs that
+ *   do not wrap.  They flush subnormal inputs to zero and clamp the rest,
+ *   including infinities, to 0..65535; a NaN becomes 0.
+ * - itemp_to_fahrenheit_ct() and itemp_to_celsius_ct() round once rather than
+ *   twice, so they are nearer the exact value than itemp_to_fahrenheit() and
+ *   itemp_to_celsius(), and within 0.00001 degree of them.
+ *
+ * None of them are counted or range checked (see itemp_counters.h), since that
+ * would branch.  The conversions to itemp deltas are single multiplies already,
+ * so they have no versions here.
+ *
+ * `itemp_bench -C` measures the spread of call times over every input, for
+ * these and for the functions in itemp.h.  The multiplies are 64 bit, so check
+ * the spread on the target: some small cores multiply in a loop that exits
+ * early.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_CT_H_
+#define _ITEMP_CT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include <stdint.h>
+
+// =============================================================================
+// declarations
+
+itemp_t fahrenheit_1_to_itemp_ct(int16_t fahrenheit_1);
+itemp_t fahrenheit_10_to_itemp_ct(int16_t fahrenheit_10);
+itemp_t fahrenheit_100_to_itemp_ct(int16_t fahrenheit_100);
+itemp_t fahrenheit_to_itemp_ct(float fahrenheit);
+
+int16_t itemp_to_fahrenheit_1_ct(itemp_t itemp);
+int16_t itemp_to_fahrenheit_10_ct(itemp_t itemp);
+int16_t itemp_to_fahrenheit_100_ct(itemp_t itemp);
+float itemp_to_fahrenheit_ct(itemp_t itemp);
+
+itemp_t celsius_1_to_itemp_ct(int16_t celsius_1);
+itemp_t celsius_10_to_itemp_ct(int16_t celsius_10);
+itemp_t celsius_100_to_itemp_ct(int16_t celsius_100);
+itemp_t celsius_to_itemp_ct(float celsius);
+
+int16_t itemp_to_celsius_1_ct(itemp_t itemp);
+int16_t itemp_to_celsius_10_ct(itemp_t itemp);
+int16_t itemp_to_celsius_100_ct(itemp_t itemp);
+float itemp_to_celsius_ct(itemp_t itemp);
+
+itemp_t itemp_add_delta_ct(itemp_t itemp, itemp_delta_t delta);
+
+int16_t itemp_delta_to_fahrenheit_1_ct(itemp_delta_t delta);
+int16_t itemp_delta_to_fahrenheit_10_ct(itemp_delta_t delta);
+int16_t itemp_delta_to_fahrenheit_100_ct(itemp_delta_t delta);
+
+int16_t itemp_delta_to_celsius_1_ct(itemp_delta_t delta);
+int16_t itemp_delta_to_celsius_10_ct(itemp_delta_t delta);
+int16_t itemp_delta_to_celsius_100_ct(itemp_delta_t delta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _ITEMP_CT_H_ */
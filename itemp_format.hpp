@@ -0,0 +1,193 @@
+/** @file itemp_format.hpp
+ * A C++ temperature type backed by an itemp_t, with formatters for std::format
+ * (C++20) and for the {fmt} library:
+ *
+ * @code
+ * itemp::temperature t(fahrenheit_1_to_itemp(70));
+ * std::format("{}", t);       // "70.00F"
+ * std::format("{:C.1}", t);   // "21.1C"
+ * std::format("{:F.0}", t);   // "70F"
+ * @endcode
+ *
+ * The spec is an optional unit (F or C, default F) followed by an optional
+ * precision of .0, .1 or .2 (default .2).  Digits are written directly from the
+ * fixed point value by itemp_format_fahrenheit() and itemp_format_celsius(), with
+ * no floating point or intermediate strings.
+ *
+ * The std::formatter is defined when the standard library provides <format>.
+ * The fmt::formatter is defined when <fmt/format.h> has been included before
+ * this header, or when ITEMP_USE_FMT is defined.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_FORMAT_HPP_
+#define _ITEMP_FORMAT_HPP_
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include "itemp_text.h"
+#include <algorithm>
+#include <cstddef>
+
+#if __has_include(<version>)
+#include <version>
+#endif
+#if defined(__cpp_lib_format)
+#include <format>
+#endif
+#if defined(ITEMP_USE_FMT)
+#include <fmt/format.h>
+#endif
+
+namespace itemp {
+
+// =============================================================================
+// types and definitions
+
+/**
+ * @brief A temperature, held as an itemp value.
+ */
+class temperature {
+ public:
+  constexpr temperature() : itemp_(0) {}
+  constexpr explicit temperature(itemp_t itemp) : itemp_(itemp) {}
+
+  constexpr itemp_t itemp() const { return itemp_; }
+
+  friend constexpr bool operator==(temperature a, temperature b) {
+    return a.itemp_ == b.itemp_;
+  }
+  friend constexpr bool operator!=(temperature a, temperature b) {
+    return a.itemp_ != b.itemp_;
+  }
+
+ private:
+  itemp_t itemp_;
+};
+
+/**
+ * @brief A parsed format spec such as "C.1".
+ */
+struct format_spec {
+  char unit = 'F';
+  int decimals = 2;
+};
+
+namespace detail {
+
+/**
+ * Parse a format spec from [it, end), stopping at the closing brace.
+ *
+ * @returns An iterator to the first character not consumed.  If it is not
+ * end or a '}', the spec was invalid.
+ */
+template <class It>
+constexpr It parse_spec(It it, It end, format_spec &spec) {
+  if (it != end && (*it == 'F' || *it == 'C')) {
+    spec.unit = *it++;
+  }
+  if (it != end && *it == '.') {
+    ++it;
+    if (it == end || *it < '0' || *it > '2') {
+      return --it;  // leave the '.' unconsumed to report the error
+    }
+    spec.decimals = *it++ - '0';
+  }
+  return it;
+}
+
+}  // namespace detail
+
+// =============================================================================
+// formatting
+
+/**
+ * Write t to buf as described by spec, without a terminating null.
+ *
+ * @param buf Room for at least ITEMP_FORMAT_MAX + 1 characters.
+ * @returns The number of characters written, including the unit.
+ */
+inline size_t format_to(char *buf, temperature t, const format_spec &spec) {
+  size_t n = (spec.unit == 'C')
+                 ? itemp_format_celsius(buf, t.itemp(), spec.decimals)
+                 : itemp_format_fahrenheit(buf, t.itemp(), spec.decimals);
+  buf[n++] = spec.unit;
+  return n;
+}
+
+}  // namespace itemp
+
+#if defined(__cpp_lib_format)
+
+template <>
+struct std::formatter<itemp::temperature, char> {
+  constexpr auto parse(std::format_parse_context &ctx) {
+    auto it = itemp::detail::parse_spec(ctx.begin(), ctx.end(), spec_);
+    if (it != ctx.end() && *it != '}') {
+      throw std::format_error("invalid format spec for itemp::temperature");
+    }
+    return it;
+  }
+
+  template <class FormatContext>
+  auto format(itemp::temperature t, FormatContext &ctx) const {
+    char buf[ITEMP_FORMAT_MAX + 1];
+    size_t n = itemp::format_to(buf, t, spec_);
+    return std::copy_n(buf, n, ctx.out());
+  }
+
+ private:
+  itemp::format_spec spec_;
+};
+
+#endif
+
+#if defined(FMT_VERSION)
+
+template <>
+struct fmt::formatter<itemp::temperature, char> {
+  constexpr auto parse(fmt::format_parse_context &ctx) {
+    auto it = itemp::detail::parse_spec(ctx.begin(), ctx.end(), spec_);
+    if (it != ctx.end() && *it != '}') {
+      throw fmt::format_error("invalid format spec for itemp::temperature");
+    }
+    return it;
+  }
+
+  template <class FormatContext>
+  auto format(itemp::temperature t, FormatContext &ctx) const {
+    char buf[ITEMP_FORMAT_MAX + 1];
+    size_t n = itemp::format_to(buf, t, spec_);
+    return std::copy_n(buf, n, ctx.out());
+  }
+
+ private:
+  itemp::format_spec spec_;
+};
+
+#endif
+
+#endif /* #ifndef _ITEMP_FORMAT_HPP_ */
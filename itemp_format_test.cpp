@@ -0,0 +1,104 @@
+/** @file itemp_format_test.cpp
+ * Unit tests for itemp_format.hpp.
+ *
+ * To run tests on a unix-like system:
+ *   cc -Wall -c itemp.c itemp_text.c
+ *   c++ -std=c++20 -Wall -o itemp_format_test itemp_format_test.cpp itemp.o \
+ *       itemp_text.o && ./itemp_format_test
+ *
+ * To test the {fmt} formatter as well, build the test with fmt:
+ *   c++ -std=c++20 -Wall -DITEMP_USE_FMT -o itemp_format_test \
+ *       itemp_format_test.cpp itemp.o itemp_text.o -lfmt && ./itemp_format_test
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp_format.hpp"
+#include "itemp_unit_test.h"
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// =============================================================================
+// self test
+
+static std::string format(itemp::temperature t, std::string_view spec) {
+  itemp::format_spec parsed;
+  auto it = itemp::detail::parse_spec(spec.begin(), spec.end(), parsed);
+  if (it != spec.end()) {
+    return "error";
+  }
+  char buf[ITEMP_FORMAT_MAX + 1];
+  return std::string(buf, itemp::format_to(buf, t, parsed));
+}
+
+#define ASSERT_STR(observed, expected) \
+  ASSERT_INT((observed).compare(expected), 0)
+
+int main() {
+  printf("Beginning unit tests...");
+
+  itemp::temperature t(fahrenheit_1_to_itemp(70));
+  itemp::temperature cold(0);
+
+  ASSERT_STR(format(t, ""), "70.00F");
+  ASSERT_STR(format(t, "F"), "70.00F");
+  ASSERT_STR(format(t, "F.0"), "70F");
+  ASSERT_STR(format(t, "F.1"), "70.0F");
+  ASSERT_STR(format(t, "C.1"), "21.1C");
+  ASSERT_STR(format(t, "C"), "21.11C");
+  ASSERT_STR(format(t, ".1"), "70.0F");
+  ASSERT_STR(format(cold, "F.2"), "-15.52F");
+  ASSERT_STR(format(cold, "C.2"), "-26.40C");
+
+  ASSERT_STR(format(t, "K"), "error");
+  ASSERT_STR(format(t, "F.3"), "error");
+  ASSERT_STR(format(t, "F."), "error");
+  ASSERT_STR(format(t, "F.1x"), "error");
+
+#if defined(__cpp_lib_format)
+  ASSERT_STR(std::format("{:C.1}", t), "21.1C");
+  ASSERT_STR(std::format("{} / {:C.0}", cold, cold), "-15.52F / -26C");
+#endif
+
+#if defined(FMT_VERSION)
+  ASSERT_STR(fmt::format("{:C.1}", t), "21.1C");
+  ASSERT_STR(fmt::format("{} / {:C.0}", cold, cold), "-15.52F / -26C");
+  ASSERT_STR(fmt::format("[{:F.1}]", cold), "[-15.5F]");
+  char fmt_buf[8];
+  auto fmt_end = fmt::format_to_n(fmt_buf, sizeof(fmt_buf), "{:F.0}", t);
+  ASSERT_STR(std::string(fmt_buf, fmt_end.out), "70F");
+  bool fmt_rejected = false;
+  try {
+    (void)fmt::format(fmt::runtime("{:K}"), t);
+  } catch (const fmt::format_error &) {
+    fmt_rejected = true;
+  }
+  ASSERT_INT(fmt_rejected, true);
+#endif
+
+  printf("\r\n...unit tests complete.\r\n");
+}
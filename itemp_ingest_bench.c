@@ -0,0 +1,719 @@
+/** @file itemp_ingest_bench.c
+ * itemp_ingest_bench: an end to end benchmark of a simulated sensor fleet.
+ * Simulated sensors send text readings, and the library's components parse,
+ * convert, aggregate and store them; the benchmark reports the sustained
+ * throughput and the latency percentiles as the fleet grows.
+ *
+ * To build on a unix-like system:
+ *   cc -O3 -Wall -o itemp_ingest_bench itemp_ingest_bench.c itemp_batch.c \
+ *      itemp_readings.c itemp_stats.c itemp_text.c itemp_workload.c itemp.c \
+ *      -lm -lpthread
+ *
+ *   ./itemp_ingest_bench                1K to 1M sensors, a reading a second
+ *   ./itemp_ingest_bench -s 5000 -i .01 5K sensors, 100 readings a second
+ *   ./itemp_ingest_bench -i 0           as fast as possible: the capacity
+ *
+ * Each of -j pipelines owns a shard of the sensors and runs two threads.  The
+ * producer formats the shard's readings as "sensor,timestamp,degrees F" lines
+ * on the schedule the sensors would send them, and hands them over in batches.
+ * The consumer parses each batch, converts it with
+ * fahrenheit_100_to_itemp_batch(), updates per-sensor and fleet statistics
+ * and appends it to an itemp_readings_t, which is cleared every million rows
+ * as if handed to storage.
+ *
+ * A reading's latency runs from when it was due to be sent, not from when the
+ * producer got round to it, until its batch is stored.  So a pipeline that
+ * falls behind shows its backlog in the percentiles, rather than slowing the
+ * clock.  Latencies are kept in a log-linear histogram with 1/64 resolution, in
+ * the manner of HdrHistogram, and percentiles are reported as the upper end of
+ * their bucket.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include "itemp_batch.h"
+#include "itemp_readings.h"
+#include "itemp_stats.h"
+#include "itemp_text.h"
+#include "itemp_workload.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// =============================================================================
+// local types and definitions
+
+#define MAX_PIPELINES 64
+#define MAX_STEPS 16
+#define DEFAULT_SENSORS "1000,10000,100000,1000000"
+#define DEFAULT_INTERVAL_S 1.0
+#define DEFAULT_DURATION_S 2.0
+#define DEFAULT_BATCH 1024
+#define MAX_BATCH 65536
+#define QUEUE_SLOTS 8
+#define STORE_ROWS (1 << 20)
+#define SEED 0x1234567
+
+// "4294967295,4294967295,-15.52\n"
+#define LINE_MAX_BYTES (10 + 1 + 10 + 1 + ITEMP_FORMAT_MAX + 1)
+
+// Values below 2^LATENCY_SUB_BITS have a bucket each.  Above that, each power
+// of two is split into 2^(LATENCY_SUB_BITS - 1) buckets.
+#define LATENCY_SUB_BITS 7
+#define LATENCY_SUB_COUNT (1 << LATENCY_SUB_BITS)
+#define LATENCY_HALF_COUNT (LATENCY_SUB_COUNT / 2)
+#define LATENCY_BUCKETS \
+  (LATENCY_SUB_COUNT + (64 - LATENCY_SUB_BITS) * LATENCY_HALF_COUNT)
+
+typedef struct {
+  int n_pipelines;
+  int batch;                // most lines per batch
+  double interval;          // seconds between one sensor's readings, or 0
+  double duration;          // seconds per step
+  int n_steps;
+  size_t sensors[MAX_STEPS];
+} options_t;
+
+typedef struct {
+  uint64_t counts[LATENCY_BUCKETS];
+  uint64_t total;
+  uint64_t max;
+} latency_histogram_t;
+
+typedef struct {
+  char *text;               // the lines, as the sensors sent them
+  size_t bytes;
+  size_t n;                 // number of lines
+  uint64_t *due;            // when each line was due to be sent
+} batch_t;
+
+// A bounded queue of batches between one producer and one consumer.
+typedef struct {
+  batch_t slots[QUEUE_SLOTS];
+  size_t head;              // next slot to consume
+  size_t tail;              // next slot to fill
+  bool done;                // the producer has finished
+  pthread_mutex_t lock;
+  pthread_cond_t not_empty;
+  pthread_cond_t not_full;
+} queue_t;
+
+typedef struct {
+  const options_t *options;
+  int index;                // this pipeline's shard
+  size_t n_sensors;         // sensors in the shard
+  uint64_t start;           // ns
+  uint64_t stop;            // ns
+  queue_t queue;
+
+  // producer
+  itemp_workload_t workload;
+  itemp_t *itemps;
+  uint32_t *timestamps;
+  uint32_t *sensors;
+  uint64_t produced;
+
+  // consumer
+  uint32_t *ids;
+  int64_t *times;
+  int16_t *values_100;
+  itemp_t *converted;
+  itemp_stats_t *sensor_stats;  // per sensor in the shard
+  itemp_stats_t stats;          // whole shard
+  itemp_histogram_t *histogram;
+  itemp_pool_t pool;
+  itemp_readings_t readings;
+  uint64_t stored;
+  uint64_t rejected;
+  uint64_t last_stored;         // ns
+  latency_histogram_t *latency;
+} pipeline_t;
+
+// =============================================================================
+// local (forward) declarations
+
+static void usage(const char *program);
+static bool parse_options(int argc, char *argv[], options_t *options);
+static bool parse_sensors(const char *s, options_t *options);
+static uint64_t now_ns(void);
+static void sleep_until(uint64_t ns);
+
+/**
+ * @brief Run every pipeline over a fleet of n_sensors and print one line of
+ * results.
+ */
+static bool run_step(const options_t *options, size_t n_sensors);
+static bool pipeline_init(pipeline_t *pipeline, const options_t *options,
+                          int index, size_t n_sensors);
+static void pipeline_free(pipeline_t *pipeline);
+static void *producer(void *arg);
+static void *consumer(void *arg);
+
+/**
+ * @brief Format the next n readings of the shard as text lines into batch.
+ */
+static void produce_batch(pipeline_t *pipeline, batch_t *batch, size_t n);
+
+/**
+ * @brief Parse, convert, aggregate and store one batch.
+ */
+static void consume_batch(pipeline_t *pipeline, const batch_t *batch);
+static size_t format_uint(char *buf, uint32_t value);
+static const char *parse_uint(const char *s, const char *end, uint32_t *value);
+static void latency_record(latency_histogram_t *histogram, uint64_t value);
+static void latency_merge(latency_histogram_t *histogram,
+                          const latency_histogram_t *other);
+
+/**
+ * @brief Return the upper end of the bucket holding the given percentile.
+ */
+static uint64_t latency_percentile(const latency_histogram_t *histogram,
+                                   double percentile);
+
+// =============================================================================
+// local storage
+
+static pipeline_t s_pipelines[MAX_PIPELINES];
+
+// =============================================================================
+// public code
+
+int main(int argc, char *argv[]) {
+  options_t options;
+
+  if (!parse_options(argc, argv, &options)) {
+    usage(argv[0]);
+    return 2;
+  }
+  printf("%10s %12s %12s %10s %10s %10s %10s %10s %9s\n", "sensors",
+         "offered/s", "stored/s", "p50 us", "p90 us", "p99 us", "p99.9 us",
+         "max us", "rejected");
+  for (int i = 0; i < options.n_steps; i++) {
+    if (!run_step(&options, options.sensors[i])) {
+      fprintf(stderr, "out of memory\n");
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// =============================================================================
+// local (static) code
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  -s LIST   comma separated fleet sizes (default %s)\n"
+          "  -i S      seconds between one sensor's readings, 0 for as fast\n"
+          "            as possible (default %g)\n"
+          "  -d S      seconds to run each fleet size (default %g)\n"
+          "  -j N      number of pipelines, two threads each (default %d)\n"
+          "  -b N      most readings per batch (default %d)\n",
+          program, DEFAULT_SENSORS, DEFAULT_INTERVAL_S, DEFAULT_DURATION_S,
+          (int)((sysconf(_SC_NPROCESSORS_ONLN) + 1) / 2), DEFAULT_BATCH);
+}
+
+static bool parse_options(int argc, char *argv[], options_t *options) {
+  long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int opt;
+
+  options->n_pipelines = (int)((n_cpus + 1) / 2);
+  options->n_pipelines = (options->n_pipelines < 1) ? 1
+                         : (options->n_pipelines > MAX_PIPELINES)
+                             ? MAX_PIPELINES
+                             : options->n_pipelines;
+  options->batch = DEFAULT_BATCH;
+  options->interval = DEFAULT_INTERVAL_S;
+  options->duration = DEFAULT_DURATION_S;
+  parse_sensors(DEFAULT_SENSORS, options);
+
+  while ((opt = getopt(argc, argv, "s:i:d:j:b:")) != -1) {
+    switch (opt) {
+    case 's':
+      if (!parse_sensors(optarg, options)) {
+        return false;
+      }
+      break;
+    case 'i':
+      options->interval = atof(optarg);
+      if (options->interval < 0) {
+        return false;
+      }
+      break;
+    case 'd':
+      options->duration = atof(optarg);
+      if (options->duration <= 0) {
+        return false;
+      }
+      break;
+    case 'j':
+      options->n_pipelines = atoi(optarg);
+      if (options->n_pipelines < 1 || options->n_pipelines > MAX_PIPELINES) {
+        return false;
+      }
+      break;
+    case 'b':
+      options->batch = atoi(optarg);
+      if (options->batch < 1 || options->batch > MAX_BATCH) {
+        return false;
+      }
+      break;
+    default:
+      return false;
+    }
+  }
+  return optind == argc;
+}
+
+static bool parse_sensors(const char *s, options_t *options) {
+  const char *end = s + strlen(s);
+
+  options->n_steps = 0;
+  while (s < end) {
+    uint32_t n;
+    s = parse_uint(s, end, &n);
+    if (s == NULL || n == 0 || options->n_steps == MAX_STEPS) {
+      return false;
+    }
+    options->sensors[options->n_steps++] = n;
+    if (s < end && *s++ != ',') {
+      return false;
+    }
+  }
+  return options->n_steps > 0;
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void sleep_until(uint64_t ns) {
+  struct timespec ts;
+  ts.tv_sec = ns / 1000000000u;
+  ts.tv_nsec = ns % 1000000000u;
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+  }
+}
+
+static bool run_step(const options_t *options, size_t n_sensors) {
+  int n_pipelines = options->n_pipelines;
+  pthread_t producers[MAX_PIPELINES];
+  pthread_t consumers[MAX_PIPELINES];
+  bool ok = true;
+
+  if ((size_t)n_pipelines > n_sensors) {
+    n_pipelines = (int)n_sensors;
+  }
+  for (int i = 0; i < n_pipelines; i++) {
+    size_t shard =
+        n_sensors / n_pipelines + ((size_t)i < n_sensors % n_pipelines);
+    if (!pipeline_init(&s_pipelines[i], options, i, shard)) {
+      ok = false;
+      n_pipelines = i + 1;
+      break;
+    }
+  }
+
+  if (ok) {
+    // give the threads a moment to start, so every shard starts together
+    uint64_t start = now_ns() + 10000000u;
+    for (int i = 0; i < n_pipelines; i++) {
+      s_pipelines[i].start = start;
+      s_pipelines[i].stop = start + (uint64_t)(options->duration * 1e9);
+    }
+    for (int i = 0; i < n_pipelines; i++) {
+      pipeline_t *pipeline = &s_pipelines[i];
+      if (pthread_create(&consumers[i], NULL, consumer, pipeline) != 0 ||
+          pthread_create(&producers[i], NULL, producer, pipeline) != 0) {
+        fprintf(stderr, "pthread_create failed\n");
+        exit(1);
+      }
+    }
+    for (int i = 0; i < n_pipelines; i++) {
+      pthread_join(producers[i], NULL);
+      pthread_join(consumers[i], NULL);
+    }
+
+    latency_histogram_t *latency = s_pipelines[0].latency;
+    uint64_t produced = s_pipelines[0].produced;
+    uint64_t stored = s_pipelines[0].stored;
+    uint64_t rejected = s_pipelines[0].rejected;
+    uint64_t last_stored = s_pipelines[0].last_stored;
+    for (int i = 1; i < n_pipelines; i++) {
+      const pipeline_t *pipeline = &s_pipelines[i];
+      latency_merge(latency, pipeline->latency);
+      produced += pipeline->produced;
+      stored += pipeline->stored;
+      rejected += pipeline->rejected;
+      if (pipeline->last_stored > last_stored) {
+        last_stored = pipeline->last_stored;
+      }
+    }
+    // Readings are offered for the whole step, so a sparse fleet, whose last
+    // reading is stored early, is still measured over all of it, and one
+    // that falls behind over the time it took to catch up.
+    double elapsed = options->duration;
+    if (last_stored > s_pipelines[0].start &&
+        (last_stored - s_pipelines[0].start) * 1e-9 > elapsed) {
+      elapsed = (last_stored - s_pipelines[0].start) * 1e-9;
+    }
+    printf("%10zu %12.0f %12.0f %10.1f %10.1f %10.1f %10.1f %10.1f %9llu\n",
+           n_sensors, produced / options->duration,
+           elapsed > 0 ? stored / elapsed : 0.0,
+           latency_percentile(latency, 50.0) * 1e-3,
+           latency_percentile(latency, 90.0) * 1e-3,
+           latency_percentile(latency, 99.0) * 1e-3,
+           latency_percentile(latency, 99.9) * 1e-3, latency->max * 1e-3,
+           (unsigned long long)rejected);
+    fflush(stdout);
+  }
+
+  for (int i = 0; i < n_pipelines; i++) {
+    pipeline_free(&s_pipelines[i]);
+  }
+  return ok;
+}
+
+static bool pipeline_init(pipeline_t *pipeline, const options_t *options,
+                          int index, size_t n_sensors) {
+  itemp_workload_config_t config;
+  size_t batch = options->batch;
+
+  memset(pipeline, 0, sizeof(*pipeline));
+  pipeline->options = options;
+  pipeline->index = index;
+  pipeline->n_sensors = n_sensors;
+  pthread_mutex_init(&pipeline->queue.lock, NULL);
+  pthread_cond_init(&pipeline->queue.not_empty, NULL);
+  pthread_cond_init(&pipeline->queue.not_full, NULL);
+  for (int i = 0; i < QUEUE_SLOTS; i++) {
+    pipeline->queue.slots[i].text = malloc(batch * LINE_MAX_BYTES);
+    pipeline->queue.slots[i].due = malloc(batch * sizeof(uint64_t));
+    if (!pipeline->queue.slots[i].text || !pipeline->queue.slots[i].due) {
+      return false;
+    }
+  }
+
+  itemp_workload_config_init(&config, n_sensors, SEED + index);
+  pipeline->itemps = malloc(batch * sizeof(itemp_t));
+  pipeline->timestamps = malloc(batch * sizeof(uint32_t));
+  pipeline->sensors = malloc(batch * sizeof(uint32_t));
+
+  pipeline->ids = malloc(batch * sizeof(uint32_t));
+  pipeline->times = malloc(batch * sizeof(int64_t));
+  pipeline->values_100 = malloc(batch * sizeof(int16_t));
+  pipeline->converted = malloc(batch * sizeof(itemp_t));
+  pipeline->sensor_stats = malloc(n_sensors * sizeof(itemp_stats_t));
+  pipeline->histogram = malloc(sizeof(itemp_histogram_t));
+  pipeline->latency = calloc(1, sizeof(latency_histogram_t));
+  itemp_pool_init(&pipeline->pool);
+  itemp_readings_init(&pipeline->readings, &pipeline->pool);
+  if (!itemp_workload_init(&pipeline->workload, &config) ||
+      !pipeline->itemps || !pipeline->timestamps || !pipeline->sensors ||
+      !pipeline->ids || !pipeline->times || !pipeline->values_100 ||
+      !pipeline->converted || !pipeline->sensor_stats ||
+      !pipeline->histogram || !pipeline->latency ||
+      !itemp_readings_reserve(&pipeline->readings, STORE_ROWS)) {
+    return false;
+  }
+  for (size_t i = 0; i < n_sensors; i++) {
+    itemp_stats_init(&pipeline->sensor_stats[i]);
+  }
+  itemp_stats_init(&pipeline->stats);
+  itemp_histogram_init(pipeline->histogram);
+  return true;
+}
+
+static void pipeline_free(pipeline_t *pipeline) {
+  for (int i = 0; i < QUEUE_SLOTS; i++) {
+    free(pipeline->queue.slots[i].text);
+    free(pipeline->queue.slots[i].due);
+  }
+  pthread_mutex_destroy(&pipeline->queue.lock);
+  pthread_cond_destroy(&pipeline->queue.not_empty);
+  pthread_cond_destroy(&pipeline->queue.not_full);
+  itemp_workload_free(&pipeline->workload);
+  free(pipeline->itemps);
+  free(pipeline->timestamps);
+  free(pipeline->sensors);
+  free(pipeline->ids);
+  free(pipeline->times);
+  free(pipeline->values_100);
+  free(pipeline->converted);
+  free(pipeline->sensor_stats);
+  free(pipeline->histogram);
+  free(pipeline->latency);
+  itemp_readings_release(&pipeline->readings);
+  itemp_pool_trim(&pipeline->pool);
+}
+
+static void *producer(void *arg) {
+  pipeline_t *pipeline = arg;
+  const options_t *options = pipeline->options;
+  queue_t *queue = &pipeline->queue;
+  // The shard sends a reading every period ns, round robin over its sensors,
+  // and reading k is due at start + k * period.
+  double period = options->interval * 1e9 / pipeline->n_sensors;
+
+  sleep_until(pipeline->start);
+  for (;;) {
+    uint64_t now = now_ns();
+    size_t n = options->batch;
+    if (now >= pipeline->stop) {
+      break;
+    }
+    if (period > 0) {
+      uint64_t due = (uint64_t)((now - pipeline->start) / period) + 1;
+      if (due <= pipeline->produced) {
+        uint64_t next = pipeline->start +
+                        (uint64_t)(pipeline->produced * period);
+        sleep_until(next < pipeline->stop ? next : pipeline->stop);
+        continue;
+      }
+      if (due - pipeline->produced < n) {
+        n = due - pipeline->produced;
+      }
+    }
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->tail - queue->head == QUEUE_SLOTS) {
+      pthread_cond_wait(&queue->not_full, &queue->lock);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    // the consumer does not touch this slot until tail moves past it
+    produce_batch(pipeline, &queue->slots[queue->tail % QUEUE_SLOTS], n);
+    pthread_mutex_lock(&queue->lock);
+    queue->tail++;
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+  }
+
+  pthread_mutex_lock(&queue->lock);
+  queue->done = true;
+  pthread_cond_signal(&queue->not_empty);
+  pthread_mutex_unlock(&queue->lock);
+  return NULL;
+}
+
+static void *consumer(void *arg) {
+  pipeline_t *pipeline = arg;
+  queue_t *queue = &pipeline->queue;
+
+  for (;;) {
+    pthread_mutex_lock(&queue->lock);
+    while (queue->head == queue->tail && !queue->done) {
+      pthread_cond_wait(&queue->not_empty, &queue->lock);
+    }
+    if (queue->head == queue->tail) {
+      pthread_mutex_unlock(&queue->lock);
+      break;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    consume_batch(pipeline, &queue->slots[queue->head % QUEUE_SLOTS]);
+    pthread_mutex_lock(&queue->lock);
+    queue->head++;
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+  }
+  return NULL;
+}
+
+static void produce_batch(pipeline_t *pipeline, batch_t *batch, size_t n) {
+  const options_t *options = pipeline->options;
+  double period = options->interval * 1e9 / pipeline->n_sensors;
+  uint64_t now = now_ns();
+  char *p = batch->text;
+
+  itemp_workload_generate_fleet(&pipeline->workload, pipeline->itemps,
+                                pipeline->timestamps, pipeline->sensors, n);
+  for (size_t i = 0; i < n; i++) {
+    // sensor ids are global: shard i holds the ids congruent to i
+    uint32_t id = pipeline->sensors[i] * options->n_pipelines + pipeline->index;
+    p += format_uint(p, id);
+    *p++ = ',';
+    p += format_uint(p, pipeline->timestamps[i]);
+    *p++ = ',';
+    p += itemp_format_fahrenheit(p, pipeline->itemps[i], 2);
+    *p++ = '\n';
+    batch->due[i] = (period > 0)
+                        ? pipeline->start +
+                              (uint64_t)((pipeline->produced + i) * period)
+                        : now;
+  }
+  batch->bytes = p - batch->text;
+  batch->n = n;
+  pipeline->produced += n;
+}
+
+static void consume_batch(pipeline_t *pipeline, const batch_t *batch) {
+  int n_pipelines = pipeline->options->n_pipelines;
+  const char *s = batch->text;
+  const char *end = batch->text + batch->bytes;
+  size_t n = 0;
+
+  // parse
+  while (s < end) {
+    const char *eol = memchr(s, '\n', end - s);
+    const char *p;
+    uint32_t id;
+    uint32_t timestamp;
+    int32_t value_100;
+    eol = (eol == NULL) ? end : eol;
+    p = parse_uint(s, eol, &id);
+    if (p != NULL && p < eol && *p == ',') {
+      p = parse_uint(p + 1, eol, &timestamp);
+    } else {
+      p = NULL;
+    }
+    if (p != NULL && p < eol && *p == ',') {
+      p = itemp_parse_decimal_100(p + 1, eol, &value_100);
+    } else {
+      p = NULL;
+    }
+    if (p == eol && value_100 >= ITEMP_MIN_FAHRENHEIT_100 &&
+        value_100 <= ITEMP_MAX_FAHRENHEIT_100 &&
+        (int)(id % n_pipelines) == pipeline->index &&
+        id / n_pipelines < pipeline->n_sensors) {
+      pipeline->ids[n] = id;
+      pipeline->times[n] = timestamp;
+      pipeline->values_100[n] = (int16_t)value_100;
+      n++;
+    } else {
+      pipeline->rejected++;
+    }
+    s = eol + 1;
+  }
+
+  // convert
+  fahrenheit_100_to_itemp_batch(pipeline->values_100, pipeline->converted, n);
+
+  // aggregate
+  for (size_t i = 0; i < n; i++) {
+    itemp_stats_update(&pipeline->sensor_stats[pipeline->ids[i] / n_pipelines],
+                       &pipeline->converted[i], 1);
+  }
+  itemp_stats_update(&pipeline->stats, pipeline->converted, n);
+  itemp_histogram_update(pipeline->histogram, pipeline->converted, n);
+
+  // store
+  if (pipeline->readings.count + n > STORE_ROWS) {
+    itemp_readings_clear(&pipeline->readings);
+  }
+  itemp_readings_append_columns(&pipeline->readings, pipeline->ids,
+                                pipeline->times, pipeline->converted, n);
+  pipeline->stored += n;
+
+  uint64_t now = now_ns();
+  for (size_t i = 0; i < batch->n; i++) {
+    latency_record(pipeline->latency,
+                   (now > batch->due[i]) ? now - batch->due[i] : 0);
+  }
+  pipeline->last_stored = now;
+}
+
+static size_t format_uint(char *buf, uint32_t value) {
+  char digits[10];
+  size_t n = 0;
+
+  do {
+    digits[n++] = '0' + value % 10;
+    value /= 10;
+  } while (value > 0);
+  for (size_t i = 0; i < n; i++) {
+    buf[i] = digits[n - 1 - i];
+  }
+  return n;
+}
+
+static const char *parse_uint(const char *s, const char *end,
+                              uint32_t *value) {
+  uint64_t v = 0;
+  const char *start = s;
+
+  while (s < end && *s >= '0' && *s <= '9' && s - start < 10) {
+    v = v * 10 + (*s++ - '0');
+  }
+  if (s == start || v > UINT32_MAX) {
+    return NULL;
+  }
+  *value = (uint32_t)v;
+  return s;
+}
+
+static void latency_record(latency_histogram_t *histogram, uint64_t value) {
+  size_t index = value;
+
+  if (value >= LATENCY_SUB_COUNT) {
+    int shift = 63 - __builtin_clzll(value) - (LATENCY_SUB_BITS - 1);
+    index = LATENCY_SUB_COUNT + (shift - 1) * LATENCY_HALF_COUNT +
+            (value >> shift) - LATENCY_HALF_COUNT;
+  }
+  histogram->counts[index]++;
+  histogram->total++;
+  if (value > histogram->max) {
+    histogram->max = value;
+  }
+}
+
+static void latency_merge(latency_histogram_t *histogram,
+                          const latency_histogram_t *other) {
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    histogram->counts[i] += other->counts[i];
+  }
+  histogram->total += other->total;
+  if (other->max > histogram->max) {
+    histogram->max = other->max;
+  }
+}
+
+static uint64_t latency_percentile(const latency_histogram_t *histogram,
+                                   double percentile) {
+  uint64_t rank = (uint64_t)(histogram->total * percentile / 100.0);
+  uint64_t seen = 0;
+
+  for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += histogram->counts[i];
+    if (seen > rank) {
+      uint64_t high = i;
+      if (i >= LATENCY_SUB_COUNT) {
+        size_t shift = (i - LATENCY_SUB_COUNT) / LATENCY_HALF_COUNT + 1;
+        size_t sub = (i - LATENCY_SUB_COUNT) % LATENCY_HALF_COUNT +
+                     LATENCY_HALF_COUNT;
+        high = ((uint64_t)(sub + 1) << shift) - 1;
+      }
+      return (high < histogram->max) ? high : histogram->max;
+    }
+  }
+  return histogram->max;
+}
@@ -0,0 +1,623 @@
+/** @file itemp_reader.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#define _GNU_SOURCE
+#include "itemp_reader.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(ITEMP_USE_IO_URING) && defined(__linux__)
+#define HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+// =============================================================================
+// local types and definitions
+
+#define DEFAULT_BLOCK_SIZE (256 * 1024)
+#define DEFAULT_QUEUE_DEPTH 32
+#define BUFFER_ALIGNMENT 4096
+
+#ifdef HAVE_IO_URING
+
+typedef struct {
+  int fd;
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+  void *sq_ptr;
+  size_t sq_size;
+  void *cq_ptr;
+  size_t cq_size;
+  size_t sqes_size;
+  unsigned entries;
+} ring_t;
+
+typedef struct {
+  int fd;
+  uint64_t size;         // bytes to read, rounded down to whole itemps
+  unsigned pending;      // reads issued but not yet completed
+  bool issued;           // all reads for this file have been issued
+} file_t;
+
+typedef struct {
+  size_t file_index;
+  uint64_t offset;       // offset of the block within the file
+  size_t wanted;         // bytes in the block
+  size_t filled;         // bytes read so far
+  uint8_t *buffer;
+} slot_t;
+
+typedef struct {
+  const char *const *paths;
+  size_t n_paths;
+  file_t *files;
+  size_t block_size;
+  size_t file_index;     // file currently being issued
+  bool file_open;
+  uint64_t offset;       // next offset to issue within the current file
+} cursor_t;
+
+#endif
+
+// =============================================================================
+// local (forward) declarations
+
+static int scan_pread(const itemp_reader_config_t *config,
+                      const char *const *paths, size_t n_paths,
+                      itemp_reader_fn fn, void *arg);
+
+#ifdef HAVE_IO_URING
+static int scan_io_uring(const itemp_reader_config_t *config,
+                         const char *const *paths, size_t n_paths,
+                         itemp_reader_fn fn, void *arg);
+static int ring_init(ring_t *ring, unsigned entries);
+static void ring_exit(ring_t *ring);
+static bool ring_drain(ring_t *ring, unsigned to_submit, unsigned in_flight);
+static void ring_queue_read(ring_t *ring, const file_t *files, slot_t *slots,
+                            unsigned slot_index);
+static int cursor_next(cursor_t *cursor, slot_t *slot);
+static void file_release(file_t *file);
+#endif
+
+// =============================================================================
+// local storage
+
+// =============================================================================
+// public code
+
+void itemp_reader_config_init(itemp_reader_config_t *config) {
+  config->backend = ITEMP_READER_PREAD;
+  config->block_size = DEFAULT_BLOCK_SIZE;
+  config->queue_depth = DEFAULT_QUEUE_DEPTH;
+}
+
+bool itemp_reader_has_io_uring(void) {
+#ifdef HAVE_IO_URING
+  ring_t ring;
+  if (ring_init(&ring, 1) != 0) {
+    return false;
+  }
+  ring_exit(&ring);
+  return true;
+#else
+  return false;
+#endif
+}
+
+int itemp_reader_scan(const itemp_reader_config_t *config,
+                      const char *const *paths, size_t n_paths,
+                      itemp_reader_fn fn, void *arg) {
+  if (config->block_size == 0 || config->block_size % sizeof(itemp_t) != 0 ||
+      config->queue_depth == 0) {
+    return -EINVAL;
+  }
+#ifdef HAVE_IO_URING
+  if (config->backend == ITEMP_READER_IO_URING) {
+    return scan_io_uring(config, paths, n_paths, fn, arg);
+  }
+#endif
+  return scan_pread(config, paths, n_paths, fn, arg);
+}
+
+// =============================================================================
+// local (static) code
+
+static int scan_pread(const itemp_reader_config_t *config,
+                      const char *const *paths, size_t n_paths,
+                      itemp_reader_fn fn, void *arg) {
+  void *buffer;
+  int err = 0;
+
+  if (posix_memalign(&buffer, BUFFER_ALIGNMENT, config->block_size) != 0) {
+    return -ENOMEM;
+  }
+  for (size_t i = 0; i < n_paths && err == 0; i++) {
+    uint64_t offset = 0;
+    int fd = open(paths[i], O_RDONLY);
+    if (fd < 0) {
+      err = -errno;
+      break;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    while (err == 0) {
+      // fill a whole block unless the end of the file comes first
+      size_t filled = 0;
+      while (filled < config->block_size) {
+        ssize_t n = pread(fd, (uint8_t *)buffer + filled,
+                          config->block_size - filled, offset + filled);
+        if (n < 0 && errno == EINTR) {
+          continue;
+        }
+        if (n < 0) {
+          err = -errno;
+        }
+        if (n <= 0) {
+          break;
+        }
+        filled += n;
+      }
+      if (filled < sizeof(itemp_t)) {
+        break;
+      }
+      fn(arg, i, offset, buffer, filled / sizeof(itemp_t));
+      offset += filled;
+      if (filled < config->block_size) {
+        break;
+      }
+    }
+    close(fd);
+  }
+  free(buffer);
+  return err;
+}
+
+#ifdef HAVE_IO_URING
+
+static int scan_io_uring(const itemp_reader_config_t *config,
+                         const char *const *paths, size_t n_paths,
+                         itemp_reader_fn fn, void *arg) {
+  ring_t ring;
+  cursor_t cursor;
+  slot_t *slots;
+  unsigned *free_slots;
+  unsigned n_free;
+  unsigned depth;
+  unsigned in_flight = 0;
+  unsigned to_submit = 0;
+  uint8_t *buffers;
+  int err = 0;
+
+  if (ring_init(&ring, config->queue_depth) != 0) {
+    return scan_pread(config, paths, n_paths, fn, arg);
+  }
+  depth = (config->queue_depth < ring.entries) ? config->queue_depth
+                                               : ring.entries;
+  slots = calloc(depth, sizeof(slot_t));
+  free_slots = calloc(depth, sizeof(unsigned));
+  cursor.files = calloc(n_paths ? n_paths : 1, sizeof(file_t));
+  if (posix_memalign((void **)&buffers, BUFFER_ALIGNMENT,
+                     (size_t)depth * config->block_size) != 0) {
+    buffers = NULL;
+  }
+  if (slots == NULL || free_slots == NULL || cursor.files == NULL ||
+      buffers == NULL) {
+    err = -ENOMEM;
+    goto done;
+  }
+  for (unsigned i = 0; i < depth; i++) {
+    slots[i].buffer = buffers + (size_t)i * config->block_size;
+    free_slots[i] = i;
+  }
+  n_free = depth;
+  for (size_t i = 0; i < n_paths; i++) {
+    cursor.files[i].fd = -1;
+  }
+  cursor.paths = paths;
+  cursor.n_paths = n_paths;
+  cursor.block_size = config->block_size;
+  cursor.file_index = 0;
+  cursor.file_open = false;
+  cursor.offset = 0;
+
+  for (;;) {
+    // keep every free buffer busy with a read
+    while (err == 0 && n_free > 0) {
+      unsigned slot_index = free_slots[n_free - 1];
+      int ret = cursor_next(&cursor, &slots[slot_index]);
+      if (ret <= 0) {
+        err = ret;
+        break;
+      }
+      n_free -= 1;
+      ring_queue_read(&ring, cursor.files, slots, slot_index);
+      to_submit += 1;
+      in_flight += 1;
+    }
+    if (in_flight == 0) {
+      break;
+    }
+
+    int ret = syscall(__NR_io_uring_enter, ring.fd, to_submit, 1,
+                      IORING_ENTER_GETEVENTS, NULL, 0);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      err = -errno;
+      // the reads already submitted still write into buffers
+      if (!ring_drain(&ring, to_submit, in_flight)) {
+        // we cannot tell when they finish, so leak the buffers rather than
+        // free them under the kernel
+        buffers = NULL;
+        slots = NULL;
+      }
+      break;
+    }
+    to_submit -= (unsigned)ret;
+
+    unsigned head = *ring.cq_head;
+    unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+      struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+      unsigned slot_index = (unsigned)cqe->user_data;
+      slot_t *slot = &slots[slot_index];
+      int res = cqe->res;
+
+      head += 1;
+      __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+      if (res > 0) {
+        slot->filled += res;
+        if (slot->filled < slot->wanted) {
+          // short read: ask for the rest of the block
+          ring_queue_read(&ring, cursor.files, slots, slot_index);
+          to_submit += 1;
+          continue;
+        }
+      } else if (res < 0 && err == 0) {
+        err = res;
+      }
+      if (res >= 0 && slot->filled >= sizeof(itemp_t)) {
+        fn(arg, slot->file_index, slot->offset, (const itemp_t *)slot->buffer,
+           slot->filled / sizeof(itemp_t));
+      }
+      file_release(&cursor.files[slot->file_index]);
+      free_slots[n_free++] = slot_index;
+      in_flight -= 1;
+    }
+  }
+
+done:
+  // nothing is in flight here, so the buffers are ours again
+  ring_exit(&ring);
+  if (cursor.files != NULL) {
+    for (size_t i = 0; i < n_paths; i++) {
+      if (cursor.files[i].fd >= 0) {
+        close(cursor.files[i].fd);
+      }
+    }
+  }
+  free(buffers);
+  free(cursor.files);
+  free(free_slots);
+  free(slots);
+  return err;
+}
+
+static int ring_init(ring_t *ring, unsigned entries) {
+  struct io_uring_params params;
+
+  memset(ring, 0, sizeof(*ring));
+  memset(&params, 0, sizeof(params));
+  ring->fd = syscall(__NR_io_uring_setup, entries, &params);
+  if (ring->fd < 0) {
+    return -errno;
+  }
+  ring->entries = params.sq_entries;
+  ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_size =
+      params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    if (ring->cq_size > ring->sq_size) {
+      ring->sq_size = ring->cq_size;
+    }
+    ring->cq_size = ring->sq_size;
+  }
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+  ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ptr == MAP_FAILED) {
+    close(ring->fd);
+    return -ENOMEM;
+  }
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    ring->cq_ptr = ring->sq_ptr;
+  } else {
+    ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring->fd,
+                        IORING_OFF_CQ_RING);
+    if (ring->cq_ptr == MAP_FAILED) {
+      munmap(ring->sq_ptr, ring->sq_size);
+      close(ring->fd);
+      return -ENOMEM;
+    }
+  }
+  ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED) {
+    if (ring->cq_ptr != ring->sq_ptr) {
+      munmap(ring->cq_ptr, ring->cq_size);
+    }
+    munmap(ring->sq_ptr, ring->sq_size);
+    close(ring->fd);
+    return -ENOMEM;
+  }
+
+  uint8_t *sq = ring->sq_ptr;
+  uint8_t *cq = ring->cq_ptr;
+  ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+  ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+  ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+  ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+  ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+  ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+  return 0;
+}
+
+static void ring_exit(ring_t *ring) {
+  munmap(ring->sqes, ring->sqes_size);
+  if (ring->cq_ptr != ring->sq_ptr) {
+    munmap(ring->cq_ptr, ring->cq_size);
+  }
+  munmap(ring->sq_ptr, ring->sq_size);
+  close(ring->fd);
+}
+
+static bool ring_drain(ring_t *ring, unsigned to_submit, unsigned in_flight) {
+  // Closing the ring neither waits for nor cancels its reads, so wait for
+  // each one to complete, submitting any still queued so that they do too.
+  // Their results are dropped.
+  for (;;) {
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    in_flight -= tail - head;
+    __atomic_store_n(ring->cq_head, tail, __ATOMIC_RELEASE);
+    if (in_flight == 0) {
+      return true;
+    }
+    int ret = syscall(__NR_io_uring_enter, ring->fd, to_submit, 1,
+                      IORING_ENTER_GETEVENTS, NULL, 0);
+    if (ret < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+        continue;
+      }
+      return false;
+    }
+    to_submit -= (unsigned)ret;
+  }
+}
+
+static void ring_queue_read(ring_t *ring, const file_t *files, slot_t *slots,
+                            unsigned slot_index) {
+  slot_t *slot = &slots[slot_index];
+  unsigned tail = *ring->sq_tail;
+  unsigned index = tail & *ring->sq_mask;
+  struct io_uring_sqe *sqe = &ring->sqes[index];
+
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = files[slot->file_index].fd;
+  sqe->off = slot->offset + slot->filled;
+  sqe->addr = (uint64_t)(uintptr_t)(slot->buffer + slot->filled);
+  sqe->len = slot->wanted - slot->filled;
+  sqe->user_data = slot_index;
+  ring->sq_array[index] = index;
+  __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static int cursor_next(cursor_t *cursor, slot_t *slot) {
+  while (cursor->file_index < cursor->n_paths) {
+    file_t *file = &cursor->files[cursor->file_index];
+    if (!cursor->file_open) {
+      struct stat st;
+      file->fd = open(cursor->paths[cursor->file_index], O_RDONLY);
+      if (file->fd < 0) {
+        return -errno;
+      }
+      if (fstat(file->fd, &st) != 0) {
+        return -errno;
+      }
+      file->size = (uint64_t)st.st_size & ~(uint64_t)(sizeof(itemp_t) - 1);
+      cursor->file_open = true;
+      cursor->offset = 0;
+    }
+    if (cursor->offset < file->size) {
+      uint64_t remaining = file->size - cursor->offset;
+      slot->file_index = cursor->file_index;
+      slot->offset = cursor->offset;
+      slot->wanted = (remaining < cursor->block_size) ? (size_t)remaining
+                                                      : cursor->block_size;
+      slot->filled = 0;
+      cursor->offset += slot->wanted;
+      file->pending += 1;
+      return 1;
+    }
+    // every block of this file has been issued: close it once they land
+    file->issued = true;
+    file->pending += 1;
+    file_release(file);
+    cursor->file_index += 1;
+    cursor->file_open = false;
+  }
+  return 0;
+}
+
+static void file_release(file_t *file) {
+  file->pending -= 1;
+  if (file->pending == 0 && file->issued) {
+    close(file->fd);
+    file->fd = -1;
+  }
+}
+
+#endif
+
+// =============================================================================
+// self test
+
+// To run tests on a unix-like system:
+//   cc -Wall -c itemp.c
+//   cc -Wall -DUNIT_TEST -DITEMP_USE_IO_URING -c itemp_reader.c
+//   cc -o itemp_reader itemp_reader.o itemp.o && ./itemp_reader
+
+#ifdef UNIT_TEST
+
+#include "itemp_unit_test.h"
+
+#define TEST_FILES 3
+
+typedef struct {
+  uint64_t count;
+  uint64_t sum;
+  uint64_t blocks;
+} totals_t;
+
+static void accumulate(void *arg, size_t file_index, uint64_t offset,
+                       const itemp_t *itemps, size_t n) {
+  totals_t *totals = arg;
+  for (size_t i = 0; i < n; i++) {
+    // each value encodes its own position, so misplaced blocks are caught
+    totals->sum += (itemps[i] == (itemp_t)(file_index + offset / 2 + i));
+  }
+  totals->count += n;
+  totals->blocks += 1;
+}
+
+static void check_backend(itemp_reader_backend_t backend,
+                          const char *const *paths, uint64_t expected) {
+  itemp_reader_config_t config;
+  totals_t totals = {0, 0, 0};
+
+  itemp_reader_config_init(&config);
+  config.backend = backend;
+  config.block_size = 1000;
+  config.queue_depth = 4;
+  ASSERT_INT(itemp_reader_scan(&config, paths, TEST_FILES, accumulate,
+                               &totals),
+             0);
+  ASSERT_INT(totals.count, expected);
+  ASSERT_INT(totals.sum, expected);
+}
+
+#ifdef HAVE_IO_URING
+/**
+ * @brief Queue reads of the file, submit some of them, and check that
+ * ring_drain() waits for all of them.
+ */
+static void check_drain(const char *path) {
+  ring_t ring;
+  file_t file = {open(path, O_RDONLY), 0, 0, false};
+  slot_t slots[4];
+  uint8_t buffers[4][1000];
+
+  if (ring_init(&ring, 4) != 0) {
+    close(file.fd);
+    return;  // io_uring is not available here
+  }
+  for (unsigned i = 0; i < 4; i++) {
+    slots[i] = (slot_t){0, (uint64_t)i * 1000, 1000, 0, buffers[i]};
+    ring_queue_read(&ring, &file, slots, i);
+  }
+  int submitted = syscall(__NR_io_uring_enter, ring.fd, 2, 0, 0, NULL, 0);
+  ASSERT_INT(submitted, 2);
+  ASSERT_INT(ring_drain(&ring, 2, 4), true);
+  ASSERT_INT(*ring.cq_head, __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE));
+  ASSERT_INT(*ring.cq_head, 4);
+  ring_exit(&ring);
+  close(file.fd);
+}
+#endif
+
+int main() {
+  printf("Beginning unit tests...");
+
+  char names[TEST_FILES][32];
+  const char *paths[TEST_FILES];
+  size_t sizes[TEST_FILES] = {0, 1234, 5001};  // empty, short, odd length
+  uint64_t expected = 0;
+
+  for (size_t f = 0; f < TEST_FILES; f++) {
+    snprintf(names[f], sizeof(names[f]), "/tmp/itemp_reader_%zu.bin", f);
+    paths[f] = names[f];
+    FILE *fp = fopen(names[f], "wb");
+    for (size_t i = 0; i < sizes[f] / 2; i++) {
+      itemp_t itemp = (itemp_t)(f + i);
+      fwrite(&itemp, sizeof(itemp), 1, fp);
+    }
+    if (sizes[f] % 2) {
+      fputc(0xff, fp);
+    }
+    fclose(fp);
+    expected += sizes[f] / 2;
+  }
+
+  check_backend(ITEMP_READER_PREAD, paths, expected);
+  check_backend(ITEMP_READER_IO_URING, paths, expected);
+#ifdef HAVE_IO_URING
+  check_drain(paths[2]);
+#endif
+
+  const char *missing[] = {"/tmp/itemp_reader_missing.bin"};
+  itemp_reader_config_t config;
+  itemp_reader_config_init(&config);
+  ASSERT_INT(itemp_reader_scan(&config, missing, 1, accumulate, NULL),
+             -ENOENT);
+  config.block_size = 3;
+  ASSERT_INT(itemp_reader_scan(&config, paths, 1, accumulate, NULL), -EINVAL);
+
+  for (size_t f = 0; f < TEST_FILES; f++) {
+    remove(names[f]);
+  }
+
+  printf("\r\n...unit tests complete.\r\n");
+}
+
+#endif
@@ -0,0 +1,110 @@
+/** @file itemp_reader.h
+ * Bulk reader for files of itemp values.  Files are read in fixed size blocks
+ * and each block is handed to a callback, typically one that feeds the stats
+ * kernels in itemp_stats.h.
+ *
+ * On Linux, compiling with -DITEMP_USE_IO_URING enables a backend that keeps
+ * many block reads in flight through io_uring.  It talks to the kernel directly
+ * and needs no extra libraries.  Otherwise, or if the kernel refuses to set up a
+ * ring, blocks are read one at a time with pread().
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_READER_H_
+#define _ITEMP_READER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// types and definitions
+
+typedef enum {
+  ITEMP_READER_PREAD,     // one blocking pread() at a time
+  ITEMP_READER_IO_URING,  // many reads in flight (falls back to pread)
+} itemp_reader_backend_t;
+
+typedef struct {
+  itemp_reader_backend_t backend;
+  size_t block_size;      // bytes per read, a multiple of sizeof(itemp_t)
+  unsigned queue_depth;   // reads kept in flight by the io_uring backend
+} itemp_reader_config_t;
+
+/**
+ * @brief Called once for each block read.
+ *
+ * With the io_uring backend blocks may arrive out of order, so the file index
+ * and byte offset of the block are passed along.  The buffer is reused once
+ * the callback returns.
+ *
+ * @param arg The argument given to itemp_reader_scan().
+ * @param file_index Index into the paths given to itemp_reader_scan().
+ * @param offset Byte offset of the block within the file.
+ * @param itemps The values read.
+ * @param n The number of values read.
+ */
+typedef void (*itemp_reader_fn)(void *arg, size_t file_index, uint64_t offset,
+                                const itemp_t *itemps, size_t n);
+
+// =============================================================================
+// declarations
+
+/**
+ * Fill config with defaults: the pread backend, 256K byte blocks and a queue
+ * depth of 32.
+ */
+void itemp_reader_config_init(itemp_reader_config_t *config);
+
+/**
+ * Return true if the io_uring backend was compiled in and the running kernel
+ * supports it.
+ */
+bool itemp_reader_has_io_uring(void);
+
+/**
+ * Read every block of every file in paths, calling fn for each.
+ *
+ * A trailing odd byte in a file is ignored.
+ *
+ * @returns 0 on success or a negative errno value on the first failure, in
+ * which case reading stops.
+ */
+int itemp_reader_scan(const itemp_reader_config_t *config,
+                      const char *const *paths, size_t n_paths,
+                      itemp_reader_fn fn, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _ITEMP_READER_H_ */
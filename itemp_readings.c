@@ -0,0 +1,347 @@
+/** @file itemp_readings.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp_readings.h"
+#include <stdlib.h>
+#include <string.h>
+
+// =============================================================================
+// local types and definitions
+
+// Rows allocated the first time a batch grows.
+#define MIN_ROWS 1024
+
+// The most rows a batch can hold: the largest power of two whose timestamp
+// column, the widest, has a size that fits in a size_t.
+#define MAX_ROWS ((SIZE_MAX / sizeof(int64_t) >> 1) + 1)
+
+// =============================================================================
+// local (forward) declarations
+
+/**
+ * @brief Return the size class of a buffer of size bytes, or -1 if too big.
+ */
+static int size_class(size_t size);
+
+/**
+ * @brief Return the smallest power of two >= n.
+ */
+static size_t round_up_pow2(size_t n);
+
+// =============================================================================
+// local storage
+
+// =============================================================================
+// public code
+
+void itemp_pool_init(itemp_pool_t *pool) {
+  memset(pool, 0, sizeof(*pool));
+}
+
+void *itemp_pool_alloc(itemp_pool_t *pool, size_t size, size_t *capacity) {
+  int k = size_class(size);
+  void *buffer;
+
+  if (k < 0) {
+    *capacity = 0;
+    return NULL;
+  }
+  *capacity = (size_t)ITEMP_POOL_ALIGNMENT << k;
+  buffer = pool->free_lists[k];
+  if (buffer != NULL) {
+    // a free buffer holds the link to the next one in its first bytes
+    pool->free_lists[k] = *(void **)buffer;
+    pool->bytes_free -= *capacity;
+    return buffer;
+  }
+  if (posix_memalign(&buffer, ITEMP_POOL_ALIGNMENT, *capacity) != 0) {
+    *capacity = 0;
+    return NULL;
+  }
+  pool->bytes_allocated += *capacity;
+  return buffer;
+}
+
+void itemp_pool_release(itemp_pool_t *pool, void *buffer, size_t capacity) {
+  int k = size_class(capacity);
+
+  if (buffer == NULL || k < 0) {
+    return;
+  }
+  *(void **)buffer = pool->free_lists[k];
+  pool->free_lists[k] = buffer;
+  pool->bytes_free += capacity;
+}
+
+void itemp_pool_trim(itemp_pool_t *pool) {
+  for (int k = 0; k < ITEMP_POOL_CLASSES; k++) {
+    while (pool->free_lists[k] != NULL) {
+      void *buffer = pool->free_lists[k];
+      pool->free_lists[k] = *(void **)buffer;
+      free(buffer);
+      pool->bytes_allocated -= (size_t)ITEMP_POOL_ALIGNMENT << k;
+    }
+  }
+  pool->bytes_free = 0;
+}
+
+void itemp_readings_init(itemp_readings_t *readings, itemp_pool_t *pool) {
+  readings->sensor_ids = NULL;
+  readings->timestamps = NULL;
+  readings->itemps = NULL;
+  readings->count = 0;
+  readings->capacity = 0;
+  readings->pool = pool;
+}
+
+bool itemp_readings_reserve(itemp_readings_t *readings, size_t capacity) {
+  itemp_pool_t *pool = readings->pool;
+  size_t sensor_bytes, timestamp_bytes, itemp_bytes;
+  uint32_t *sensor_ids;
+  int64_t *timestamps;
+  itemp_t *itemps;
+
+  if (capacity <= readings->capacity) {
+    return true;
+  }
+  if (capacity > MAX_ROWS) {
+    return false;
+  }
+  capacity = round_up_pow2(capacity < MIN_ROWS ? MIN_ROWS : capacity);
+  sensor_ids = itemp_pool_alloc(pool, capacity * sizeof(uint32_t),
+                                &sensor_bytes);
+  timestamps = itemp_pool_alloc(pool, capacity * sizeof(int64_t),
+                                &timestamp_bytes);
+  itemps = itemp_pool_alloc(pool, capacity * sizeof(itemp_t), &itemp_bytes);
+  if (sensor_ids == NULL || timestamps == NULL || itemps == NULL) {
+    itemp_pool_release(pool, sensor_ids, sensor_bytes);
+    itemp_pool_release(pool, timestamps, timestamp_bytes);
+    itemp_pool_release(pool, itemps, itemp_bytes);
+    return false;
+  }
+
+  if (readings->count > 0) {
+    memcpy(sensor_ids, readings->sensor_ids,
+           readings->count * sizeof(uint32_t));
+    memcpy(timestamps, readings->timestamps,
+           readings->count * sizeof(int64_t));
+    memcpy(itemps, readings->itemps, readings->count * sizeof(itemp_t));
+  }
+  size_t count = readings->count;
+  itemp_readings_release(readings);
+  readings->sensor_ids = sensor_ids;
+  readings->timestamps = timestamps;
+  readings->itemps = itemps;
+  readings->count = count;
+  readings->capacity = capacity;
+  return true;
+}
+
+bool itemp_readings_append(itemp_readings_t *readings, uint32_t sensor_id,
+                           int64_t timestamp, itemp_t itemp) {
+  size_t i = readings->count;
+
+  if (i == readings->capacity &&
+      !itemp_readings_reserve(readings, i ? 2 * i : MIN_ROWS)) {
+    return false;
+  }
+  readings->sensor_ids[i] = sensor_id;
+  readings->timestamps[i] = timestamp;
+  readings->itemps[i] = itemp;
+  readings->count = i + 1;
+  return true;
+}
+
+bool itemp_readings_append_columns(itemp_readings_t *readings,
+                                   const uint32_t *sensor_ids,
+                                   const int64_t *timestamps,
+                                   const itemp_t *itemps, size_t n) {
+  size_t i = readings->count;
+
+  if (n > MAX_ROWS - i) {
+    return false;
+  }
+  if (i + n > readings->capacity) {
+    size_t capacity = 2 * readings->capacity;
+    if (capacity > MAX_ROWS) {
+      capacity = MAX_ROWS;
+    }
+    if (!itemp_readings_reserve(readings,
+                                (i + n > capacity) ? i + n : capacity)) {
+      return false;
+    }
+  }
+  memcpy(&readings->sensor_ids[i], sensor_ids, n * sizeof(uint32_t));
+  memcpy(&readings->timestamps[i], timestamps, n * sizeof(int64_t));
+  memcpy(&readings->itemps[i], itemps, n * sizeof(itemp_t));
+  readings->count = i + n;
+  return true;
+}
+
+void itemp_readings_clear(itemp_readings_t *readings) { readings->count = 0; }
+
+void itemp_readings_release(itemp_readings_t *readings) {
+  size_t capacity = readings->capacity;
+
+  if (capacity > 0) {
+    itemp_pool_release(readings->pool, readings->sensor_ids,
+                       capacity * sizeof(uint32_t));
+    itemp_pool_release(readings->pool, readings->timestamps,
+                       capacity * sizeof(int64_t));
+    itemp_pool_release(readings->pool, readings->itemps,
+                       capacity * sizeof(itemp_t));
+  }
+  itemp_readings_init(readings, readings->pool);
+}
+
+// =============================================================================
+// local (static) code
+
+static int size_class(size_t size) {
+  int k = 0;
+  while (((size_t)ITEMP_POOL_ALIGNMENT << k) < size) {
+    k += 1;
+    if (k == ITEMP_POOL_CLASSES) {
+      return -1;
+    }
+  }
+  return k;
+}
+
+static size_t round_up_pow2(size_t n) {
+  size_t p = 1;
+  while (p < n) {
+    p <<= 1;
+  }
+  return p;
+}
+
+// =============================================================================
+// self test
+
+// To run tests on a unix-like system:
+//   cc -Wall -c itemp.c itemp_batch.c itemp_stats.c
+//   cc -Wall -DUNIT_TEST -c itemp_readings.c
+//   cc -o itemp_readings itemp_readings.o itemp.o itemp_batch.o itemp_stats.o
+//   ./itemp_readings
+
+#ifdef UNIT_TEST
+
+#include "itemp_batch.h"
+#include "itemp_stats.h"
+#include "itemp_unit_test.h"
+
+#define N_ROWS 5000
+
+static int16_t s_f100[N_ROWS];
+
+int main() {
+  printf("Beginning unit tests...");
+
+  itemp_pool_t pool;
+  itemp_readings_t readings;
+  itemp_stats_t stats;
+
+  uint32_t sensor_ids[3] = {1, 2, 3};
+  int64_t timestamps[3] = {10, 20, 30};
+  itemp_t itemps[3] = {100, 200, 300};
+
+  itemp_pool_init(&pool);
+  itemp_readings_init(&readings, &pool);
+  ASSERT_INT(readings.count, 0);
+
+  // ===========================================
+  // growth keeps rows and alignment
+
+  for (int i = 0; i < N_ROWS; i++) {
+    ASSERT_INT(itemp_readings_append(&readings, i % 7, 1000 + i,
+                                     fahrenheit_10_to_itemp(600 + i % 100)),
+               true);
+  }
+  ASSERT_INT(readings.count, N_ROWS);
+  ASSERT_INT(readings.capacity, 8192);
+  ASSERT_INT((uintptr_t)readings.sensor_ids % ITEMP_POOL_ALIGNMENT, 0);
+  ASSERT_INT((uintptr_t)readings.timestamps % ITEMP_POOL_ALIGNMENT, 0);
+  ASSERT_INT((uintptr_t)readings.itemps % ITEMP_POOL_ALIGNMENT, 0);
+  ASSERT_INT(readings.sensor_ids[4999], 4999 % 7);
+  ASSERT_INT(readings.timestamps[4999], 5999);
+  ASSERT_INT(readings.sensor_ids[0], 0);
+  ASSERT_INT(readings.timestamps[0], 1000);
+
+  // ===========================================
+  // kernels take the columns directly
+
+  itemp_stats_init(&stats);
+  itemp_stats_update(&stats, readings.itemps, readings.count);
+  ASSERT_INT(itemp_to_fahrenheit_10(stats.min), 600);
+  ASSERT_INT(itemp_to_fahrenheit_10(stats.max), 699);
+
+  itemp_to_fahrenheit_100_batch(readings.itemps, s_f100, readings.count);
+  ASSERT_INT(s_f100[123], 6230);
+
+  // ===========================================
+  // capacities whose columns would overflow are refused
+
+  ASSERT_INT(itemp_readings_reserve(&readings, SIZE_MAX), false);
+  ASSERT_INT(itemp_readings_reserve(&readings, SIZE_MAX / 2 + 2), false);
+  ASSERT_INT(itemp_readings_reserve(&readings, MAX_ROWS + 1), false);
+  ASSERT_INT(itemp_readings_append_columns(&readings, sensor_ids, timestamps,
+                                           itemps, SIZE_MAX - 1),
+             false);
+  ASSERT_INT(readings.count, N_ROWS);
+  ASSERT_INT(readings.capacity, 8192);
+  ASSERT_INT(readings.timestamps[4999], 5999);
+
+  // ===========================================
+  // buffers are recycled between cycles
+
+  size_t allocated = pool.bytes_allocated;
+  itemp_readings_clear(&readings);
+  ASSERT_INT(readings.capacity, 8192);
+  itemp_readings_release(&readings);
+  ASSERT_INT(pool.bytes_free, pool.bytes_allocated);
+
+  for (int cycle = 0; cycle < 10; cycle++) {
+    for (int i = 0; i < N_ROWS / 3; i++) {
+      itemp_readings_append_columns(&readings, sensor_ids, timestamps, itemps,
+                                    3);
+    }
+    ASSERT_INT(readings.count, (N_ROWS / 3) * 3);
+    ASSERT_INT(readings.itemps[readings.count - 1], 300);
+    itemp_readings_release(&readings);
+  }
+  ASSERT_INT(pool.bytes_allocated == allocated, true);
+
+  itemp_pool_trim(&pool);
+  ASSERT_INT(pool.bytes_allocated, 0);
+  ASSERT_INT(pool.bytes_free, 0);
+
+  printf("\r\n...unit tests complete.\r\n");
+}
+
+#endif
@@ -0,0 +1,177 @@
+/** @file itemp_readings.h
+ * Columnar storage for batches of sensor readings.
+ *
+ * A batch keeps sensor ids, timestamps and itemp values in three separate,
+ * 64 byte aligned arrays rather than an array of structs, so each column can be
+ * handed straight to the batch kernels:
+ *
+ * @code
+ * itemp_pool_t pool;
+ * itemp_readings_t readings;
+ * itemp_pool_init(&pool);
+ * itemp_readings_init(&readings, &pool);
+ * ...
+ * itemp_readings_append(&readings, sensor_id, timestamp, itemp);
+ * ...
+ * itemp_stats_update(&stats, readings.itemps, readings.count);
+ * itemp_to_fahrenheit_100_batch(readings.itemps, f100, readings.count);
+ * itemp_readings_clear(&readings);   // keep the columns for the next cycle
+ * @endcode
+ *
+ * Column buffers come from an itemp_pool_t, which keeps released buffers on
+ * free lists by power of two size, so repeated ingest cycles stop calling
+ * malloc() once they reach a steady state.  A pool is not thread safe: give
+ * each thread its own, or guard it externally.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_READINGS_H_
+#define _ITEMP_READINGS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// types and definitions
+
+/**
+ * @brief Alignment of every buffer handed out by an itemp_pool_t.
+ */
+#define ITEMP_POOL_ALIGNMENT 64
+
+/**
+ * @brief Number of power of two size classes, from 64 bytes up.
+ */
+#define ITEMP_POOL_CLASSES 40
+
+/**
+ * @brief A recycling allocator for column buffers.
+ */
+typedef struct {
+  void *free_lists[ITEMP_POOL_CLASSES];  // released buffers, by size class
+  size_t bytes_allocated;                // obtained from the system
+  size_t bytes_free;                     // held on the free lists
+} itemp_pool_t;
+
+/**
+ * @brief A batch of readings stored as columns.
+ *
+ * Row i is (sensor_ids[i], timestamps[i], itemps[i]) for i < count.  The
+ * column pointers change when the batch grows.
+ */
+typedef struct {
+  uint32_t *sensor_ids;
+  int64_t *timestamps;
+  itemp_t *itemps;
+  size_t count;
+  size_t capacity;
+  itemp_pool_t *pool;
+} itemp_readings_t;
+
+// =============================================================================
+// declarations
+
+/**
+ * Initialize an empty pool.
+ */
+void itemp_pool_init(itemp_pool_t *pool);
+
+/**
+ * Return a buffer of at least size bytes, aligned to ITEMP_POOL_ALIGNMENT.
+ *
+ * @param pool The pool to allocate from.
+ * @param size The number of bytes needed.
+ * @param capacity Receives the usable size of the buffer, a power of two,
+ *                 or 0 if there is no buffer.
+ * @returns The buffer, or NULL if out of memory.
+ */
+void *itemp_pool_alloc(itemp_pool_t *pool, size_t size, size_t *capacity);
+
+/**
+ * Return a buffer to the pool's free list for reuse.
+ *
+ * @param capacity The capacity returned by itemp_pool_alloc().
+ */
+void itemp_pool_release(itemp_pool_t *pool, void *buffer, size_t capacity);
+
+/**
+ * Free every buffer held on the pool's free lists.
+ */
+void itemp_pool_trim(itemp_pool_t *pool);
+
+/**
+ * Initialize an empty batch whose columns come from pool.
+ */
+void itemp_readings_init(itemp_readings_t *readings, itemp_pool_t *pool);
+
+/**
+ * Make room for at least capacity rows, keeping the current rows.
+ *
+ * @returns false if out of memory or capacity is too large for the columns'
+ * sizes to fit in a size_t, in which case the batch is unchanged.
+ */
+bool itemp_readings_reserve(itemp_readings_t *readings, size_t capacity);
+
+/**
+ * Append one row, growing the columns as needed.
+ *
+ * @returns false if out of memory.
+ */
+bool itemp_readings_append(itemp_readings_t *readings, uint32_t sensor_id,
+                           int64_t timestamp, itemp_t itemp);
+
+/**
+ * Append n rows given as columns.
+ *
+ * @returns false if out of memory, in which case nothing is appended.
+ */
+bool itemp_readings_append_columns(itemp_readings_t *readings,
+                                   const uint32_t *sensor_ids,
+                                   const int64_t *timestamps,
+                                   const itemp_t *itemps, size_t n);
+
+/**
+ * Remove every row but keep the columns for reuse.
+ */
+void itemp_readings_clear(itemp_readings_t *readings);
+
+/**
+ * Remove every row and return the columns to the pool.
+ */
+void itemp_readings_release(itemp_readings_t *readings);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _ITEMP_READINGS_H_ */
@@ -0,0 +1,561 @@
+/** @file itemp_romgen.c
+ * itemp-romgen: generate C source for compact, flash resident lookup tables
+ * that convert itemps to degrees, with their decoders.
+ *
+ * To build on a unix-like system:
+ *   cc -O2 -Wall -o itemp-romgen itemp_romgen.c itemp.c
+ *
+ *   ./itemp-romgen -t f10 -o f10_rom.c          itemp_to_fahrenheit_10()
+ *   ./itemp-romgen -t c100 -m steps -b 32       smaller, slower
+ *   ./itemp-romgen -t f10 -s                    bytes and lookup time of every
+ *                                               mode and block size
+ *
+ * Each mode trades flash for lookup time:
+ *
+ *   full    an int16_t per itemp: 128 KiB, one read
+ *   delta8  an int16_t base per block of -b itemps, plus an 8 bit offset from
+ *           it per itemp: 64 KiB and the bases, two reads
+ *   delta4  the same with 4 bit offsets: 32 KiB and the bases
+ *   steps   a base per block plus 1 bit per itemp, set where the value rises
+ *           by one: 8 KiB and the bases, but a lookup adds up the bits
+ *           before the itemp in its block
+ *
+ * Smaller blocks cost more bases but keep offsets small enough for delta4 and
+ * make steps lookups shorter.  Before writing anything, the generator decodes
+ * every itemp as the emitted code does and compares the result with the
+ * itemp.h function; the emitted file repeats that check when built with
+ * -DUNIT_TEST.  Tables are declared ITEMP_ROM, which defaults to const; on AVR
+ * define it as "const __flash" to keep them out of RAM.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// =============================================================================
+// local types and definitions
+
+#define N_ITEMPS 65536
+#define MIN_BLOCK 8
+#define SURVEY_REPETITIONS 5
+
+typedef enum {
+  MODE_FULL,
+  MODE_DELTA8,
+  MODE_DELTA4,
+  MODE_STEPS,
+  N_MODES
+} rom_mode_t;
+
+// A conversion that can be tabulated.
+typedef struct {
+  const char *key;  // for -t
+  const char *name;
+  int16_t (*fn)(itemp_t itemp);
+} table_t;
+
+// An encoded table: base[itemp >> shift] plus something from payload.
+typedef struct {
+  rom_mode_t mode;
+  int shift;  // log2 of the block size; 0 for MODE_FULL
+  size_t n_bases;
+  int16_t *bases;
+  size_t n_payload;
+  uint8_t *payload;  // offsets, nibbles or step bits, by mode
+} encoding_t;
+
+// =============================================================================
+// local (forward) declarations
+
+static void usage(const char *program);
+static const table_t *find_table(const char *key);
+static bool find_mode(const char *name, rom_mode_t *mode);
+
+/**
+ * @brief Encode values as mode with blocks of 1 << shift.  Return false, with
+ * the encoding freed, if some block's values do not fit the mode.
+ */
+static bool encode(const int16_t *values, rom_mode_t mode, int shift,
+                   encoding_t *encoding);
+static void encoding_free(encoding_t *encoding);
+static size_t encoding_bytes(const encoding_t *encoding);
+
+/**
+ * @brief Look up itemp as the emitted decoder does.
+ */
+static int16_t decode(const encoding_t *encoding, itemp_t itemp);
+
+/**
+ * @brief Decode every itemp and return how many differ from values.
+ */
+static int check(const encoding_t *encoding, const int16_t *values);
+static int survey(const table_t *table, const int16_t *values);
+static double time_lookups(const encoding_t *encoding);
+static void emit(FILE *out, const table_t *table, const encoding_t *encoding,
+                 const char *function, const char *command);
+static void emit_array(FILE *out, const char *type, const char *name,
+                       const void *data, size_t n, bool wide);
+static uint8_t popcount_8(uint8_t x);
+static uint64_t now_ns(void);
+
+// =============================================================================
+// local storage
+
+static const table_t s_tables[] = {
+    {"f1", "itemp_to_fahrenheit_1", itemp_to_fahrenheit_1},
+    {"f10", "itemp_to_fahrenheit_10", itemp_to_fahrenheit_10},
+    {"f100", "itemp_to_fahrenheit_100", itemp_to_fahrenheit_100},
+    {"c1", "itemp_to_celsius_1", itemp_to_celsius_1},
+    {"c10", "itemp_to_celsius_10", itemp_to_celsius_10},
+    {"c100", "itemp_to_celsius_100", itemp_to_celsius_100},
+};
+#define N_TABLES (sizeof(s_tables) / sizeof(s_tables[0]))
+
+static const char *s_mode_names[N_MODES] = {"full", "delta8", "delta4",
+                                            "steps"};
+
+static int16_t s_values[N_ITEMPS];
+
+// Keeps the timed lookups from being optimized away.
+static volatile int32_t s_sink;
+
+// =============================================================================
+// public code
+
+int main(int argc, char *argv[]) {
+  const table_t *table = find_table("f10");
+  rom_mode_t mode = MODE_DELTA8;
+  long block = 256;
+  bool do_survey = false;
+  const char *function = NULL;
+  const char *path = NULL;
+  char default_function[64];
+  char command[256];
+  encoding_t encoding;
+  int shift = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "b:m:n:o:st:")) != -1) {
+    switch (opt) {
+    case 'b':
+      block = strtol(optarg, NULL, 0);
+      break;
+    case 'm':
+      if (!find_mode(optarg, &mode)) {
+        usage(argv[0]);
+        return 2;
+      }
+      break;
+    case 'n':
+      function = optarg;
+      break;
+    case 'o':
+      path = optarg;
+      break;
+    case 's':
+      do_survey = true;
+      break;
+    case 't':
+      table = find_table(optarg);
+      if (table == NULL) {
+        usage(argv[0]);
+        return 2;
+      }
+      break;
+    default:
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  while (mode != MODE_FULL && shift < 16 && (1L << shift) < block) {
+    shift++;
+  }
+  if (optind != argc ||
+      (mode != MODE_FULL && (block < MIN_BLOCK || (1L << shift) != block))) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  for (int32_t i = 0; i < N_ITEMPS; i++) {
+    s_values[i] = table->fn((itemp_t)i);
+  }
+  if (do_survey) {
+    return survey(table, s_values);
+  }
+  if (!encode(s_values, mode, shift, &encoding)) {
+    fprintf(stderr,
+            "%s does not fit %s with blocks of %ld: try a smaller block\n",
+            table->name, s_mode_names[mode], block);
+    return 1;
+  }
+  int mismatches = check(&encoding, s_values);
+  if (mismatches != 0) {
+    fprintf(stderr, "%d itemps decode differently from %s\n", mismatches,
+            table->name);
+    encoding_free(&encoding);
+    return 1;
+  }
+
+  if (function == NULL) {
+    snprintf(default_function, sizeof(default_function), "%s_rom",
+             table->name);
+    function = default_function;
+  }
+  size_t length = snprintf(command, sizeof(command), "itemp-romgen");
+  for (int i = 1; i < argc && length < sizeof(command); i++) {
+    length += snprintf(command + length, sizeof(command) - length, " %s",
+                       argv[i]);
+  }
+  FILE *out = (path != NULL) ? fopen(path, "w") : stdout;
+  if (out == NULL) {
+    perror(path);
+    encoding_free(&encoding);
+    return 1;
+  }
+  emit(out, table, &encoding, function, command);
+  fprintf(stderr, "%s: %s, %zu bytes, checked against %s for all %d itemps\n",
+          function, s_mode_names[mode], encoding_bytes(&encoding), table->name,
+          N_ITEMPS);
+  encoding_free(&encoding);
+  if (out != stdout && fclose(out) != 0) {
+    perror(path);
+    return 1;
+  }
+  return 0;
+}
+
+// =============================================================================
+// local (static) code
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  -t TABLE  f1, f10, f100, c1, c10 or c100 (default f10)\n"
+          "  -m MODE   full, delta8, delta4 or steps (default delta8)\n"
+          "  -b N      itemps per block, a power of two from %d (default 256)\n"
+          "  -n NAME   name of the decoder (default itemp_to_xxx_rom)\n"
+          "  -o FILE   write the C source to FILE rather than stdout\n"
+          "  -s        print the size and lookup time of every mode and\n"
+          "            block size instead\n",
+          program, MIN_BLOCK);
+}
+
+static const table_t *find_table(const char *key) {
+  for (size_t t = 0; t < N_TABLES; t++) {
+    if (strcmp(s_tables[t].key, key) == 0) {
+      return &s_tables[t];
+    }
+  }
+  return NULL;
+}
+
+static bool find_mode(const char *name, rom_mode_t *mode) {
+  for (int m = 0; m < N_MODES; m++) {
+    if (strcmp(s_mode_names[m], name) == 0) {
+      *mode = (rom_mode_t)m;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool encode(const int16_t *values, rom_mode_t mode, int shift,
+                   encoding_t *encoding) {
+  size_t block = (size_t)1 << shift;
+
+  encoding->mode = mode;
+  encoding->shift = shift;
+  encoding->n_bases = N_ITEMPS >> shift;
+  encoding->n_payload = (mode == MODE_FULL)     ? 0
+                        : (mode == MODE_DELTA8) ? N_ITEMPS
+                        : (mode == MODE_DELTA4) ? N_ITEMPS / 2
+                                                : N_ITEMPS / 8;
+  encoding->bases = malloc(encoding->n_bases * sizeof(int16_t));
+  encoding->payload = calloc(encoding->n_payload + 1, 1);
+  if (encoding->bases == NULL || encoding->payload == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+  for (size_t b = 0; b < encoding->n_bases; b++) {
+    const int16_t *v = values + b * block;
+    encoding->bases[b] = v[0];
+    for (size_t j = 0; j < block && mode != MODE_FULL; j++) {
+      size_t i = b * block + j;
+      int32_t offset = v[j] - v[0];
+      int32_t step = (j == 0) ? 0 : v[j] - v[j - 1];
+      if ((mode == MODE_DELTA8 && (offset < 0 || offset > 255)) ||
+          (mode == MODE_DELTA4 && (offset < 0 || offset > 15)) ||
+          (mode == MODE_STEPS && (step < 0 || step > 1))) {
+        encoding_free(encoding);
+        return false;
+      }
+      if (mode == MODE_DELTA8) {
+        encoding->payload[i] = (uint8_t)offset;
+      } else if (mode == MODE_DELTA4) {
+        encoding->payload[i / 2] |= (uint8_t)(offset << ((i & 1) * 4));
+      } else {
+        encoding->payload[i / 8] |= (uint8_t)(step << (i & 7));
+      }
+    }
+  }
+  return true;
+}
+
+static void encoding_free(encoding_t *encoding) {
+  free(encoding->bases);
+  free(encoding->payload);
+  encoding->bases = NULL;
+  encoding->payload = NULL;
+}
+
+static size_t encoding_bytes(const encoding_t *encoding) {
+  return encoding->n_bases * sizeof(int16_t) + encoding->n_payload;
+}
+
+static int16_t decode(const encoding_t *encoding, itemp_t itemp) {
+  int16_t value = encoding->bases[itemp >> encoding->shift];
+  switch (encoding->mode) {
+  case MODE_DELTA8:
+    return value + encoding->payload[itemp];
+  case MODE_DELTA4:
+    return value + ((encoding->payload[itemp >> 1] >> ((itemp & 1) * 4)) & 15);
+  case MODE_STEPS: {
+    // the steps from the start of the block up to and including itemp's
+    const uint8_t *p =
+        &encoding->payload[(itemp >> encoding->shift) << (encoding->shift - 3)];
+    uint16_t n = itemp & ((1u << encoding->shift) - 1);
+    for (; n >= 8; n -= 8) {
+      value += popcount_8(*p++);
+    }
+    return value + popcount_8(*p & (uint8_t)((2u << n) - 1));
+  }
+  case MODE_FULL:
+  default:
+    return value;
+  }
+}
+
+static int check(const encoding_t *encoding, const int16_t *values) {
+  int mismatches = 0;
+  for (int32_t i = 0; i < N_ITEMPS; i++) {
+    mismatches += decode(encoding, (itemp_t)i) != values[i];
+  }
+  return mismatches;
+}
+
+static int survey(const table_t *table, const int16_t *values) {
+  encoding_t encoding;
+  char block[16];
+
+  printf("%s\n%-8s %6s %8s %10s\n", table->name, "mode", "block", "bytes",
+         "ns/lookup");
+  for (int m = 0; m < N_MODES; m++) {
+    for (int shift = 3; shift <= 12; shift++) {
+      if (m == MODE_FULL && shift > 3) {
+        break;
+      }
+      if (!encode(values, (rom_mode_t)m, m == MODE_FULL ? 0 : shift,
+                  &encoding)) {
+        continue;  // offsets too large for this block size
+      }
+      if (check(&encoding, values) != 0) {
+        fprintf(stderr, "%s %d: decodes differently from %s\n",
+                s_mode_names[m], 1 << shift, table->name);
+        encoding_free(&encoding);
+        return 1;
+      }
+      snprintf(block, sizeof(block), "%d", 1 << shift);
+      printf("%-8s %6s %8zu %10.2f\n", s_mode_names[m],
+             m == MODE_FULL ? "-" : block, encoding_bytes(&encoding),
+             time_lookups(&encoding));
+      encoding_free(&encoding);
+    }
+  }
+  return 0;
+}
+
+static double time_lookups(const encoding_t *encoding) {
+  static itemp_t order[N_ITEMPS];
+  uint32_t seed = 0x1234567;
+  double best = 0;
+
+  // random order, so that the host's caches do not flatter the big tables
+  for (int32_t i = 0; i < N_ITEMPS; i++) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    order[i] = (itemp_t)seed;
+  }
+  for (int r = 0; r < SURVEY_REPETITIONS; r++) {
+    int32_t sum = 0;
+    uint64_t start = now_ns();
+    for (int32_t i = 0; i < N_ITEMPS; i++) {
+      sum += decode(encoding, order[i]);
+    }
+    double ns = (double)(now_ns() - start) / N_ITEMPS;
+    s_sink = sum;
+    if (r == 0 || ns < best) {
+      best = ns;
+    }
+  }
+  return best;
+}
+
+static void emit(FILE *out, const table_t *table, const encoding_t *encoding,
+                 const char *function, const char *command) {
+  static const char *payload_names[N_MODES] = {"", "s_offsets", "s_nibbles",
+                                               "s_steps"};
+  int shift = encoding->shift;
+
+  fprintf(out,
+          "/* Generated by\n"
+          " *   %s\n"
+          " * Do not edit.\n"
+          " *\n"
+          " * %s() returns the same as\n"
+          " * %s() for every itemp, from %zu bytes of tables.\n"
+          " * Define ITEMP_ROM to place them, e.g. as \"const __flash\" on "
+          "AVR, and\n"
+          " * ITEMP_ROM_READ_8 and ITEMP_ROM_READ_16 if they need special "
+          "reads.\n"
+          " *\n"
+          " * To check every itemp against itemp.c on the host:\n"
+          " *   cc -Wall -c itemp.c\n"
+          " *   cc -Wall -DUNIT_TEST -o check this_file.c itemp.o && ./check\n"
+          " */\n\n"
+          "#include \"itemp.h\"\n"
+          "#include <stdint.h>\n\n"
+          "#ifndef ITEMP_ROM\n#define ITEMP_ROM const\n#endif\n"
+          "#ifndef ITEMP_ROM_READ_8\n#define ITEMP_ROM_READ_8(p) (*(p))\n"
+          "#endif\n"
+          "#ifndef ITEMP_ROM_READ_16\n#define ITEMP_ROM_READ_16(p) (*(p))\n"
+          "#endif\n\n"
+          "int16_t %s(itemp_t itemp);\n\n",
+          command, function, table->name, encoding_bytes(encoding), function);
+
+  emit_array(out, "int16_t",
+             encoding->mode == MODE_FULL ? "s_values" : "s_bases",
+             encoding->bases, encoding->n_bases, true);
+  if (encoding->mode != MODE_FULL) {
+    emit_array(out, "uint8_t", payload_names[encoding->mode],
+               encoding->payload, encoding->n_payload, false);
+  }
+  if (encoding->mode == MODE_STEPS) {
+    fprintf(out, "static uint8_t popcount_8(uint8_t x) {\n"
+                 "  x = x - ((x >> 1) & 0x55);\n"
+                 "  x = (x & 0x33) + ((x >> 2) & 0x33);\n"
+                 "  return (x + (x >> 4)) & 0x0f;\n"
+                 "}\n\n");
+  }
+
+  fprintf(out, "int16_t %s(itemp_t itemp) {\n", function);
+  if (encoding->mode == MODE_FULL) {
+    fprintf(out, "  return (int16_t)ITEMP_ROM_READ_16(&s_values[itemp]);\n");
+  } else {
+    fprintf(out,
+            "  int16_t value = (int16_t)ITEMP_ROM_READ_16(&s_bases[itemp >> "
+            "%d]);\n",
+            shift);
+  }
+  switch (encoding->mode) {
+  case MODE_DELTA8:
+    fprintf(out, "  return value + ITEMP_ROM_READ_8(&s_offsets[itemp]);\n");
+    break;
+  case MODE_DELTA4:
+    fprintf(out,
+            "  uint8_t nibbles = ITEMP_ROM_READ_8(&s_nibbles[itemp >> 1]);\n"
+            "  return value + ((nibbles >> ((itemp & 1) * 4)) & 15);\n");
+    break;
+  case MODE_STEPS:
+    fprintf(out,
+            "  // add the steps from the start of the block up to and "
+            "including itemp\n"
+            "  ITEMP_ROM uint8_t *p = &s_steps[(itemp >> %d) << %d];\n"
+            "  uint16_t n = itemp & %u;\n"
+            "  for (; n >= 8; n -= 8) {\n"
+            "    value += popcount_8(ITEMP_ROM_READ_8(p++));\n"
+            "  }\n"
+            "  return value + popcount_8(ITEMP_ROM_READ_8(p) & "
+            "(uint8_t)((2u << n) - 1));\n",
+            shift, shift - 3, (1u << shift) - 1);
+    break;
+  case MODE_FULL:
+  default:
+    break;
+  }
+  fprintf(out,
+          "}\n\n"
+          "#ifdef UNIT_TEST\n\n"
+          "#include \"itemp_unit_test.h\"\n\n"
+          "int main() {\n"
+          "  printf(\"Beginning unit tests...\");\n"
+          "  int mismatches = 0;\n"
+          "  for (int32_t i = 0; i <= 65535; i++) {\n"
+          "    int16_t expected = %s((itemp_t)i);\n"
+          "    mismatches += %s((itemp_t)i) != expected;\n"
+          "  }\n"
+          "  ASSERT_INT(mismatches, 0);\n"
+          "  printf(\"\\r\\n...unit tests complete.\\r\\n\");\n"
+          "  return 0;\n"
+          "}\n\n"
+          "#endif\n",
+          table->name, function);
+}
+
+static void emit_array(FILE *out, const char *type, const char *name,
+                       const void *data, size_t n, bool wide) {
+  size_t per_line = wide ? 9 : 12;
+
+  fprintf(out, "static ITEMP_ROM %s %s[%zu] = {", type, name, n);
+  for (size_t i = 0; i < n; i++) {
+    fprintf(out, "%s", (i % per_line == 0) ? "\n   " : "");
+    if (wide) {
+      fprintf(out, " %6d,", ((const int16_t *)data)[i]);
+    } else {
+      fprintf(out, " 0x%02x,", ((const uint8_t *)data)[i]);
+    }
+  }
+  fprintf(out, "\n};\n\n");
+}
+
+static uint8_t popcount_8(uint8_t x) {
+  x = x - ((x >> 1) & 0x55);
+  x = (x & 0x33) + ((x >> 2) & 0x33);
+  return (x + (x >> 4)) & 0x0f;
+}
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
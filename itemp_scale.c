@@ -0,0 +1,349 @@
+/** @file itemp_scale.c
+ * Conversion between itemp and linear temperature scales that are defined at
+ * run time.
+ *
+ * Each direction of a scale is a single 32 bit multiply-add followed by a
+ * division, and the division by the scale's constant denominator is done as a
+ * multiply and shift.  The constants are found once by itemp_scale_init(), so
+ * the batch loops vectorize much like the built in conversions.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp_scale.h"
+
+// =============================================================================
+// local types and definitions
+
+// itemp = 900 * (celsius + 26.40)
+#define ITEMP_PER_DEGREE_C ITEMP_ONE_DEGREE_C
+#define ITEMP_AT_0C (-ITEMP_MIN_CELSIUS_100 * ITEMP_ONE_HUNDRETH_DEGREE_C)
+
+#define ITEMP_MAX 65535
+
+// =============================================================================
+// local (forward) declarations
+
+/**
+ * @brief Find the constants for rquo(x * mul + add, d) over x in [min, max].
+ *
+ * @returns false if an intermediate value would not fit in 32 bits.
+ */
+static bool map_init(itemp_scale_map_t *map, int64_t min, int64_t max,
+                     int64_t mul, int64_t add, int64_t d);
+
+/**
+ * @brief Evaluate a map for one value.
+ */
+static inline int32_t map_apply(const itemp_scale_map_t *map, int32_t x);
+
+/**
+ * @brief Floor and ceiling of x / y for y > 0.
+ */
+static int64_t floor_div(int64_t x, int64_t y);
+static int64_t ceil_div(int64_t x, int64_t y);
+
+// =============================================================================
+// local storage
+
+// =============================================================================
+// public code
+
+bool itemp_scale_init(itemp_scale_t *scale, int32_t gain_num,
+                      int32_t offset_num, int32_t den) {
+  if (gain_num == 0 || den <= 0) {
+    return false;
+  }
+
+  // value = ((itemp - ITEMP_AT_0C) * gain_num + 900 * offset_num) / (900 * den)
+  int64_t mul = gain_num;
+  int64_t add = (int64_t)ITEMP_PER_DEGREE_C * offset_num -
+                (int64_t)ITEMP_AT_0C * gain_num;
+  if (!map_init(&scale->to_scale, 0, ITEMP_MAX, mul, add,
+                (int64_t)ITEMP_PER_DEGREE_C * den)) {
+    return false;
+  }
+
+  // itemp = (value * 900 * den - 900 * offset_num + ITEMP_AT_0C * gain_num)
+  //         / gain_num
+  int64_t d = gain_num;
+  mul = (int64_t)ITEMP_PER_DEGREE_C * den;
+  add = (int64_t)ITEMP_AT_0C * gain_num -
+        (int64_t)ITEMP_PER_DEGREE_C * offset_num;
+  if (d < 0) {
+    d = -d;
+    mul = -mul;
+    add = -add;
+  }
+  // The values that map to itemp 0 and ITEMP_MAX, widened by one so that
+  // anything beyond them is clamped to a value that still saturates.
+  int64_t v0 = (mul > 0) ? floor_div(-add, mul) : floor_div(add, -mul);
+  int64_t v1 = (mul > 0) ? ceil_div(ITEMP_MAX * d - add, mul)
+                         : ceil_div(add - ITEMP_MAX * d, -mul);
+  int64_t min = ((v0 < v1) ? v0 : v1) - 1;
+  int64_t max = ((v0 < v1) ? v1 : v0) + 1;
+  min = (min < INT32_MIN) ? INT32_MIN : min;
+  max = (max > INT32_MAX) ? INT32_MAX : max;
+  return map_init(&scale->to_itemp, min, max, mul, add, d);
+}
+
+int32_t itemp_to_scale(const itemp_scale_t *scale, itemp_t itemp) {
+  return map_apply(&scale->to_scale, itemp);
+}
+
+itemp_t scale_to_itemp(const itemp_scale_t *scale, int32_t value) {
+  int32_t itemp = map_apply(&scale->to_itemp, value);
+  return (itemp < 0) ? 0 : (itemp > ITEMP_MAX) ? ITEMP_MAX : (itemp_t)itemp;
+}
+
+void itemp_to_scale_batch(const itemp_scale_t *scale, const itemp_t *itemps,
+                          int32_t *values, size_t n) {
+  // a local copy lets the compiler keep the constants in registers
+  const itemp_scale_map_t map = scale->to_scale;
+  for (size_t i = 0; i < n; i++) {
+    values[i] = map_apply(&map, itemps[i]);
+  }
+}
+
+void scale_to_itemp_batch(const itemp_scale_t *scale, const int32_t *values,
+                          itemp_t *itemps, size_t n) {
+  const itemp_scale_map_t map = scale->to_itemp;
+  for (size_t i = 0; i < n; i++) {
+    int32_t itemp = map_apply(&map, values[i]);
+    itemps[i] = (itemp < 0) ? 0 : (itemp > ITEMP_MAX) ? ITEMP_MAX : itemp;
+  }
+}
+
+// =============================================================================
+// local (static) code
+
+static bool map_init(itemp_scale_map_t *map, int64_t min, int64_t max,
+                     int64_t mul, int64_t add, int64_t d) {
+  if (d <= 0 || d > INT32_MAX || mul < INT32_MIN || mul > INT32_MAX) {
+    return false;
+  }
+  if (d == 1) {
+    // the shift below needs d >= 2, and n * 2 / 2 rounds the same as n / 1
+    mul *= 2;
+    add *= 2;
+    d = 2;
+  }
+  int64_t ends[4] = {min * mul, max * mul, min * mul + add, max * mul + add};
+  int64_t lo = ends[2] < ends[3] ? ends[2] : ends[3];
+  int64_t hi = ends[2] < ends[3] ? ends[3] : ends[2];
+  for (int i = 0; i < 4; i++) {
+    if (ends[i] < INT32_MIN || ends[i] > INT32_MAX) {
+      return false;
+    }
+  }
+
+  // Rounding half away from zero is floor((n + d / 2) / d) for n >= 0 and
+  // floor((n + (d - 1) / 2) / d) for n < 0.  Adding k * d to both makes every
+  // numerator non-negative, so the floor is a plain unsigned multiply-shift.
+  int64_t k = (lo < 0) ? ceil_div(-lo, d) : 0;
+  int64_t bias_pos = d / 2 + k * d;
+  int64_t bias_neg = (d - 1) / 2 + k * d;
+  if (hi + bias_pos > INT32_MAX || bias_pos > INT32_MAX) {
+    return false;
+  }
+
+  // With l = ceil(log2(d)) and magic = ceil(2^(31 + l) / d), the multiply and
+  // shift give floor(n / d) exactly for every 0 <= n < 2^31.  magic lies in
+  // [2^31, 2^32), so the multiply is a single 32 x 32 -> 64 bit product.
+  int l = 0;
+  while (((int64_t)1 << l) < d) {
+    l++;
+  }
+  map->min = (int32_t)min;
+  map->max = (int32_t)max;
+  map->mul = (int32_t)mul;
+  map->add = (int32_t)add;
+  map->bias_pos = (int32_t)bias_pos;
+  map->bias_neg = (int32_t)bias_neg;
+  map->magic =
+      (uint32_t)((((uint64_t)1 << (31 + l)) + (uint64_t)d - 1) / (uint64_t)d);
+  map->shift = l - 1;
+  map->unbias = (int32_t)k;
+  return true;
+}
+
+static inline int32_t map_apply(const itemp_scale_map_t *map, int32_t x) {
+  x = (x < map->min) ? map->min : (x > map->max) ? map->max : x;
+  int32_t n = x * map->mul + map->add;
+  uint32_t u = (uint32_t)(n + ((n < 0) ? map->bias_neg : map->bias_pos));
+  uint32_t hi = (uint32_t)(((uint64_t)u * map->magic) >> 32);
+  return (int32_t)(hi >> map->shift) - map->unbias;
+}
+
+static int64_t floor_div(int64_t x, int64_t y) {
+  return (x >= 0) ? x / y : -((-x + y - 1) / y);
+}
+
+static int64_t ceil_div(int64_t x, int64_t y) {
+  return -floor_div(-x, y);
+}
+
+// =============================================================================
+// self test
+
+// To run tests on a unix-like system:
+//   cc -Wall -c itemp.c
+//   cc -Wall -DUNIT_TEST -o itemp_scale itemp_scale.c itemp.o && ./itemp_scale
+
+#ifdef UNIT_TEST
+
+#include "itemp_unit_test.h"
+
+#define N_ITEMPS 65536
+
+static itemp_t s_itemps[N_ITEMPS];
+static int32_t s_values[N_ITEMPS];
+static itemp_t s_out_itemps[N_ITEMPS];
+
+/**
+ * @brief rquo() from itemp.c, in 64 bits.
+ */
+static int64_t rquo_64(int64_t x, int64_t y) {
+  if ((x ^ y) >= 0) {
+    return (x + y / 2) / y;
+  } else {
+    return (x - y / 2) / y;
+  }
+}
+
+static int32_t reference_to_scale(int32_t gain_num, int32_t offset_num,
+                                  int32_t den, itemp_t itemp) {
+  return (int32_t)rquo_64((int64_t)(itemp - ITEMP_AT_0C) * gain_num +
+                              (int64_t)ITEMP_PER_DEGREE_C * offset_num,
+                          (int64_t)ITEMP_PER_DEGREE_C * den);
+}
+
+static itemp_t reference_to_itemp(int32_t gain_num, int32_t offset_num,
+                                  int32_t den, int32_t value) {
+  int64_t itemp = rquo_64(((int64_t)value * den - offset_num) *
+                                  ITEMP_PER_DEGREE_C +
+                              (int64_t)ITEMP_AT_0C * gain_num,
+                          gain_num);
+  return (itemp < 0) ? 0 : (itemp > ITEMP_MAX) ? ITEMP_MAX : (itemp_t)itemp;
+}
+
+/**
+ * @brief Compare a scale against the reference for every itemp, and for
+ * values around and beyond the whole itemp range.
+ */
+static int count_mismatches(int32_t gain_num, int32_t offset_num,
+                            int32_t den) {
+  itemp_scale_t scale;
+  int mismatches = 0;
+
+  if (!itemp_scale_init(&scale, gain_num, offset_num, den)) {
+    return -1;
+  }
+  itemp_to_scale_batch(&scale, s_itemps, s_values, N_ITEMPS);
+  for (int i = 0; i < N_ITEMPS; i++) {
+    int32_t expected = reference_to_scale(gain_num, offset_num, den, i);
+    mismatches += (s_values[i] != expected);
+    mismatches += (itemp_to_scale(&scale, i) != expected);
+  }
+
+  // every value from a little below the itemp range to a little above it
+  int32_t v0 = itemp_to_scale(&scale, 0);
+  int32_t v1 = itemp_to_scale(&scale, ITEMP_MAX);
+  int32_t lo = ((v0 < v1) ? v0 : v1) - 1000;
+  int32_t hi = ((v0 < v1) ? v1 : v0) + 1000;
+  for (int32_t v = lo; v <= hi; v += N_ITEMPS) {
+    size_t n = 0;
+    for (; n < N_ITEMPS && v + (int32_t)n <= hi; n++) {
+      s_values[n] = v + (int32_t)n;
+    }
+    scale_to_itemp_batch(&scale, s_values, s_out_itemps, n);
+    for (size_t i = 0; i < n; i++) {
+      itemp_t expected =
+          reference_to_itemp(gain_num, offset_num, den, s_values[i]);
+      mismatches += (s_out_itemps[i] != expected);
+      mismatches += (scale_to_itemp(&scale, s_values[i]) != expected);
+    }
+  }
+  for (int64_t v = INT32_MIN; v <= INT32_MAX; v += 12345677) {
+    mismatches += (scale_to_itemp(&scale, (int32_t)v) !=
+                   reference_to_itemp(gain_num, offset_num, den, (int32_t)v));
+  }
+  return mismatches;
+}
+
+int main() {
+  printf("Beginning unit tests...");
+
+  for (int i = 0; i < N_ITEMPS; i++) {
+    s_itemps[i] = (itemp_t)i;
+  }
+
+  ASSERT_INT(count_mismatches(100, 0, 1), 0);         // celsius_100
+  ASSERT_INT(count_mismatches(180, 3200, 1), 0);      // fahrenheit_100
+  ASSERT_INT(count_mismatches(8, 0, 1), 0);           // reaumur_10
+  ASSERT_INT(count_mismatches(4, 0, 5), 0);           // reaumur_1
+  ASSERT_INT(count_mismatches(100, 27315, 1), 0);     // kelvin_100
+  ASSERT_INT(count_mismatches(180, 49167, 1), 0);     // rankine_100
+  ASSERT_INT(count_mismatches(-3, 300, 2), 0);        // delisle_1
+  ASSERT_INT(count_mismatches(-30, 3000, 2), 0);      // delisle_10
+  ASSERT_INT(count_mismatches(4096, 100000, 100), 0); // a sensor's counts
+  ASSERT_INT(count_mismatches(1, 0, 1000), 0);        // coarser than itemp
+  ASSERT_INT(count_mismatches(1, 0, 2), 0);           // ties below zero
+  ASSERT_INT(count_mismatches(-1, 0, 2), 0);
+  ASSERT_INT(count_mismatches(16000, -7, 3), 0);
+
+  // the built in scales agree with the built in conversions
+  {
+    itemp_scale_t f_100, c_100;
+    int mismatches = 0;
+    itemp_scale_init(&f_100, 180, 3200, 1);
+    itemp_scale_init(&c_100, 100, 0, 1);
+    for (int i = 0; i < N_ITEMPS; i++) {
+      mismatches += (itemp_to_scale(&f_100, i) != itemp_to_fahrenheit_100(i));
+      mismatches += (itemp_to_scale(&c_100, i) != itemp_to_celsius_100(i));
+    }
+    for (int v = ITEMP_MIN_FAHRENHEIT_100; v <= ITEMP_MAX_FAHRENHEIT_100; v++) {
+      mismatches += (scale_to_itemp(&f_100, v) != fahrenheit_100_to_itemp(v));
+    }
+    for (int v = ITEMP_MIN_CELSIUS_100; v <= ITEMP_MAX_CELSIUS_100; v++) {
+      mismatches += (scale_to_itemp(&c_100, v) != celsius_100_to_itemp(v));
+    }
+    ASSERT_INT(mismatches, 0);
+  }
+
+  // degenerate or too steep
+  {
+    itemp_scale_t scale;
+    ASSERT_INT(itemp_scale_init(&scale, 0, 0, 1), false);
+    ASSERT_INT(itemp_scale_init(&scale, 1, 0, 0), false);
+    ASSERT_INT(itemp_scale_init(&scale, 1, 0, -1), false);
+    ASSERT_INT(itemp_scale_init(&scale, 1000000, 0, 1), false);
+  }
+
+  printf("\r\n...unit tests complete.\r\n");
+}
+
+#endif
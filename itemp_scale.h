@@ -0,0 +1,123 @@
+/** @file itemp_scale.h
+ * Conversion between itemp and linear temperature scales that are defined at
+ * run time, such as Reaumur or the raw counts of a particular sensor.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_SCALE_H_
+#define _ITEMP_SCALE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// types and definitions
+
+/**
+ * @brief One direction of a scale conversion, value = rquo(x * mul + add, d),
+ * with the division done as a multiply and shift.
+ *
+ * The fields are precomputed by itemp_scale_init() and are not meant to be
+ * set by hand.
+ */
+typedef struct {
+  int32_t min;       // x is clamped to [min, max]
+  int32_t max;
+  int32_t mul;
+  int32_t add;
+  int32_t bias_pos;  // rounding plus bias when x * mul + add >= 0
+  int32_t bias_neg;  // rounding plus bias when x * mul + add < 0
+  uint32_t magic;    // floor((x * mul + add + bias) / d) is
+  int32_t shift;     // ((x * mul + add + bias) * magic) >> (32 + shift)
+  int32_t unbias;    // subtracted from the quotient
+} itemp_scale_map_t;
+
+/**
+ * @brief A linear scale, value = celsius * gain_num / den + offset_num / den,
+ * ready for fast conversion in both directions.
+ *
+ * For example, tenths of a degree Reaumur are { 8, 0, 1 }, hundreths of a
+ * kelvin are { 100, 27315, 1 } and degrees Delisle are { -3, 300, 2 }.
+ */
+typedef struct {
+  itemp_scale_map_t to_scale;
+  itemp_scale_map_t to_itemp;
+} itemp_scale_t;
+
+// =============================================================================
+// declarations
+
+/**
+ * Prepare a scale for conversion.
+ *
+ * Results round to nearest, half away from zero, like the built in
+ * conversions.  Scale values are 32 bits; values that lie outside the itemp
+ * range saturate to 0 or 65535 when converted to itemp.
+ *
+ * @param scale The scale to initialize.
+ * @param gain_num Scale units per den degrees Celsius.  May be negative.
+ * @param offset_num den times the scale value at 0 degrees Celsius.
+ * @param den A positive denominator for gain_num and offset_num.
+ * @returns false if the scale is degenerate or too steep for 32 bit
+ * arithmetic, roughly |gain_num| > 16000 or den > 1000000.
+ */
+bool itemp_scale_init(itemp_scale_t *scale, int32_t gain_num,
+                      int32_t offset_num, int32_t den);
+
+/**
+ * Convert an itemp value to a scale value.
+ */
+int32_t itemp_to_scale(const itemp_scale_t *scale, itemp_t itemp);
+
+/**
+ * Convert a scale value to an itemp value, saturating at the itemp range.
+ */
+itemp_t scale_to_itemp(const itemp_scale_t *scale, int32_t value);
+
+/**
+ * Convert n itemp values to scale values.
+ */
+void itemp_to_scale_batch(const itemp_scale_t *scale, const itemp_t *itemps,
+                          int32_t *values, size_t n);
+
+/**
+ * Convert n scale values to itemp values, saturating at the itemp range.
+ */
+void scale_to_itemp_batch(const itemp_scale_t *scale, const int32_t *values,
+                          itemp_t *itemps, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _ITEMP_SCALE_H_ */
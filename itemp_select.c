@@ -0,0 +1,333 @@
+/** @file itemp_select.c
+ * Finding the extreme values in an array of itemp values.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp_select.h"
+#include <stdbool.h>
+
+// =============================================================================
+// local types and definitions
+
+// Values are examined in blocks of this many.  The minimum or maximum of a
+// block vectorizes, and only a block that beats the best so far is looked at
+// value by value.
+#define SELECT_BLOCK 256
+
+// =============================================================================
+// local (forward) declarations
+
+/**
+ * @brief Return the smallest and largest of n > 0 values.
+ */
+static itemp_t block_min(const itemp_t *itemps, size_t n);
+static itemp_t block_max(const itemp_t *itemps, size_t n);
+
+/**
+ * @brief Return the index of the first occurrence of value, which must be
+ * present.
+ */
+static size_t find_first(const itemp_t *itemps, size_t n, itemp_t value);
+
+/**
+ * @brief True if itemps[a] ranks below itemps[b]: colder, or as hot but seen
+ * later.
+ */
+static inline bool ranks_below(const itemp_t *itemps, size_t a, size_t b);
+
+/**
+ * @brief Restore the heap order of heap[0 .. size-1], whose root is the
+ * lowest ranked entry, after heap[i] has moved.
+ */
+static void sift_up(const itemp_t *itemps, size_t *heap, size_t i);
+static void sift_down(const itemp_t *itemps, size_t *heap, size_t size,
+                      size_t i);
+
+// =============================================================================
+// local storage
+
+// =============================================================================
+// public code
+
+size_t itemp_argmin(const itemp_t *itemps, size_t n) {
+  size_t best = 0;
+  itemp_t best_value = UINT16_MAX;
+
+  for (size_t start = 0; start < n; start += SELECT_BLOCK) {
+    size_t len = (n - start < SELECT_BLOCK) ? n - start : SELECT_BLOCK;
+    itemp_t value = block_min(&itemps[start], len);
+    if (start == 0 || value < best_value) {
+      best_value = value;
+      best = start + find_first(&itemps[start], len, value);
+    }
+  }
+  return best;
+}
+
+size_t itemp_argmax(const itemp_t *itemps, size_t n) {
+  size_t best = 0;
+  itemp_t best_value = 0;
+
+  for (size_t start = 0; start < n; start += SELECT_BLOCK) {
+    size_t len = (n - start < SELECT_BLOCK) ? n - start : SELECT_BLOCK;
+    itemp_t value = block_max(&itemps[start], len);
+    if (start == 0 || value > best_value) {
+      best_value = value;
+      best = start + find_first(&itemps[start], len, value);
+    }
+  }
+  return best;
+}
+
+size_t itemp_top_k(const itemp_t *itemps, size_t n, size_t k, size_t *indices,
+                   itemp_t *values) {
+  // indices is a heap of the best k so far, with the lowest ranked at the
+  // root, so the root is the threshold a new value has to beat.
+  size_t found = 0;
+
+  if (k == 0) {
+    return 0;
+  }
+  for (size_t start = 0; start < n; start += SELECT_BLOCK) {
+    size_t len = (n - start < SELECT_BLOCK) ? n - start : SELECT_BLOCK;
+    if (found == k &&
+        block_max(&itemps[start], len) <= itemps[indices[0]]) {
+      continue;  // nothing here beats the threshold
+    }
+    for (size_t i = start; i < start + len; i++) {
+      if (found < k) {
+        indices[found] = i;
+        sift_up(itemps, indices, found);
+        found += 1;
+      } else if (itemps[i] > itemps[indices[0]]) {
+        // later values only win outright, so ties keep the earlier index
+        indices[0] = i;
+        sift_down(itemps, indices, found, 0);
+      }
+    }
+  }
+
+  // Heap sort: move the lowest ranked to the end, one at a time, which leaves
+  // the hottest first.
+  for (size_t size = found; size > 1; size--) {
+    size_t lowest = indices[0];
+    indices[0] = indices[size - 1];
+    indices[size - 1] = lowest;
+    sift_down(itemps, indices, size - 1, 0);
+  }
+  if (values) {
+    for (size_t j = 0; j < found; j++) {
+      values[j] = itemps[indices[j]];
+    }
+  }
+  return found;
+}
+
+// =============================================================================
+// local (static) code
+
+static itemp_t block_min(const itemp_t *itemps, size_t n) {
+  itemp_t min = UINT16_MAX;
+  for (size_t i = 0; i < n; i++) {
+    min = (itemps[i] < min) ? itemps[i] : min;
+  }
+  return min;
+}
+
+static itemp_t block_max(const itemp_t *itemps, size_t n) {
+  itemp_t max = 0;
+  for (size_t i = 0; i < n; i++) {
+    max = (itemps[i] > max) ? itemps[i] : max;
+  }
+  return max;
+}
+
+static size_t find_first(const itemp_t *itemps, size_t n, itemp_t value) {
+  size_t i = 0;
+  while (i < n - 1 && itemps[i] != value) {
+    i++;
+  }
+  return i;
+}
+
+static inline bool ranks_below(const itemp_t *itemps, size_t a, size_t b) {
+  return itemps[a] < itemps[b] || (itemps[a] == itemps[b] && a > b);
+}
+
+static void sift_up(const itemp_t *itemps, size_t *heap, size_t i) {
+  while (i > 0) {
+    size_t parent = (i - 1) / 2;
+    if (!ranks_below(itemps, heap[i], heap[parent])) {
+      break;
+    }
+    size_t tmp = heap[i];
+    heap[i] = heap[parent];
+    heap[parent] = tmp;
+    i = parent;
+  }
+}
+
+static void sift_down(const itemp_t *itemps, size_t *heap, size_t size,
+                      size_t i) {
+  for (;;) {
+    size_t lowest = i;
+    size_t left = 2 * i + 1;
+    size_t right = left + 1;
+    if (left < size && ranks_below(itemps, heap[left], heap[lowest])) {
+      lowest = left;
+    }
+    if (right < size && ranks_below(itemps, heap[right], heap[lowest])) {
+      lowest = right;
+    }
+    if (lowest == i) {
+      break;
+    }
+    size_t tmp = heap[i];
+    heap[i] = heap[lowest];
+    heap[lowest] = tmp;
+    i = lowest;
+  }
+}
+
+// =============================================================================
+// self test
+
+// To run tests on a unix-like system:
+//   cc -Wall -c itemp.c
+//   cc -Wall -DUNIT_TEST -o itemp_select itemp_select.c itemp.o
+//   ./itemp_select
+
+#ifdef UNIT_TEST
+
+#include "itemp_unit_test.h"
+#include <stdlib.h>
+
+#define N_ITEMPS 100000
+
+static itemp_t s_itemps[N_ITEMPS];
+static size_t s_sorted[N_ITEMPS];
+static size_t s_indices[N_ITEMPS];
+static itemp_t s_values[N_ITEMPS];
+
+/**
+ * @brief qsort() order for the reference: hottest first, then by index.
+ */
+static int compare_rank(const void *a, const void *b) {
+  size_t ia = *(const size_t *)a;
+  size_t ib = *(const size_t *)b;
+  if (s_itemps[ia] != s_itemps[ib]) {
+    return (s_itemps[ia] > s_itemps[ib]) ? -1 : 1;
+  }
+  return (ia < ib) ? -1 : (ia > ib);
+}
+
+/**
+ * @brief Compare itemp_top_k() over the first n values with a full sort.
+ */
+static int count_top_k_mismatches(size_t n, size_t k) {
+  int mismatches = 0;
+  for (size_t i = 0; i < n; i++) {
+    s_sorted[i] = i;
+  }
+  qsort(s_sorted, n, sizeof(size_t), compare_rank);
+  size_t found = itemp_top_k(s_itemps, n, k, s_indices, s_values);
+  mismatches += (found != ((k < n) ? k : n));
+  for (size_t j = 0; j < found; j++) {
+    mismatches += (s_indices[j] != s_sorted[j]);
+    mismatches += (s_values[j] != s_itemps[s_sorted[j]]);
+  }
+  return mismatches;
+}
+
+static size_t reference_argmin(size_t n) {
+  size_t best = 0;
+  for (size_t i = 1; i < n; i++) {
+    best = (s_itemps[i] < s_itemps[best]) ? i : best;
+  }
+  return best;
+}
+
+static size_t reference_argmax(size_t n) {
+  size_t best = 0;
+  for (size_t i = 1; i < n; i++) {
+    best = (s_itemps[i] > s_itemps[best]) ? i : best;
+  }
+  return best;
+}
+
+int main() {
+  printf("Beginning unit tests...");
+
+  // empty and tiny inputs
+  ASSERT_INT(itemp_argmin(s_itemps, 0), 0);
+  ASSERT_INT(itemp_argmax(s_itemps, 0), 0);
+  ASSERT_INT(itemp_top_k(s_itemps, 0, 5, s_indices, NULL), 0);
+  ASSERT_INT(itemp_top_k(s_itemps, 10, 0, s_indices, NULL), 0);
+
+  // all equal: the first index wins
+  for (size_t i = 0; i < N_ITEMPS; i++) {
+    s_itemps[i] = 0;
+  }
+  ASSERT_INT(itemp_argmin(s_itemps, N_ITEMPS), 0);
+  ASSERT_INT(itemp_argmax(s_itemps, N_ITEMPS), 0);
+  ASSERT_INT(count_top_k_mismatches(N_ITEMPS, 100), 0);
+
+  // wide random values, and a narrow range with many ties
+  srand(1);
+  for (int pass = 0; pass < 2; pass++) {
+    for (size_t i = 0; i < N_ITEMPS; i++) {
+      s_itemps[i] = (pass == 0) ? (itemp_t)rand()
+                                : fahrenheit_1_to_itemp(60 + rand() % 20);
+    }
+    const size_t ns[] = {1, 2, 255, 256, 257, 1000, N_ITEMPS};
+    for (size_t j = 0; j < sizeof(ns) / sizeof(ns[0]); j++) {
+      ASSERT_INT(itemp_argmin(s_itemps, ns[j]), reference_argmin(ns[j]));
+      ASSERT_INT(itemp_argmax(s_itemps, ns[j]), reference_argmax(ns[j]));
+      ASSERT_INT(count_top_k_mismatches(ns[j], 1), 0);
+      ASSERT_INT(count_top_k_mismatches(ns[j], 100), 0);
+      ASSERT_INT(count_top_k_mismatches(ns[j], 300), 0);
+    }
+  }
+
+  // rising values defeat the block skip, and the heap turns over every time
+  for (size_t i = 0; i < N_ITEMPS; i++) {
+    s_itemps[i] = (itemp_t)(i / 2);
+  }
+  ASSERT_INT(itemp_argmax(s_itemps, N_ITEMPS), N_ITEMPS - 2);
+  ASSERT_INT(count_top_k_mismatches(N_ITEMPS, 1000), 0);
+  ASSERT_INT(count_top_k_mismatches(N_ITEMPS, N_ITEMPS), 0);
+
+  // values may be omitted
+  ASSERT_INT(itemp_top_k(s_itemps, N_ITEMPS, 3, s_indices, NULL), 3);
+  ASSERT_INT(s_indices[0], N_ITEMPS - 2);
+  ASSERT_INT(s_indices[1], N_ITEMPS - 1);
+  ASSERT_INT(s_indices[2], N_ITEMPS - 4);
+
+  printf("\r\n...unit tests complete.\r\n");
+}
+
+#endif
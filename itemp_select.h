@@ -0,0 +1,84 @@
+/** @file itemp_select.h
+ * Finding the extreme values in an array of itemp values: the position of the
+ * coldest or hottest reading, or the k hottest readings.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_SELECT_H_
+#define _ITEMP_SELECT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// types and definitions
+
+// =============================================================================
+// declarations
+
+/**
+ * Return the index of the smallest (coldest) value in itemps, or 0 if n is 0.
+ * Ties go to the lowest index.
+ */
+size_t itemp_argmin(const itemp_t *itemps, size_t n);
+
+/**
+ * Return the index of the largest (hottest) value in itemps, or 0 if n is 0.
+ * Ties go to the lowest index.
+ */
+size_t itemp_argmax(const itemp_t *itemps, size_t n);
+
+/**
+ * Find the k largest (hottest) values in itemps in a single pass.
+ *
+ * Blocks of values that cannot displace any of the k found so far are skipped
+ * after a vectorized maximum, so for k much smaller than n most of the work
+ * is a plain scan of memory.
+ *
+ * @param itemps The values to search, for example the latest reading of each
+ * sensor.
+ * @param n The number of values.
+ * @param k The number of values wanted.
+ * @param indices Receives the indices of the values found, hottest first.
+ * Ties are ordered by index.  Must have room for k entries.
+ * @param values Receives the values found, or may be NULL.  If not NULL it
+ * must have room for k entries.
+ * @returns The number of values found, the smaller of k and n.
+ */
+size_t itemp_top_k(const itemp_t *itemps, size_t n, size_t k, size_t *indices,
+                   itemp_t *values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _ITEMP_SELECT_H_ */
@@ -0,0 +1,588 @@
+/** @file itemp_stats.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp_stats.h"
+#include <string.h>
+
+// =============================================================================
+// local types and definitions
+
+// The largest block whose sum of itemp values is guaranteed to fit in a
+// uint32_t.  Summing in 32 bits lets the compiler keep more lanes per vector.
+#define STATS_BLOCK_SIZE 65536
+
+// The itemp values of 0F and 0C.
+#define ITEMP_AT_0F (-ITEMP_MIN_FAHRENHEIT_100 * ITEMP_ONE_HUNDRETH_DEGREE_F)
+#define ITEMP_AT_0C (-ITEMP_MIN_CELSIUS_100 * ITEMP_ONE_HUNDRETH_DEGREE_C)
+
+// =============================================================================
+// local (forward) declarations
+
+/**
+ * @brief Add x to the 128 bit sum held in stats.
+ */
+static void add_to_sum(itemp_stats_t *stats, uint64_t x_hi, uint64_t x_lo);
+
+/**
+ * @brief Split the mean into sum / count = quotient + remainder / count.
+ *
+ * Every value is below 65536, so the quotient is too.
+ */
+static uint32_t divide_sum(const itemp_stats_t *stats, uint64_t *remainder);
+
+/**
+ * @brief Return rquo(sum - zero * count, per_unit * count) for a non-empty
+ * stats: the exact mean in units of per_unit itemps, offset so that zero
+ * itemps maps to 0.
+ */
+static int16_t mean_in_units(const itemp_stats_t *stats, int32_t per_unit,
+                             int32_t zero);
+
+/**
+ * @brief Return the nearest rank of percentile among count values, from 1 to
+ * count.
+ */
+static uint64_t nearest_rank(uint64_t count, float percentile);
+
+// =============================================================================
+// local storage
+
+static itemp_histogram_fn_t s_histogram_backend;
+
+// =============================================================================
+// public code
+
+void itemp_stats_init(itemp_stats_t *stats) {
+  stats->count = 0;
+  stats->sum = 0;
+  stats->sum_hi = 0;
+  stats->min = UINT16_MAX;
+  stats->max = 0;
+}
+
+void itemp_stats_update(itemp_stats_t *stats, const itemp_t *itemps,
+                        size_t n) {
+  itemp_t min = stats->min;
+  itemp_t max = stats->max;
+
+  stats->count += n;
+  while (n > 0) {
+    size_t block = (n < STATS_BLOCK_SIZE) ? n : STATS_BLOCK_SIZE;
+    uint32_t sum = 0;
+    for (size_t i = 0; i < block; i++) {
+      itemp_t itemp = itemps[i];
+      sum += itemp;
+      min = (itemp < min) ? itemp : min;
+      max = (itemp > max) ? itemp : max;
+    }
+    add_to_sum(stats, 0, sum);
+    itemps += block;
+    n -= block;
+  }
+  stats->min = min;
+  stats->max = max;
+}
+
+void itemp_stats_merge(itemp_stats_t *stats, const itemp_stats_t *other) {
+  stats->count += other->count;
+  add_to_sum(stats, other->sum_hi, other->sum);
+  if (other->min < stats->min) {
+    stats->min = other->min;
+  }
+  if (other->max > stats->max) {
+    stats->max = other->max;
+  }
+}
+
+itemp_t itemp_stats_mean(const itemp_stats_t *stats) {
+  if (stats->count == 0) {
+    return 0;
+  }
+  // round half up, as rquo() does for positive values
+  uint64_t remainder;
+  uint32_t quotient = divide_sum(stats, &remainder);
+  return quotient + (remainder >= stats->count - remainder);
+}
+
+int16_t itemp_stats_mean_fahrenheit_1(const itemp_stats_t *stats) {
+  return mean_in_units(stats, ITEMP_ONE_DEGREE_F, ITEMP_AT_0F);
+}
+
+int16_t itemp_stats_mean_fahrenheit_10(const itemp_stats_t *stats) {
+  return mean_in_units(stats, ITEMP_ONE_TENTH_DEGREE_F, ITEMP_AT_0F);
+}
+
+int16_t itemp_stats_mean_fahrenheit_100(const itemp_stats_t *stats) {
+  return mean_in_units(stats, ITEMP_ONE_HUNDRETH_DEGREE_F, ITEMP_AT_0F);
+}
+
+int16_t itemp_stats_mean_celsius_1(const itemp_stats_t *stats) {
+  return mean_in_units(stats, ITEMP_ONE_DEGREE_C, ITEMP_AT_0C);
+}
+
+int16_t itemp_stats_mean_celsius_10(const itemp_stats_t *stats) {
+  return mean_in_units(stats, ITEMP_ONE_TENTH_DEGREE_C, ITEMP_AT_0C);
+}
+
+int16_t itemp_stats_mean_celsius_100(const itemp_stats_t *stats) {
+  return mean_in_units(stats, ITEMP_ONE_HUNDRETH_DEGREE_C, ITEMP_AT_0C);
+}
+
+void itemp_histogram_init(itemp_histogram_t *histogram) {
+  memset(histogram->bins, 0, sizeof(histogram->bins));
+}
+
+void itemp_histogram_update(itemp_histogram_t *histogram,
+                            const itemp_t *itemps, size_t n) {
+  if (s_histogram_backend != NULL) {
+    s_histogram_backend(histogram, itemps, n);
+    return;
+  }
+  for (size_t i = 0; i < n; i++) {
+    histogram->bins[itemps[i]] += 1;
+  }
+}
+
+void itemp_set_histogram_backend(itemp_histogram_fn_t fn) {
+  s_histogram_backend = fn;
+}
+
+void itemp_histogram_merge(itemp_histogram_t *histogram,
+                           const itemp_histogram_t *other) {
+  for (size_t i = 0; i < ITEMP_HISTOGRAM_BINS; i++) {
+    histogram->bins[i] += other->bins[i];
+  }
+}
+
+uint64_t itemp_histogram_count(const itemp_histogram_t *histogram) {
+  uint64_t count = 0;
+  for (size_t i = 0; i < ITEMP_HISTOGRAM_BINS; i++) {
+    count += histogram->bins[i];
+  }
+  return count;
+}
+
+itemp_t itemp_histogram_percentile(const itemp_histogram_t *histogram,
+                                   float percentile) {
+  uint64_t count = itemp_histogram_count(histogram);
+  uint64_t seen = 0;
+
+  if (count == 0) {
+    return 0;
+  }
+  uint64_t rank = nearest_rank(count, percentile);
+  for (size_t i = 0; i < ITEMP_HISTOGRAM_BINS; i++) {
+    seen += histogram->bins[i];
+    if (seen >= rank) {
+      return (itemp_t)i;
+    }
+  }
+  return UINT16_MAX;  // not reached
+}
+
+void itemp_cumulative_build(itemp_cumulative_t *cumulative,
+                            const itemp_t *itemps, size_t n) {
+  // count value v into below[v + 1], then sum the counts in place
+  memset(cumulative->below, 0, sizeof(cumulative->below));
+  for (size_t i = 0; i < n; i++) {
+    cumulative->below[itemps[i] + 1] += 1;
+  }
+  for (size_t i = 1; i <= ITEMP_HISTOGRAM_BINS; i++) {
+    cumulative->below[i] += cumulative->below[i - 1];
+  }
+}
+
+void itemp_cumulative_from_histogram(itemp_cumulative_t *cumulative,
+                                     const itemp_histogram_t *histogram) {
+  uint64_t sum = 0;
+  cumulative->below[0] = 0;
+  for (size_t i = 0; i < ITEMP_HISTOGRAM_BINS; i++) {
+    sum += histogram->bins[i];
+    cumulative->below[i + 1] = sum;
+  }
+}
+
+void itemp_cumulative_merge(itemp_cumulative_t *cumulative,
+                            const itemp_cumulative_t *other) {
+  for (size_t i = 0; i <= ITEMP_HISTOGRAM_BINS; i++) {
+    cumulative->below[i] += other->below[i];
+  }
+}
+
+uint64_t itemp_cumulative_count(const itemp_cumulative_t *cumulative) {
+  return cumulative->below[ITEMP_HISTOGRAM_BINS];
+}
+
+uint64_t itemp_cumulative_count_range(const itemp_cumulative_t *cumulative,
+                                      itemp_t lo, itemp_t hi) {
+  if (lo > hi) {
+    return 0;
+  }
+  return cumulative->below[hi + 1] - cumulative->below[lo];
+}
+
+itemp_t itemp_cumulative_percentile(const itemp_cumulative_t *cumulative,
+                                    float percentile) {
+  uint64_t count = itemp_cumulative_count(cumulative);
+
+  if (count == 0) {
+    return 0;
+  }
+  // the smallest v with below[v + 1] >= rank
+  uint64_t rank = nearest_rank(count, percentile);
+  size_t lo = 0;
+  size_t hi = ITEMP_HISTOGRAM_BINS - 1;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (cumulative->below[mid + 1] >= rank) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return (itemp_t)lo;
+}
+
+// =============================================================================
+// local (static) code
+
+static uint64_t nearest_rank(uint64_t count, float percentile) {
+  uint64_t rank;
+  if (percentile <= 0.0) {
+    rank = 1;
+  } else if (percentile >= 100.0) {
+    rank = count;
+  } else {
+    // nearest rank: ceil(percentile / 100 * count)
+    double exact = (double)percentile * (double)count / 100.0;
+    rank = (uint64_t)exact;
+    if ((double)rank < exact) {
+      rank += 1;
+    }
+    if (rank == 0) {
+      rank = 1;
+    }
+  }
+  return rank;
+}
+
+static void add_to_sum(itemp_stats_t *stats, uint64_t x_hi, uint64_t x_lo) {
+  uint64_t lo = stats->sum + x_lo;
+  stats->sum_hi += x_hi + (lo < x_lo);
+  stats->sum = lo;
+}
+
+static uint32_t divide_sum(const itemp_stats_t *stats, uint64_t *remainder) {
+  // Restoring division, one quotient bit at a time.  sum_hi < count, so the
+  // quotient fits in 64 bits (in fact in 16).  Plain C, so it works without
+  // 128 bit integer support.
+  uint64_t count = stats->count;
+  uint64_t r = stats->sum_hi;
+  uint64_t q = 0;
+  for (int i = 63; i >= 0; i--) {
+    uint64_t carry = r >> 63;
+    r = (r << 1) | ((stats->sum >> i) & 1);
+    q <<= 1;
+    if (carry || r >= count) {
+      r -= count;
+      q |= 1;
+    }
+  }
+  *remainder = r;
+  return (uint32_t)q;
+}
+
+static int16_t mean_in_units(const itemp_stats_t *stats, int32_t per_unit,
+                             int32_t zero) {
+  if (stats->count == 0) {
+    return 0;
+  }
+  // The mean in units is (a + r / count) / per_unit with a = q - zero.  With
+  // a = k * per_unit + m (0 <= m < per_unit) that is k + f, where
+  // f = (m + r / count) / per_unit is compared with 1/2 without overflow.
+  uint64_t r;
+  int32_t a = (int32_t)divide_sum(stats, &r) - zero;
+  int32_t k = (a >= 0) ? a / per_unit : -((-a + per_unit - 1) / per_unit);
+  int32_t m = a - k * per_unit;
+  int32_t e = per_unit - 2 * m;  // f > 1/2 when 2 * r / count > e
+  uint64_t rest = stats->count - r;
+  bool above = (e < 0) || (e == 0 && r > 0) || (e == 1 && r > rest);
+  bool half = (e == 0 && r == 0) || (e == 1 && r == rest);
+
+  // ties round away from zero
+  return (int16_t)(k + (above || (half && a >= 0)));
+}
+
+// =============================================================================
+// self test
+
+// To run tests on a unix-like system:
+//   cc -Wall -c itemp.c
+//   cc -Wall -DUNIT_TEST -o itemp_stats itemp_stats.c itemp.o && ./itemp_stats
+
+#ifdef UNIT_TEST
+
+#include "itemp_unit_test.h"
+#include <stdlib.h>
+
+static itemp_histogram_t s_histogram;
+static itemp_histogram_t s_other_histogram;
+static itemp_cumulative_t s_cumulative;
+static itemp_cumulative_t s_other_cumulative;
+
+/**
+ * @brief rquo(sum - zero * n, per_unit * n) in 64 bits.
+ */
+static int reference_mean(int64_t sum, int64_t n, int32_t per_unit,
+                          int32_t zero) {
+  int64_t x = sum - zero * n;
+  int64_t y = per_unit * n;
+  return (int)((x >= 0) ? (x + y / 2) / y : (x - y / 2) / y);
+}
+
+int main() {
+  printf("Beginning unit tests...");
+
+  itemp_stats_t stats;
+  itemp_stats_t other;
+  itemp_t itemps[] = {fahrenheit_1_to_itemp(70), fahrenheit_1_to_itemp(68),
+                      fahrenheit_1_to_itemp(72), fahrenheit_1_to_itemp(74)};
+
+  // ===========================================
+  // stats
+
+  itemp_stats_init(&stats);
+  ASSERT_INT(stats.count, 0);
+  ASSERT_INT(itemp_stats_mean(&stats), 0);
+
+  itemp_stats_update(&stats, itemps, 4);
+  ASSERT_INT(stats.count, 4);
+  ASSERT_INT(itemp_to_fahrenheit_100(stats.min), 6800);
+  ASSERT_INT(itemp_to_fahrenheit_100(stats.max), 7400);
+  ASSERT_INT(itemp_to_fahrenheit_100(itemp_stats_mean(&stats)), 7100);
+
+  // mean rounds to nearest
+  itemp_t odd[] = {1, 2};
+  itemp_stats_init(&stats);
+  itemp_stats_update(&stats, odd, 2);
+  ASSERT_INT(itemp_stats_mean(&stats), 2);
+
+  // merge matches a single pass over the concatenation
+  itemp_stats_init(&stats);
+  itemp_stats_init(&other);
+  itemp_stats_update(&stats, itemps, 1);
+  itemp_stats_update(&other, &itemps[1], 3);
+  itemp_stats_merge(&stats, &other);
+  ASSERT_INT(stats.count, 4);
+  ASSERT_INT(stats.min, itemps[1]);
+  ASSERT_INT(stats.max, itemps[3]);
+  ASSERT_INT(itemp_stats_mean(&stats), fahrenheit_1_to_itemp(71));
+
+  // sums spanning several blocks
+  size_t big_n = 200000;
+  itemp_t *big = malloc(big_n * sizeof(itemp_t));
+  for (size_t i = 0; i < big_n; i++) {
+    big[i] = UINT16_MAX;
+  }
+  itemp_stats_init(&stats);
+  itemp_stats_update(&stats, big, big_n);
+  ASSERT_INT(stats.sum == (uint64_t)big_n * UINT16_MAX, 1);
+  ASSERT_INT(itemp_stats_mean(&stats), UINT16_MAX);
+  free(big);
+
+  // sums beyond 64 bits
+  itemp_stats_init(&stats);
+  stats.count = (uint64_t)1 << 62;
+  stats.sum = (uint64_t)3 << 62;  // 65535 * 2^62 = 16383 * 2^64 + 3 * 2^62
+  stats.sum_hi = 16383;
+  stats.min = 0;
+  stats.max = UINT16_MAX;
+  ASSERT_INT(itemp_stats_mean(&stats), 65535);
+  other = stats;
+  itemp_stats_merge(&stats, &other);
+  ASSERT_INT(stats.sum_hi, 32767);
+  ASSERT_INT(stats.sum == (uint64_t)1 << 63, 1);
+  ASSERT_INT(itemp_stats_mean(&stats), 65535);
+  ASSERT_INT(itemp_stats_mean_fahrenheit_100(&stats),
+             itemp_to_fahrenheit_100(65535));
+  stats.sum = (uint64_t)1 << 62;  // a mean of 65534.5
+  ASSERT_INT(itemp_stats_mean(&stats), 65535);
+  ASSERT_INT(itemp_stats_mean_fahrenheit_100(&stats), 11555);  // 11554.9
+  ASSERT_INT(itemp_stats_mean_celsius_10(&stats), 464);        // 464.05
+  // carries out of the low word
+  itemp_stats_init(&stats);
+  stats.count = 3;
+  stats.sum = ~(uint64_t)0;
+  itemp_stats_init(&other);
+  other.count = 1;
+  other.sum = 2;
+  itemp_stats_merge(&stats, &other);
+  ASSERT_INT(stats.sum_hi, 1);
+  ASSERT_INT(stats.sum, 1);
+
+  // the mean in degrees is the exact mean rounded once, like rquo()
+  srand(1);
+  {
+    int mismatches = 0;
+    for (int trial = 0; trial < 20000; trial++) {
+      itemp_t values[7];
+      int n = 1 + trial % 7;
+      int64_t sum = 0;
+      for (int i = 0; i < n; i++) {
+        values[i] = (trial & 1) ? (itemp_t)rand()
+                                : (itemp_t)(ITEMP_AT_0F - 20 + rand() % 40);
+        sum += values[i];
+      }
+      itemp_stats_init(&stats);
+      itemp_stats_update(&stats, values, n);
+      mismatches += (itemp_stats_mean_fahrenheit_1(&stats) !=
+                     reference_mean(sum, n, ITEMP_ONE_DEGREE_F, ITEMP_AT_0F));
+      mismatches +=
+          (itemp_stats_mean_fahrenheit_10(&stats) !=
+           reference_mean(sum, n, ITEMP_ONE_TENTH_DEGREE_F, ITEMP_AT_0F));
+      mismatches +=
+          (itemp_stats_mean_fahrenheit_100(&stats) !=
+           reference_mean(sum, n, ITEMP_ONE_HUNDRETH_DEGREE_F, ITEMP_AT_0F));
+      mismatches += (itemp_stats_mean_celsius_1(&stats) !=
+                     reference_mean(sum, n, ITEMP_ONE_DEGREE_C, ITEMP_AT_0C));
+      mismatches +=
+          (itemp_stats_mean_celsius_10(&stats) !=
+           reference_mean(sum, n, ITEMP_ONE_TENTH_DEGREE_C, ITEMP_AT_0C));
+      mismatches +=
+          (itemp_stats_mean_celsius_100(&stats) !=
+           reference_mean(sum, n, ITEMP_ONE_HUNDRETH_DEGREE_C, ITEMP_AT_0C));
+      mismatches += (itemp_stats_mean(&stats) != (sum + n / 2) / n);
+    }
+    ASSERT_INT(mismatches, 0);
+  }
+
+  // a single value gives the same result as the scalar conversion
+  {
+    int mismatches = 0;
+    for (int i = 0; i < 65536; i++) {
+      itemp_t itemp = (itemp_t)i;
+      itemp_stats_init(&stats);
+      itemp_stats_update(&stats, &itemp, 1);
+      mismatches += (itemp_stats_mean_fahrenheit_100(&stats) !=
+                     itemp_to_fahrenheit_100(itemp));
+      mismatches += (itemp_stats_mean_celsius_100(&stats) !=
+                     itemp_to_celsius_100(itemp));
+    }
+    ASSERT_INT(mismatches, 0);
+  }
+
+  // ===========================================
+  // histogram
+
+  itemp_histogram_init(&s_histogram);
+  ASSERT_INT(itemp_histogram_percentile(&s_histogram, 50.0), 0);
+
+  for (itemp_t i = 1; i <= 100; i++) {
+    itemp_histogram_update(&s_histogram, &i, 1);
+  }
+  ASSERT_INT(itemp_histogram_count(&s_histogram), 100);
+  ASSERT_INT(itemp_histogram_percentile(&s_histogram, 0.0), 1);
+  ASSERT_INT(itemp_histogram_percentile(&s_histogram, 1.0), 1);
+  ASSERT_INT(itemp_histogram_percentile(&s_histogram, 1.5), 2);
+  ASSERT_INT(itemp_histogram_percentile(&s_histogram, 50.0), 50);
+  ASSERT_INT(itemp_histogram_percentile(&s_histogram, 99.0), 99);
+  ASSERT_INT(itemp_histogram_percentile(&s_histogram, 100.0), 100);
+
+  itemp_histogram_init(&s_other_histogram);
+  itemp_histogram_update(&s_other_histogram, itemps, 4);
+  itemp_histogram_merge(&s_histogram, &s_other_histogram);
+  ASSERT_INT(itemp_histogram_count(&s_histogram), 104);
+  ASSERT_INT(itemp_histogram_percentile(&s_histogram, 100.0), itemps[3]);
+
+  // ===========================================
+  // cumulative histogram
+
+  itemp_cumulative_build(&s_cumulative, itemps, 0);
+  ASSERT_INT(itemp_cumulative_count(&s_cumulative), 0);
+  ASSERT_INT(itemp_cumulative_count_range(&s_cumulative, 0, 65535), 0);
+  ASSERT_INT(itemp_cumulative_percentile(&s_cumulative, 50.0), 0);
+
+  // agrees with the histogram it came from
+  itemp_cumulative_from_histogram(&s_cumulative, &s_histogram);
+  ASSERT_INT(itemp_cumulative_count(&s_cumulative), 104);
+  ASSERT_INT(itemp_cumulative_count_range(&s_cumulative, 1, 100), 100);
+  ASSERT_INT(itemp_cumulative_count_range(&s_cumulative, 10, 19), 10);
+  ASSERT_INT(itemp_cumulative_count_range(&s_cumulative, 19, 10), 0);
+  ASSERT_INT(itemp_cumulative_count_range(&s_cumulative, 0, 0), 0);
+  ASSERT_INT(itemp_cumulative_count_range(&s_cumulative, 65535, 65535), 0);
+  ASSERT_INT(itemp_cumulative_count_range(&s_cumulative, itemps[1], itemps[3]),
+             4);
+  ASSERT_INT(itemp_cumulative_count_range(&s_cumulative, itemps[0], itemps[2]),
+             2);
+  {
+    const float percentiles[] = {0.0, 0.5, 1.0, 1.5, 50.0, 96.0, 99.0, 100.0};
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+      ASSERT_INT(itemp_cumulative_percentile(&s_cumulative, percentiles[i]),
+                 itemp_histogram_percentile(&s_histogram, percentiles[i]));
+    }
+  }
+
+  // range counts over random data, built in two partitions and merged
+  {
+    size_t n = 100000;
+    itemp_t *data = malloc(n * sizeof(itemp_t));
+    int mismatches = 0;
+    srand(2);
+    for (size_t i = 0; i < n; i++) {
+      data[i] = (i & 1) ? (itemp_t)rand() : fahrenheit_1_to_itemp(rand() % 100);
+    }
+    itemp_cumulative_build(&s_cumulative, data, n / 3);
+    itemp_cumulative_build(&s_other_cumulative, &data[n / 3], n - n / 3);
+    itemp_cumulative_merge(&s_cumulative, &s_other_cumulative);
+    ASSERT_INT(itemp_cumulative_count(&s_cumulative), n);
+    for (int q = 0; q < 200; q++) {
+      itemp_t lo = fahrenheit_1_to_itemp(rand() % 100);
+      itemp_t hi = (q < 100) ? fahrenheit_1_to_itemp(rand() % 100)
+                             : (itemp_t)rand();
+      uint64_t expected = 0;
+      for (size_t i = 0; i < n; i++) {
+        expected += (data[i] >= lo && data[i] <= hi);
+      }
+      mismatches +=
+          (itemp_cumulative_count_range(&s_cumulative, lo, hi) != expected);
+    }
+    ASSERT_INT(mismatches, 0);
+    itemp_histogram_init(&s_histogram);
+    itemp_histogram_update(&s_histogram, data, n);
+    for (int p = 0; p <= 100; p++) {
+      mismatches += (itemp_cumulative_percentile(&s_cumulative, p) !=
+                     itemp_histogram_percentile(&s_histogram, p));
+    }
+    ASSERT_INT(mismatches, 0);
+    free(data);
+  }
+
+  printf("\r\n...unit tests complete.\r\n");
+}
+
+#endif
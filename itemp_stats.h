@@ -0,0 +1,214 @@
+/** @file itemp_stats.h
+ * Summary statistics over arrays of itemp values: count, min, max, mean and
+ * a full resolution histogram for percentiles.  All state is mergeable, so
+ * partial results computed over separate chunks (or threads) can be combined.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_STATS_H_
+#define _ITEMP_STATS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// types and definitions
+
+/**
+ * @brief Running count, sum, min and max of a set of itemp values.
+ *
+ * The sum is kept in 128 bits, so it cannot overflow for any count.
+ */
+typedef struct {
+  uint64_t count;
+  uint64_t sum;     // low 64 bits of the sum
+  uint64_t sum_hi;  // high 64 bits of the sum
+  itemp_t min;
+  itemp_t max;
+} itemp_stats_t;
+
+/**
+ * @brief One bin per possible itemp value.
+ */
+#define ITEMP_HISTOGRAM_BINS 65536
+
+/**
+ * @brief Histogram of itemp values at full resolution.
+ *
+ * This is 512K bytes: allocate it statically or on the heap, not on the stack.
+ */
+typedef struct {
+  uint64_t bins[ITEMP_HISTOGRAM_BINS];
+} itemp_histogram_t;
+
+/**
+ * @brief A replacement for the loop in itemp_histogram_update(), for
+ * itemp_set_histogram_backend().
+ */
+typedef void (*itemp_histogram_fn_t)(itemp_histogram_t *histogram,
+                                     const itemp_t *itemps, size_t n);
+
+/**
+ * @brief Cumulative histogram: below[i] is the number of values less than i,
+ * so the count in any range is one subtraction.
+ *
+ * This is 512K bytes, like itemp_histogram_t.
+ */
+typedef struct {
+  uint64_t below[ITEMP_HISTOGRAM_BINS + 1];
+} itemp_cumulative_t;
+
+// =============================================================================
+// declarations
+
+/**
+ * Reset stats to the empty set.
+ */
+void itemp_stats_init(itemp_stats_t *stats);
+
+/**
+ * Add n itemp values to stats.
+ */
+void itemp_stats_update(itemp_stats_t *stats, const itemp_t *itemps, size_t n);
+
+/**
+ * Combine the values summarized by other into stats.
+ */
+void itemp_stats_merge(itemp_stats_t *stats, const itemp_stats_t *other);
+
+/**
+ * Return the mean of the values in stats, rounded to the nearest itemp, or 0
+ * if stats is empty.
+ */
+itemp_t itemp_stats_mean(const itemp_stats_t *stats);
+
+/**
+ * Return the mean of the values in stats in degrees Fahrenheit, or 0 if stats
+ * is empty.
+ *
+ * The exact mean is rounded once, half away from zero like rquo(), rather
+ * than rounded to an itemp and then converted, so it can differ by one from
+ * itemp_to_fahrenheit_1(itemp_stats_mean(stats)).
+ */
+int16_t itemp_stats_mean_fahrenheit_1(const itemp_stats_t *stats);
+int16_t itemp_stats_mean_fahrenheit_10(const itemp_stats_t *stats);
+int16_t itemp_stats_mean_fahrenheit_100(const itemp_stats_t *stats);
+
+int16_t itemp_stats_mean_celsius_1(const itemp_stats_t *stats);
+int16_t itemp_stats_mean_celsius_10(const itemp_stats_t *stats);
+int16_t itemp_stats_mean_celsius_100(const itemp_stats_t *stats);
+
+/**
+ * Reset all bins of histogram to zero.
+ */
+void itemp_histogram_init(itemp_histogram_t *histogram);
+
+/**
+ * Add n itemp values to histogram.
+ */
+void itemp_histogram_update(itemp_histogram_t *histogram,
+                            const itemp_t *itemps, size_t n);
+
+/**
+ * Make itemp_histogram_update() call fn, which must give the same bins, or
+ * restore its own loop if fn is NULL.  itemp_tune.h uses this to install the
+ * fastest loop for the host.  Not thread safe: call it before other threads
+ * update histograms.
+ */
+void itemp_set_histogram_backend(itemp_histogram_fn_t fn);
+
+/**
+ * Add the bins of other into histogram.
+ */
+void itemp_histogram_merge(itemp_histogram_t *histogram,
+                           const itemp_histogram_t *other);
+
+/**
+ * Return the number of values held in histogram.
+ */
+uint64_t itemp_histogram_count(const itemp_histogram_t *histogram);
+
+/**
+ * Return the given percentile of the values in histogram using the nearest
+ * rank method, or 0 if histogram is empty.
+ *
+ * @param histogram A histogram of itemp values.
+ * @param percentile A value between 0.0 and 100.0 inclusive.
+ * @returns The smallest itemp value at or below which at least percentile
+ * percent of the values fall.
+ */
+itemp_t itemp_histogram_percentile(const itemp_histogram_t *histogram,
+                                   float percentile);
+
+/**
+ * Build a cumulative histogram of n itemp values in one pass over the data.
+ */
+void itemp_cumulative_build(itemp_cumulative_t *cumulative,
+                            const itemp_t *itemps, size_t n);
+
+/**
+ * Build a cumulative histogram from an ordinary one.
+ */
+void itemp_cumulative_from_histogram(itemp_cumulative_t *cumulative,
+                                     const itemp_histogram_t *histogram);
+
+/**
+ * Add the counts of other, for example another time partition, into
+ * cumulative.  Prefix sums add elementwise, so no rebuild is needed.
+ */
+void itemp_cumulative_merge(itemp_cumulative_t *cumulative,
+                            const itemp_cumulative_t *other);
+
+/**
+ * Return the number of values held in cumulative.
+ */
+uint64_t itemp_cumulative_count(const itemp_cumulative_t *cumulative);
+
+/**
+ * Return the number of values v with lo <= v <= hi, in constant time, or 0 if
+ * lo > hi.
+ */
+uint64_t itemp_cumulative_count_range(const itemp_cumulative_t *cumulative,
+                                      itemp_t lo, itemp_t hi);
+
+/**
+ * Return the given percentile using the nearest rank method, like
+ * itemp_histogram_percentile(), but by binary search.
+ */
+itemp_t itemp_cumulative_percentile(const itemp_cumulative_t *cumulative,
+                                    float percentile);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _ITEMP_STATS_H_ */
@@ -0,0 +1,611 @@
+/** @file itemp_stats_cli.c
+ * itemp-stats: print summary statistics of temperatures read from binary itemp
+ * columns or from text.
+ *
+ * To build on a unix-like system:
+ *   cc -O2 -Wall -o itemp-stats itemp_stats_cli.c itemp_stats.c itemp_text.c \
+ *      itemp.c -lpthread
+ *
+ * To run its unit tests:
+ *   cc -Wall -c itemp_stats.c itemp_text.c itemp.c
+ *   cc -Wall -fsanitize=address -DUNIT_TEST -o itemp-stats-test \
+ *      itemp_stats_cli.c itemp_stats.o itemp_text.o itemp.o -lpthread && \
+ *      ./itemp-stats-test
+ *
+ * Binary inputs are raw arrays of native-endian itemp_t and are mapped into
+ * memory.  Text inputs hold one reading per line, optionally as a column of a
+ * comma separated file.  Either way the input is split into chunks that are
+ * summarized in parallel and then merged.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include "itemp_stats.h"
+#include "itemp_text.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// =============================================================================
+// local types and definitions
+
+#define MAX_THREADS 64
+#define MAX_PERCENTILES 32
+#define PARSE_BATCH 4096
+
+typedef struct {
+  bool binary;          // input is raw itemp_t rather than text
+  char input_unit;      // 'F' or 'C' for text input
+  char output_unit;     // 'F' or 'C'
+  int column;           // 1-based column of text input
+  int n_threads;
+  int n_buckets;        // histogram buckets to print, 0 for none
+  int n_percentiles;
+  float percentiles[MAX_PERCENTILES];
+} options_t;
+
+typedef struct {
+  const options_t *options;
+  const char *start;    // chunk of the input assigned to this worker
+  const char *end;
+  uint64_t rejected;    // text lines that did not hold a valid temperature
+  itemp_stats_t stats;
+  itemp_histogram_t *histogram;
+} worker_t;
+
+// =============================================================================
+// local (forward) declarations
+
+#ifndef UNIT_TEST
+static void usage(const char *program);
+#endif
+static bool parse_options(int argc, char *argv[], options_t *options,
+                          int *first_file);
+static bool parse_percentiles(const char *s, options_t *options);
+static bool process_input(const char *name, const char *data, size_t size,
+                          worker_t *workers, int n_workers);
+static bool map_file(const char *name, const char **data, size_t *size);
+static char *read_stream(FILE *stream, size_t *size);
+static void *binary_worker(void *arg);
+static void *text_worker(void *arg);
+static bool parse_line(const options_t *options, const char *s,
+                       const char *end, itemp_t *itemp);
+#ifndef UNIT_TEST
+static int16_t to_output_100(const options_t *options, itemp_t itemp);
+static const char *format_100(char *buf, int16_t value_100);
+static void print_results(const options_t *options, worker_t *workers,
+                          int n_workers);
+#endif
+
+// =============================================================================
+// local storage
+
+static worker_t s_workers[MAX_THREADS];
+
+// =============================================================================
+// public code
+
+#ifndef UNIT_TEST
+
+int main(int argc, char *argv[]) {
+  options_t options;
+  int first_file;
+  bool ok = true;
+
+  if (!parse_options(argc, argv, &options, &first_file)) {
+    usage(argv[0]);
+    return 2;
+  }
+  for (int i = 0; i < options.n_threads; i++) {
+    s_workers[i].options = &options;
+    s_workers[i].rejected = 0;
+    itemp_stats_init(&s_workers[i].stats);
+    s_workers[i].histogram = malloc(sizeof(itemp_histogram_t));
+    if (s_workers[i].histogram == NULL) {
+      fprintf(stderr, "out of memory\n");
+      return 1;
+    }
+    itemp_histogram_init(s_workers[i].histogram);
+  }
+
+  if (first_file == argc) {
+    size_t size;
+    char *data = read_stream(stdin, &size);
+    if (data == NULL) {
+      fprintf(stderr, "error reading stdin: %s\n", strerror(errno));
+      return 1;
+    }
+    ok = process_input("stdin", data, size, s_workers, options.n_threads);
+    free(data);
+  } else {
+    for (int i = first_file; i < argc; i++) {
+      const char *data;
+      size_t size;
+      if (!map_file(argv[i], &data, &size)) {
+        ok = false;
+        continue;
+      }
+      ok &= process_input(argv[i], data, size, s_workers, options.n_threads);
+      if (size > 0) {
+        munmap((void *)data, size);
+      }
+    }
+  }
+
+  print_results(&options, s_workers, options.n_threads);
+  for (int i = 0; i < options.n_threads; i++) {
+    free(s_workers[i].histogram);
+  }
+  return ok ? 0 : 1;
+}
+
+#endif
+
+// =============================================================================
+// local (static) code
+
+#ifndef UNIT_TEST
+static void usage(const char *program) {
+  fprintf(stderr,
+          "usage: %s [options] [file ...]\n"
+          "  -b        inputs are binary arrays of itemp_t\n"
+          "  -i F|C    unit of text inputs (default F)\n"
+          "  -c N      read text from column N of comma separated lines\n"
+          "  -o F|C    unit of printed results (default F)\n"
+          "  -p LIST   comma separated percentiles (default 50,90,99)\n"
+          "  -n N      print a histogram of N buckets between min and max\n"
+          "  -j N      number of threads (default %d)\n"
+          "Reads stdin if no files are given.\n",
+          program, (int)sysconf(_SC_NPROCESSORS_ONLN));
+}
+#endif
+
+static bool parse_options(int argc, char *argv[], options_t *options,
+                          int *first_file) {
+  long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int opt;
+
+  options->binary = false;
+  options->input_unit = 'F';
+  options->output_unit = 'F';
+  options->column = 1;
+  options->n_threads = (n_cpus < 1) ? 1 : (n_cpus > MAX_THREADS) ? MAX_THREADS
+                                                                  : n_cpus;
+  options->n_buckets = 0;
+  parse_percentiles("50,90,99", options);
+
+  while ((opt = getopt(argc, argv, "bi:c:o:p:n:j:")) != -1) {
+    switch (opt) {
+    case 'b':
+      options->binary = true;
+      break;
+    case 'i':
+    case 'o': {
+      char unit = optarg[0];
+      if (unit == 'f') unit = 'F';
+      if (unit == 'c') unit = 'C';
+      if ((unit != 'F' && unit != 'C') || optarg[1] != '\0') {
+        return false;
+      }
+      *(opt == 'i' ? &options->input_unit : &options->output_unit) = unit;
+    } break;
+    case 'c':
+      options->column = atoi(optarg);
+      if (options->column < 1) {
+        return false;
+      }
+      break;
+    case 'p':
+      if (!parse_percentiles(optarg, options)) {
+        return false;
+      }
+      break;
+    case 'n':
+      options->n_buckets = atoi(optarg);
+      if (options->n_buckets < 0) {
+        return false;
+      }
+      break;
+    case 'j':
+      options->n_threads = atoi(optarg);
+      if (options->n_threads < 1 || options->n_threads > MAX_THREADS) {
+        return false;
+      }
+      break;
+    default:
+      return false;
+    }
+  }
+  *first_file = optind;
+  return true;
+}
+
+static bool parse_percentiles(const char *s, options_t *options) {
+  const char *end = s + strlen(s);
+
+  options->n_percentiles = 0;
+  while (s < end) {
+    int32_t value_100;
+    s = itemp_parse_decimal_100(s, end, &value_100);
+    if (s == NULL || value_100 < 0 || value_100 > 10000 ||
+        options->n_percentiles == MAX_PERCENTILES) {
+      return false;
+    }
+    options->percentiles[options->n_percentiles++] = value_100 / 100.0;
+    if (s < end && *s++ != ',') {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool process_input(const char *name, const char *data, size_t size,
+                          worker_t *workers, int n_workers) {
+  const options_t *options = workers[0].options;
+  pthread_t threads[MAX_THREADS];
+  const char *end = data + size;
+  const char *start = data;
+
+  if (options->binary && (size % sizeof(itemp_t)) != 0) {
+    fprintf(stderr, "%s: size is not a multiple of %zu bytes\n", name,
+            sizeof(itemp_t));
+    return false;
+  }
+
+  // Divide the input into one chunk per worker.  Binary chunks are aligned to
+  // whole itemps, text chunks end just after a newline.
+  for (int i = 0; i < n_workers; i++) {
+    const char *stop = data + (size / n_workers) * (i + 1);
+    if (i == n_workers - 1) {
+      stop = end;
+    } else if (options->binary) {
+      stop -= (stop - data) % sizeof(itemp_t);
+    } else {
+      // with fewer bytes than workers the chunk may be empty, and stop[-1]
+      // is then before the input
+      while (stop > start && stop < end && stop[-1] != '\n') {
+        stop++;
+      }
+    }
+    if (stop < start) {
+      stop = start;
+    }
+    workers[i].start = start;
+    workers[i].end = stop;
+    start = stop;
+  }
+
+  for (int i = 0; i < n_workers; i++) {
+    void *(*fn)(void *) = options->binary ? binary_worker : text_worker;
+    if (pthread_create(&threads[i], NULL, fn, &workers[i]) != 0) {
+      // fall back to running the chunk on this thread
+      threads[i] = pthread_self();
+      fn(&workers[i]);
+    }
+  }
+  for (int i = 0; i < n_workers; i++) {
+    if (!pthread_equal(threads[i], pthread_self())) {
+      pthread_join(threads[i], NULL);
+    }
+  }
+  return true;
+}
+
+static bool map_file(const char *name, const char **data, size_t *size) {
+  struct stat st;
+  int fd = open(name, O_RDONLY);
+
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    fprintf(stderr, "%s: %s\n", name, strerror(errno));
+    if (fd >= 0) close(fd);
+    return false;
+  }
+  *size = st.st_size;
+  *data = "";
+  if (*size > 0) {
+    void *p = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      fprintf(stderr, "%s: %s\n", name, strerror(errno));
+      close(fd);
+      return false;
+    }
+    madvise(p, *size, MADV_SEQUENTIAL);
+    *data = p;
+  }
+  close(fd);
+  return true;
+}
+
+static char *read_stream(FILE *stream, size_t *size) {
+  size_t capacity = 1 << 16;
+  char *data = malloc(capacity);
+
+  *size = 0;
+  while (data != NULL) {
+    size_t n = fread(data + *size, 1, capacity - *size, stream);
+    *size += n;
+    if (n == 0) {
+      return ferror(stream) ? (free(data), NULL) : data;
+    }
+    if (*size == capacity) {
+      char *grown = realloc(data, capacity * 2);
+      if (grown == NULL) {
+        free(data);
+        return NULL;
+      }
+      data = grown;
+      capacity *= 2;
+    }
+  }
+  return NULL;
+}
+
+static void *binary_worker(void *arg) {
+  worker_t *worker = arg;
+  const itemp_t *itemps = (const itemp_t *)worker->start;
+  size_t n = (worker->end - worker->start) / sizeof(itemp_t);
+
+  itemp_stats_update(&worker->stats, itemps, n);
+  itemp_histogram_update(worker->histogram, itemps, n);
+  return NULL;
+}
+
+static void *text_worker(void *arg) {
+  worker_t *worker = arg;
+  itemp_t batch[PARSE_BATCH];
+  size_t n = 0;
+  const char *s = worker->start;
+
+  while (s < worker->end) {
+    const char *eol = memchr(s, '\n', worker->end - s);
+    if (eol == NULL) {
+      eol = worker->end;
+    }
+    if (eol > s) {
+      if (parse_line(worker->options, s, eol, &batch[n])) {
+        n += 1;
+      } else {
+        worker->rejected += 1;
+      }
+    }
+    if (n == PARSE_BATCH) {
+      itemp_stats_update(&worker->stats, batch, n);
+      itemp_histogram_update(worker->histogram, batch, n);
+      n = 0;
+    }
+    s = eol + 1;
+  }
+  itemp_stats_update(&worker->stats, batch, n);
+  itemp_histogram_update(worker->histogram, batch, n);
+  return NULL;
+}
+
+static bool parse_line(const options_t *options, const char *s,
+                       const char *end, itemp_t *itemp) {
+  int32_t value_100;
+
+  for (int column = 1; column < options->column; column++) {
+    s = memchr(s, ',', end - s);
+    if (s == NULL) {
+      return false;
+    }
+    s += 1;
+  }
+  if (itemp_parse_decimal_100(s, end, &value_100) == NULL) {
+    return false;
+  }
+  if (options->input_unit == 'F') {
+    return itemp_from_fahrenheit_100_checked(value_100, itemp);
+  } else {
+    return itemp_from_celsius_100_checked(value_100, itemp);
+  }
+}
+
+#ifndef UNIT_TEST
+static int16_t to_output_100(const options_t *options, itemp_t itemp) {
+  if (options->output_unit == 'F') {
+    return itemp_to_fahrenheit_100(itemp);
+  } else {
+    return itemp_to_celsius_100(itemp);
+  }
+}
+
+static const char *format_100(char *buf, int16_t value_100) {
+  buf[itemp_format_decimal(buf, value_100, 2)] = '\0';
+  return buf;
+}
+
+static void print_results(const options_t *options, worker_t *workers,
+                          int n_workers) {
+  itemp_stats_t *stats = &workers[0].stats;
+  itemp_histogram_t *histogram = workers[0].histogram;
+  uint64_t rejected = workers[0].rejected;
+  char unit = options->output_unit;
+  char buf[ITEMP_FORMAT_MAX + 1];
+
+  for (int i = 1; i < n_workers; i++) {
+    itemp_stats_merge(stats, &workers[i].stats);
+    itemp_histogram_merge(histogram, workers[i].histogram);
+    rejected += workers[i].rejected;
+  }
+
+  printf("count     %llu\n", (unsigned long long)stats->count);
+  if (!options->binary) {
+    printf("rejected  %llu\n", (unsigned long long)rejected);
+  }
+  if (stats->count == 0) {
+    return;
+  }
+  printf("min       %s%c\n",
+         format_100(buf, to_output_100(options, stats->min)),
+         unit);
+  printf("max       %s%c\n",
+         format_100(buf, to_output_100(options, stats->max)),
+         unit);
+  // the exact mean, rounded once to hundredths
+  int16_t mean_100 = (options->output_unit == 'F')
+                         ? itemp_stats_mean_fahrenheit_100(stats)
+                         : itemp_stats_mean_celsius_100(stats);
+  printf("mean      %s%c\n", format_100(buf, mean_100), unit);
+  for (int i = 0; i < options->n_percentiles; i++) {
+    float percentile = options->percentiles[i];
+    itemp_t itemp = itemp_histogram_percentile(histogram, percentile);
+    printf("p%-8g %s%c\n", percentile,
+           format_100(buf, to_output_100(options, itemp)), unit);
+  }
+
+  if (options->n_buckets > 0) {
+    uint32_t span = (uint32_t)stats->max - stats->min + 1;
+    uint32_t width = (span + options->n_buckets - 1) / options->n_buckets;
+    uint32_t lo = stats->min;
+    printf("histogram\n");
+    while (lo <= stats->max) {
+      uint32_t hi = lo + width - 1;
+      uint64_t count = 0;
+      char hi_buf[ITEMP_FORMAT_MAX + 1];
+      if (hi > stats->max) {
+        hi = stats->max;
+      }
+      for (uint32_t i = lo; i <= hi; i++) {
+        count += histogram->bins[i];
+      }
+      printf("  %9s%c .. %9s%c  %llu\n",
+             format_100(buf, to_output_100(options, lo)), unit,
+             format_100(hi_buf, to_output_100(options, hi)),
+             unit, (unsigned long long)count);
+      lo = hi + 1;
+    }
+  }
+}
+#endif
+
+// =============================================================================
+// self test
+
+#ifdef UNIT_TEST
+
+#include "itemp_unit_test.h"
+
+/**
+ * @brief Summarize the input with n_workers threads and return the count.
+ */
+static uint64_t count_input(const char *data, size_t size, int n_workers,
+                            uint64_t *rejected) {
+  options_t options;
+  int first_file;
+  char *argv[] = {"itemp-stats", NULL};
+  uint64_t count = 0;
+
+  optind = 1;
+  parse_options(1, argv, &options, &first_file);
+  for (int i = 0; i < n_workers; i++) {
+    s_workers[i].options = &options;
+    s_workers[i].rejected = 0;
+    itemp_stats_init(&s_workers[i].stats);
+    s_workers[i].histogram = malloc(sizeof(itemp_histogram_t));
+    itemp_histogram_init(s_workers[i].histogram);
+  }
+  process_input("test", data, size, s_workers, n_workers);
+  *rejected = 0;
+  for (int i = 0; i < n_workers; i++) {
+    count += s_workers[i].stats.count;
+    *rejected += s_workers[i].rejected;
+    free(s_workers[i].histogram);
+  }
+  return count;
+}
+
+/**
+ * @brief count_input() on text read as stdin is, through read_stream().
+ */
+static uint64_t count_stream(const char *text, int n_workers,
+                             uint64_t *rejected) {
+  FILE *stream = fmemopen((void *)text, strlen(text), "r");
+  size_t size;
+  char *data = read_stream(stream, &size);
+  uint64_t count = count_input(data, size, n_workers, rejected);
+
+  fclose(stream);
+  free(data);
+  return count;
+}
+
+/**
+ * @brief count_input() on text in a file, mapped as named inputs are.
+ */
+static uint64_t count_file(const char *text, int n_workers,
+                           uint64_t *rejected) {
+  char name[] = "/tmp/itemp-stats-XXXXXX";
+  int fd = mkstemp(name);
+  const char *data;
+  size_t size;
+  uint64_t count;
+
+  if (fd < 0 || write(fd, text, strlen(text)) != (ssize_t)strlen(text)) {
+    return UINT64_MAX;
+  }
+  close(fd);
+  map_file(name, &data, &size);
+  count = count_input(data, size, n_workers, rejected);
+  if (size > 0) {
+    munmap((void *)data, size);
+  }
+  unlink(name);
+  return count;
+}
+
+int main() {
+  uint64_t rejected;
+
+  printf("Beginning unit tests...");
+
+  // fewer bytes than workers, so most chunks are empty
+  ASSERT_INT(count_stream("70\n", 4, &rejected), 1);
+  ASSERT_INT(rejected, 0);
+  ASSERT_INT(count_stream("7", 4, &rejected), 1);
+  ASSERT_INT(count_stream("70\n71\n", 64, &rejected), 2);
+  ASSERT_INT(count_file("70\n", 4, &rejected), 1);
+  ASSERT_INT(count_stream("", 4, &rejected), 0);
+
+  // lines that straddle chunk boundaries are counted once
+  ASSERT_INT(count_stream("70\n71.5\n-3\nx\n100\n", 3, &rejected), 4);
+  ASSERT_INT(rejected, 1);
+  ASSERT_INT(count_file("70\n71.5\n-3\nx\n100\n", 7, &rejected), 4);
+  ASSERT_INT(rejected, 1);
+
+  printf("\r\n...unit tests complete.\r\n");
+  return 0;
+}
+
+#endif
@@ -0,0 +1,300 @@
+/** @file itemp_text.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp_text.h"
+#include <stddef.h>
+
+// =============================================================================
+// local types and definitions
+
+// Largest magnitude (in hundredths) accumulated before saturating.
+#define DECIMAL_100_LIMIT (INT32_MAX / 10 - 10)
+
+// =============================================================================
+// local (forward) declarations
+
+static bool is_digit(char c);
+
+/**
+ * @brief Return value * 10 + digit, saturating at DECIMAL_100_LIMIT.
+ */
+static int32_t accumulate(int32_t value, int digit);
+
+/**
+ * @brief Clamp decimals to the resolutions supported by itemp.
+ */
+static int clamp_decimals(int decimals);
+
+// =============================================================================
+// local storage
+
+// =============================================================================
+// public code
+
+const char *itemp_parse_decimal_100(const char *s, const char *end,
+                                    int32_t *value_100) {
+  bool negative = false;
+  bool saw_digit = false;
+  int32_t value = 0;
+  int fraction_digits = 0;
+  bool round_up = false;
+
+  while (s < end && (*s == ' ' || *s == '\t')) {
+    s++;
+  }
+  if (s < end && (*s == '-' || *s == '+')) {
+    negative = (*s == '-');
+    s++;
+  }
+  while (s < end && is_digit(*s)) {
+    value = accumulate(value, *s - '0');
+    saw_digit = true;
+    s++;
+  }
+  if (s < end && *s == '.') {
+    s++;
+    while (s < end && is_digit(*s)) {
+      if (fraction_digits < 2) {
+        value = accumulate(value, *s - '0');
+      } else if (fraction_digits == 2) {
+        round_up = (*s >= '5');
+      }
+      fraction_digits++;
+      saw_digit = true;
+      s++;
+    }
+  }
+  if (!saw_digit) {
+    return NULL;
+  }
+  for (; fraction_digits < 2; fraction_digits++) {
+    value = accumulate(value, 0);
+  }
+  if (round_up) {
+    value += 1;
+  }
+  *value_100 = negative ? -value : value;
+  return s;
+}
+
+bool itemp_from_fahrenheit_100_checked(int32_t fahrenheit_100, itemp_t *itemp) {
+  if (fahrenheit_100 < ITEMP_MIN_FAHRENHEIT_100 ||
+      fahrenheit_100 > ITEMP_MAX_FAHRENHEIT_100) {
+    return false;
+  }
+  *itemp = fahrenheit_100_to_itemp(fahrenheit_100);
+  return true;
+}
+
+bool itemp_from_celsius_100_checked(int32_t celsius_100, itemp_t *itemp) {
+  if (celsius_100 < ITEMP_MIN_CELSIUS_100 ||
+      celsius_100 > ITEMP_MAX_CELSIUS_100) {
+    return false;
+  }
+  *itemp = celsius_100_to_itemp(celsius_100);
+  return true;
+}
+
+size_t itemp_format_decimal(char *buf, int16_t value, int decimals) {
+  char digits[8];
+  int n_digits = 0;
+  uint32_t magnitude = (value < 0) ? -(int32_t)value : value;
+  size_t length = 0;
+
+  decimals = (decimals < 0) ? 0 : (decimals > 4) ? 4 : decimals;
+  // least significant digit first, with at least one before the point
+  do {
+    digits[n_digits++] = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude > 0 || n_digits <= decimals);
+
+  if (value < 0) {
+    buf[length++] = '-';
+  }
+  while (n_digits > 0) {
+    if (n_digits == decimals) {
+      buf[length++] = '.';
+    }
+    buf[length++] = digits[--n_digits];
+  }
+  return length;
+}
+
+size_t itemp_format_fahrenheit(char *buf, itemp_t itemp, int decimals) {
+  switch (clamp_decimals(decimals)) {
+  case 0:
+    return itemp_format_decimal(buf, itemp_to_fahrenheit_1(itemp), 0);
+  case 1:
+    return itemp_format_decimal(buf, itemp_to_fahrenheit_10(itemp), 1);
+  default:
+    return itemp_format_decimal(buf, itemp_to_fahrenheit_100(itemp), 2);
+  }
+}
+
+size_t itemp_format_celsius(char *buf, itemp_t itemp, int decimals) {
+  switch (clamp_decimals(decimals)) {
+  case 0:
+    return itemp_format_decimal(buf, itemp_to_celsius_1(itemp), 0);
+  case 1:
+    return itemp_format_decimal(buf, itemp_to_celsius_10(itemp), 1);
+  default:
+    return itemp_format_decimal(buf, itemp_to_celsius_100(itemp), 2);
+  }
+}
+
+// =============================================================================
+// local (static) code
+
+static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+static int32_t accumulate(int32_t value, int digit) {
+  value = value * 10 + digit;
+  return (value > DECIMAL_100_LIMIT) ? DECIMAL_100_LIMIT : value;
+}
+
+static int clamp_decimals(int decimals) {
+  return (decimals < 0) ? 0 : (decimals > 2) ? 2 : decimals;
+}
+
+// =============================================================================
+// self test
+
+// To run tests on a unix-like system:
+//   cc -Wall -c itemp.c
+//   cc -Wall -DUNIT_TEST -o itemp_text itemp_text.c itemp.o && ./itemp_text
+
+#ifdef UNIT_TEST
+
+#include "itemp_unit_test.h"
+#include <string.h>
+
+static int32_t parse(const char *s) {
+  int32_t value = -99999;
+  itemp_parse_decimal_100(s, s + strlen(s), &value);
+  return value;
+}
+
+static int consumed(const char *s) {
+  int32_t value;
+  const char *p = itemp_parse_decimal_100(s, s + strlen(s), &value);
+  return p ? (int)(p - s) : -1;
+}
+
+static char s_buf[ITEMP_FORMAT_MAX + 1];
+
+static const char *format_decimal(int16_t value, int decimals) {
+  s_buf[itemp_format_decimal(s_buf, value, decimals)] = '\0';
+  return s_buf;
+}
+
+static const char *format_f(itemp_t itemp, int decimals) {
+  s_buf[itemp_format_fahrenheit(s_buf, itemp, decimals)] = '\0';
+  return s_buf;
+}
+
+static const char *format_c(itemp_t itemp, int decimals) {
+  s_buf[itemp_format_celsius(s_buf, itemp, decimals)] = '\0';
+  return s_buf;
+}
+
+#define ASSERT_STR(observed, expected) \
+  ASSERT_INT(strcmp((observed), (expected)), 0)
+
+int main() {
+  printf("Beginning unit tests...");
+
+  ASSERT_INT(parse("0"), 0);
+  ASSERT_INT(parse("72"), 7200);
+  ASSERT_INT(parse("72.1"), 7210);
+  ASSERT_INT(parse("72.15"), 7215);
+  ASSERT_INT(parse("-3.5"), -350);
+  ASSERT_INT(parse("+3.5"), 350);
+  ASSERT_INT(parse(".25"), 25);
+  ASSERT_INT(parse("  \t7."), 700);
+  ASSERT_INT(parse("98.625"), 9863);    // rounds half away from zero
+  ASSERT_INT(parse("-98.625"), -9863);  // rounds half away from zero
+  ASSERT_INT(parse("98.6249"), 9862);
+  ASSERT_INT(parse("99999999999"), DECIMAL_100_LIMIT);  // saturates
+
+  ASSERT_INT(consumed("72.15F"), 5);
+  ASSERT_INT(consumed("72,73"), 2);
+  ASSERT_INT(consumed("F"), -1);
+  ASSERT_INT(consumed("-"), -1);
+  ASSERT_INT(consumed(""), -1);
+
+  itemp_t itemp = 0;
+  ASSERT_INT(itemp_from_fahrenheit_100_checked(7000, &itemp), true);
+  ASSERT_INT(itemp, 42760);
+  ASSERT_INT(itemp_from_fahrenheit_100_checked(-1552, &itemp), true);
+  ASSERT_INT(itemp, 0);
+  ASSERT_INT(itemp_from_fahrenheit_100_checked(11555, &itemp), true);
+  ASSERT_INT(itemp, 65535);
+  ASSERT_INT(itemp_from_fahrenheit_100_checked(-1553, &itemp), false);
+  ASSERT_INT(itemp_from_fahrenheit_100_checked(11556, &itemp), false);
+
+  ASSERT_INT(itemp_from_celsius_100_checked(2000, &itemp), true);
+  ASSERT_INT(itemp, 41760);
+  ASSERT_INT(itemp_from_celsius_100_checked(-2641, &itemp), false);
+  ASSERT_INT(itemp_from_celsius_100_checked(4642, &itemp), false);
+
+  // ===========================================
+  // formatting
+
+  ASSERT_STR(format_decimal(7215, 2), "72.15");
+  ASSERT_STR(format_decimal(5, 2), "0.05");
+  ASSERT_STR(format_decimal(-5, 2), "-0.05");
+  ASSERT_STR(format_decimal(-1552, 2), "-15.52");
+  ASSERT_STR(format_decimal(0, 0), "0");
+  ASSERT_STR(format_decimal(-32768, 0), "-32768");
+  ASSERT_STR(format_decimal(-32768, 4), "-3.2768");
+  ASSERT_STR(format_decimal(700, 1), "70.0");
+
+  ASSERT_STR(format_f(42760, 2), "70.00");
+  ASSERT_STR(format_f(42760, 1), "70.0");
+  ASSERT_STR(format_f(42760, 0), "70");
+  ASSERT_STR(format_f(0, 2), "-15.52");
+  ASSERT_STR(format_f(65535, 2), "115.55");
+  ASSERT_STR(format_f(0, 7), "-15.52");    // clamped to 2 decimals
+  ASSERT_STR(format_c(0, 2), "-26.40");
+  ASSERT_STR(format_c(41760, 1), "20.0");
+  ASSERT_STR(format_c(41760, -1), "20");  // clamped to 0 decimals
+
+  // formatting and parsing round trip for every itemp
+  int mismatches = 0;
+  for (int32_t i = 0; i <= UINT16_MAX; i++) {
+    int32_t value_100;
+    size_t n = itemp_format_celsius(s_buf, i, 2);
+    itemp_parse_decimal_100(s_buf, s_buf + n, &value_100);
+    mismatches += (value_100 != itemp_to_celsius_100(i));
+  }
+  ASSERT_INT(mismatches, 0);
+
+  printf("\r\n...unit tests complete.\r\n");
+}
+
+#endif
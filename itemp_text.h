@@ -0,0 +1,127 @@
+/** @file itemp_text.h
+ * Conversion between text and fixed point temperatures, for tools that read
+ * or write temperatures as decimal strings.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_TEXT_H_
+#define _ITEMP_TEXT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// types and definitions
+
+/**
+ * @brief The most characters written by the itemp_format_xxx() functions,
+ * e.g. "-15.52" or "-26.40".  No terminating null is written.
+ */
+#define ITEMP_FORMAT_MAX 8
+
+// =============================================================================
+// declarations
+
+/**
+ * Parse a decimal number such as "72", "-3.5" or "98.625" into hundredths.
+ *
+ * Leading spaces and tabs are skipped.  Digits beyond the second decimal place
+ * are rounded to nearest (away from zero on a tie), matching the rounding of
+ * the itemp_to_xxx() functions.  Values too large for an int32_t saturate.
+ *
+ * @param s The first character to parse.
+ * @param end One past the last character that may be parsed.
+ * @param value_100 Receives the parsed value in hundredths.
+ * @returns A pointer to the first unparsed character, or NULL if s does not
+ * start with a number.
+ */
+const char *itemp_parse_decimal_100(const char *s, const char *end,
+                                    int32_t *value_100);
+
+/**
+ * Convert hundreths of a degree Fahrenheit to an itemp value, rejecting values
+ * that would wrap around.
+ *
+ * @param fahrenheit_100 Temperature in hundreths of a degree Fahrenheit.
+ * @param itemp Receives the corresponding itemp value.
+ * @returns true if fahrenheit_100 can be represented as an itemp.
+ */
+bool itemp_from_fahrenheit_100_checked(int32_t fahrenheit_100, itemp_t *itemp);
+
+/**
+ * Convert hundreths of a degree Celsius to an itemp value, rejecting values
+ * that would wrap around.
+ *
+ * @param celsius_100 Temperature in hundreths of a degree Celsius.
+ * @param itemp Receives the corresponding itemp value.
+ * @returns true if celsius_100 can be represented as an itemp.
+ */
+bool itemp_from_celsius_100_checked(int32_t celsius_100, itemp_t *itemp);
+
+/**
+ * Write a fixed point value as decimal text, e.g. value 7215 with 2 decimals
+ * is written as "72.15".  This does not use printf() or floating point.
+ *
+ * @param buf Receives the text.  No terminating null is written.
+ * @param value The value, scaled by 10^decimals.
+ * @param decimals The number of digits after the decimal point, 0 to 4.
+ * Values outside that range are clamped.
+ * @returns The number of characters written, at most ITEMP_FORMAT_MAX.
+ */
+size_t itemp_format_decimal(char *buf, int16_t value, int decimals);
+
+/**
+ * Write an itemp as degrees Fahrenheit with 0, 1 or 2 decimal places.
+ *
+ * @param buf Receives at most ITEMP_FORMAT_MAX characters, without a null.
+ * @param itemp An itemp value.
+ * @param decimals 0, 1 or 2.  Values outside that range are clamped.
+ * @returns The number of characters written.
+ */
+size_t itemp_format_fahrenheit(char *buf, itemp_t itemp, int decimals);
+
+/**
+ * Write an itemp as degrees Celsius with 0, 1 or 2 decimal places.
+ *
+ * @param buf Receives at most ITEMP_FORMAT_MAX characters, without a null.
+ * @param itemp An itemp value.
+ * @param decimals 0, 1 or 2.  Values outside that range are clamped.
+ * @returns The number of characters written.
+ */
+size_t itemp_format_celsius(char *buf, itemp_t itemp, int decimals);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _ITEMP_TEXT_H_ */
@@ -0,0 +1,140 @@
+/** @file itemp_trace.h
+ * Optional USDT (user level static) probes in the batch conversions, for
+ * tracing a running process with perf or bpftrace.
+ *
+ * Compile itemp.c and itemp_batch.c with -DITEMP_USDT on a system with
+ * sys/sdt.h (systemtap-sdt-dev) to place the probes.  Each is a single nop
+ * until a tracer attaches, and the out of range probes are guarded by
+ * semaphores so their checks are skipped until then.  Without the flag the
+ * ITEMP_TRACE_xxx() macros expand to nothing.
+ *
+ * The probes, all in provider itemp:
+ *
+ *   batch__entry(conversion, n, backend)  a batch conversion begins
+ *   batch__exit(conversion, n)            and ends
+ *   out__of__range(conversion, index, value)  an input that wraps around
+ *
+ * conversion is an itemp_conversion_t, backend an itemp_trace_backend_t and
+ * index the position in the batch (0 for the scalar conversions).  e.g.
+ *
+ *   bpftrace -e 'usdt:./app:itemp:out__of__range { @[arg0] = count(); }'
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_TRACE_H_
+#define _ITEMP_TRACE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// includes
+
+#include "itemp_batch.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ITEMP_USDT
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+#endif
+
+// =============================================================================
+// types and definitions
+
+/**
+ * @brief How a batch is converted, reported by the batch__entry probe.
+ */
+typedef enum {
+  ITEMP_TRACE_LOOP,          // a dense, compiler vectorized loop
+  ITEMP_TRACE_IN_PLACE,      // the same, over a single buffer
+  ITEMP_TRACE_GATHER_FIXED,  // strided: copied at a constant stride
+  ITEMP_TRACE_GATHER_AVX2,   // strided: AVX2 gather instructions
+  ITEMP_TRACE_GATHER_SCALAR, // strided: one value at a time
+  ITEMP_TRACE_INSTALLED,     // set by itemp_set_batch_backend()
+} itemp_trace_backend_t;
+
+#ifdef ITEMP_USDT
+
+/**
+ * @brief Non-zero while a tracer is attached to the out__of__range probe.
+ * Defined in itemp.c.
+ */
+extern unsigned short itemp_out__of__range_semaphore;
+
+#define ITEMP_TRACE_BATCH_ENTRY(conversion, n, backend) \
+  DTRACE_PROBE3(itemp, batch__entry, (int)(conversion), (size_t)(n), \
+                (int)(backend))
+
+#define ITEMP_TRACE_BATCH_EXIT(conversion, n) \
+  DTRACE_PROBE2(itemp, batch__exit, (int)(conversion), (size_t)(n))
+
+#define ITEMP_TRACE_IF_OUT_OF_RANGE(conversion, value, min, max)      \
+  do {                                                                \
+    if (itemp_out__of__range_semaphore &&                             \
+        ((value) < (min) || (value) > (max))) {                       \
+      DTRACE_PROBE3(itemp, out__of__range, (int)(conversion),         \
+                    (size_t)0, (int)(value));                         \
+    }                                                                 \
+  } while (0)
+
+/**
+ * @brief Fire out__of__range for each input outside min..max, where values[0]
+ * is at index first of the batch.  Call this before converting in place.
+ */
+#define ITEMP_TRACE_OUT_OF_RANGE_BATCH(conversion, values, first, n, min, \
+                                       max)                               \
+  do {                                                                    \
+    if (itemp_out__of__range_semaphore) {                                 \
+      for (size_t i_ = 0; i_ < (n); i_++) {                               \
+        if ((values)[i_] < (min) || (values)[i_] > (max)) {               \
+          DTRACE_PROBE3(itemp, out__of__range, (int)(conversion),         \
+                        (size_t)(first) + i_, (int)(values)[i_]);         \
+        }                                                                 \
+      }                                                                   \
+    }                                                                     \
+  } while (0)
+
+#else
+
+// The arguments are evaluated as void, so that parameters kept for the probes
+// are not unused.
+#define ITEMP_TRACE_BATCH_ENTRY(conversion, n, backend) \
+  ((void)(conversion), (void)(n), (void)(backend))
+#define ITEMP_TRACE_BATCH_EXIT(conversion, n) ((void)(conversion), (void)(n))
+#define ITEMP_TRACE_IF_OUT_OF_RANGE(conversion, value, min, max) \
+  ((void)(conversion), (void)(value), (void)(min), (void)(max))
+#define ITEMP_TRACE_OUT_OF_RANGE_BATCH(conversion, values, first, n, min,     \
+                                       max)                                   \
+  ((void)(conversion), (void)(values), (void)(first), (void)(n), (void)(min), \
+   (void)(max))
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _ITEMP_TRACE_H_ */
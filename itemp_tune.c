@@ -0,0 +1,735 @@
+/** @file itemp_tune.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp_tune.h"
+#include "itemp.h"
+#include "itemp_batch.h"
+#include "itemp_stats.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+// =============================================================================
+// local types and definitions
+
+#define TABLE_SIZE 65536
+
+// A challenger must be this much faster than the loop to replace it.
+#define MARGIN 0.05
+
+#define CACHE_HEADER "itemp_tune 1"
+
+#if defined(__x86_64__)
+#define ARCH "x86_64"
+#elif defined(__i386__)
+#define ARCH "i386"
+#elif defined(__aarch64__)
+#define ARCH "aarch64"
+#elif defined(__arm__)
+#define ARCH "arm"
+#else
+#define ARCH "other"
+#endif
+
+// the widest instruction set the loops were compiled for
+#if defined(__AVX512BW__)
+#define ISA "avx512bw"
+#elif defined(__AVX2__)
+#define ISA "avx2"
+#elif defined(__SSE2__)
+#define ISA "sse2"
+#elif defined(__ARM_NEON)
+#define ISA "neon"
+#else
+#define ISA "base"
+#endif
+
+// Every conversion, as (conversion, the name of its itemp.h function).
+#define CONVERSIONS(X)                                \
+  X(ITEMP_TO_FAHRENHEIT_1, itemp_to_fahrenheit_1)     \
+  X(ITEMP_TO_FAHRENHEIT_10, itemp_to_fahrenheit_10)   \
+  X(ITEMP_TO_FAHRENHEIT_100, itemp_to_fahrenheit_100) \
+  X(ITEMP_TO_CELSIUS_1, itemp_to_celsius_1)           \
+  X(ITEMP_TO_CELSIUS_10, itemp_to_celsius_10)         \
+  X(ITEMP_TO_CELSIUS_100, itemp_to_celsius_100)       \
+  X(FAHRENHEIT_1_TO_ITEMP, fahrenheit_1_to_itemp)     \
+  X(FAHRENHEIT_10_TO_ITEMP, fahrenheit_10_to_itemp)   \
+  X(FAHRENHEIT_100_TO_ITEMP, fahrenheit_100_to_itemp) \
+  X(CELSIUS_1_TO_ITEMP, celsius_1_to_itemp)           \
+  X(CELSIUS_10_TO_ITEMP, celsius_10_to_itemp)         \
+  X(CELSIUS_100_TO_ITEMP, celsius_100_to_itemp)
+
+// =============================================================================
+// local (forward) declarations
+
+static uint64_t now_ns(void);
+static uint32_t xorshift32(uint32_t *state);
+
+/**
+ * @brief Return the 65536 entry table for a conversion, building it from the
+ * loop if need be, or NULL if out of memory.
+ */
+static const uint16_t *table_for(itemp_conversion_t conversion);
+static void table_convert(const uint16_t *table, const uint16_t *src,
+                          uint16_t *dst, size_t n);
+
+/**
+ * @brief Time and choose the backends of one conversion.
+ */
+static void tune_conversion(itemp_tune_t *tune, itemp_conversion_t conversion,
+                            const itemp_t *itemps, uint16_t *src,
+                            uint16_t *dst, uint16_t *all, uint16_t *expected,
+                            size_t n, int repetitions);
+static double time_conversion(itemp_batch_fn_t fn, const uint16_t *src,
+                              uint16_t *dst, size_t n, int repetitions);
+
+/**
+ * @brief Time and choose the backends of histogram updates.
+ */
+static void tune_histogram(itemp_tune_t *tune, itemp_histogram_t *histograms,
+                           const itemp_t *itemps, size_t n, int repetitions);
+static double time_histogram(itemp_histogram_fn_t fn,
+                             itemp_histogram_t *histogram,
+                             const itemp_t *itemps, size_t n,
+                             int repetitions);
+
+/**
+ * @brief The same loop as itemp_histogram_update(), which may itself have
+ * been replaced.
+ */
+static void histogram_loop(itemp_histogram_t *histogram, const itemp_t *itemps,
+                           size_t n);
+
+/**
+ * @brief Update the histogram two values at a time, so a repeated value costs
+ * one increment rather than two that wait on each other.
+ */
+static void histogram_paired(itemp_histogram_t *histogram,
+                             const itemp_t *itemps, size_t n);
+
+/**
+ * @brief Return whether backend is a candidate for kernel.
+ */
+static bool applies(int kernel, itemp_tune_backend_t backend);
+
+/**
+ * @brief Choose the fastest of the timed candidates of one kernel.
+ */
+static void choose(itemp_tune_t *tune, int kernel);
+
+// The candidates of each conversion, with the signature of itemp_batch_fn_t.
+#define DECLARE_CANDIDATES(conversion, fn)                       \
+  static void loop_##fn(const void *src, void *dst, size_t n);   \
+  static void scalar_##fn(const void *src, void *dst, size_t n); \
+  static void table_##fn(const void *src, void *dst, size_t n);
+CONVERSIONS(DECLARE_CANDIDATES)
+
+// =============================================================================
+// local storage
+
+#define LOOP_ENTRY(conversion, fn) [conversion] = loop_##fn,
+#define SCALAR_ENTRY(conversion, fn) [conversion] = scalar_##fn,
+#define TABLE_ENTRY(conversion, fn) [conversion] = table_##fn,
+#define NAME_ENTRY(conversion, fn) [conversion] = #fn,
+
+static const itemp_batch_fn_t s_loops[ITEMP_CONVERSION_COUNT] = {
+    CONVERSIONS(LOOP_ENTRY)};
+static const itemp_batch_fn_t s_scalars[ITEMP_CONVERSION_COUNT] = {
+    CONVERSIONS(SCALAR_ENTRY)};
+static const itemp_batch_fn_t s_table_fns[ITEMP_CONVERSION_COUNT] = {
+    CONVERSIONS(TABLE_ENTRY)};
+static const char *s_kernel_names[ITEMP_TUNE_KERNELS] = {
+    CONVERSIONS(NAME_ENTRY)[ITEMP_TUNE_HISTOGRAM] = "histogram"};
+
+static const char *s_backend_names[ITEMP_TUNE_BACKEND_COUNT] = {
+    "loop", "table", "scalar", "paired"};
+
+static uint16_t *s_tables[ITEMP_CONVERSION_COUNT];
+
+// =============================================================================
+// public code
+
+bool itemp_tune_init(const char *path) {
+  itemp_tune_t tune;
+
+  if (path == NULL || !itemp_tune_load(&tune, path)) {
+    if (!itemp_tune_measure(&tune, ITEMP_TUNE_ELEMENTS,
+                            ITEMP_TUNE_REPETITIONS)) {
+      return false;
+    }
+    if (path != NULL) {
+      (void)itemp_tune_save(&tune, path);
+    }
+  }
+  return itemp_tune_apply(&tune);
+}
+
+bool itemp_tune_measure(itemp_tune_t *tune, size_t n, int repetitions) {
+  uint32_t seed = 0x1234567;
+  itemp_t *itemps = malloc(n * sizeof(itemp_t));
+  uint16_t *src = malloc(n * sizeof(uint16_t));
+  uint16_t *dst = malloc(n * sizeof(uint16_t));
+  uint16_t *all = malloc(TABLE_SIZE * sizeof(uint16_t));
+  uint16_t *expected = malloc(TABLE_SIZE * sizeof(uint16_t));
+  itemp_histogram_t *histograms = malloc(2 * sizeof(itemp_histogram_t));
+  bool ok = itemps && src && dst && all && expected && histograms;
+
+  memset(tune, 0, sizeof(*tune));
+  itemp_tune_signature(tune->signature, sizeof(tune->signature));
+  if (ok) {
+    // Sensor readings drift rather than jump, which matters to histograms:
+    // neighbouring values often land in the same bin.
+    itemp_t itemp = 35000;
+    for (size_t i = 0; i < n; i++) {
+      itemp += (itemp_t)(xorshift32(&seed) % 9) - 4;
+      itemps[i] = itemp;
+    }
+    for (size_t i = 0; i < TABLE_SIZE; i++) {
+      all[i] = (uint16_t)i;
+    }
+    for (int c = 0; c < ITEMP_CONVERSION_COUNT && ok; c++) {
+      ok = table_for((itemp_conversion_t)c) != NULL;
+      if (ok) {
+        tune_conversion(tune, (itemp_conversion_t)c, itemps, src, dst, all,
+                        expected, n, repetitions);
+      }
+    }
+    if (ok) {
+      tune_histogram(tune, histograms, itemps, n, repetitions);
+    }
+  }
+  free(itemps);
+  free(src);
+  free(dst);
+  free(all);
+  free(expected);
+  free(histograms);
+  return ok;
+}
+
+bool itemp_tune_apply(const itemp_tune_t *tune) {
+  itemp_tune_reset();
+  for (int c = 0; c < ITEMP_CONVERSION_COUNT; c++) {
+    if (tune->backends[c] == ITEMP_TUNE_TABLE &&
+        table_for((itemp_conversion_t)c) == NULL) {
+      itemp_tune_reset();
+      return false;
+    }
+  }
+  for (int c = 0; c < ITEMP_CONVERSION_COUNT; c++) {
+    itemp_batch_fn_t fn = NULL;
+    if (tune->backends[c] == ITEMP_TUNE_TABLE) {
+      fn = s_table_fns[c];
+    } else if (tune->backends[c] == ITEMP_TUNE_SCALAR) {
+      fn = s_scalars[c];
+    }
+    itemp_set_batch_backend((itemp_conversion_t)c, fn);
+  }
+  itemp_set_histogram_backend(
+      tune->backends[ITEMP_TUNE_HISTOGRAM] == ITEMP_TUNE_PAIRED
+          ? histogram_paired
+          : NULL);
+  return true;
+}
+
+void itemp_tune_reset(void) {
+  for (int c = 0; c < ITEMP_CONVERSION_COUNT; c++) {
+    itemp_set_batch_backend((itemp_conversion_t)c, NULL);
+    free(s_tables[c]);
+    s_tables[c] = NULL;
+  }
+  itemp_set_histogram_backend(NULL);
+}
+
+bool itemp_tune_save(const itemp_tune_t *tune, const char *path) {
+  char temporary[4096];
+  FILE *fp;
+
+  // Write a private file and rename it, so that a process starting at the
+  // same time reads either the old cache or the new one.
+  if (snprintf(temporary, sizeof(temporary), "%s.%ld", path,
+               (long)getpid()) >= (int)sizeof(temporary) ||
+      (fp = fopen(temporary, "w")) == NULL) {
+    return false;
+  }
+  fprintf(fp, "%s\nsignature %s\n", CACHE_HEADER, tune->signature);
+  for (int k = 0; k < ITEMP_TUNE_KERNELS; k++) {
+    fprintf(fp, "%s %s\n", s_kernel_names[k],
+            s_backend_names[tune->backends[k]]);
+  }
+  if (fclose(fp) != 0 || rename(temporary, path) != 0) {
+    remove(temporary);
+    return false;
+  }
+  return true;
+}
+
+bool itemp_tune_load(itemp_tune_t *tune, const char *path) {
+  char line[256];
+  char signature[ITEMP_TUNE_SIGNATURE_MAX + 16];
+  bool ok = true;
+  FILE *fp = fopen(path, "r");
+
+  if (fp == NULL) {
+    return false;
+  }
+  memset(tune, 0, sizeof(*tune));
+  itemp_tune_signature(tune->signature, sizeof(tune->signature));
+  snprintf(signature, sizeof(signature), "signature %s\n", tune->signature);
+  if (fgets(line, sizeof(line), fp) == NULL ||
+      strcmp(line, CACHE_HEADER "\n") != 0 ||
+      fgets(line, sizeof(line), fp) == NULL || strcmp(line, signature) != 0) {
+    ok = false;
+  }
+  while (ok && fgets(line, sizeof(line), fp) != NULL) {
+    char kernel_name[64];
+    char backend_name[16];
+    int kernel = 0;
+    int backend = 0;
+    if (sscanf(line, "%63s %15s", kernel_name, backend_name) != 2) {
+      ok = false;
+      break;
+    }
+    while (kernel < ITEMP_TUNE_KERNELS &&
+           strcmp(kernel_name, s_kernel_names[kernel]) != 0) {
+      kernel++;
+    }
+    while (backend < ITEMP_TUNE_BACKEND_COUNT &&
+           strcmp(backend_name, s_backend_names[backend]) != 0) {
+      backend++;
+    }
+    ok = kernel < ITEMP_TUNE_KERNELS && backend < ITEMP_TUNE_BACKEND_COUNT &&
+         applies(kernel, (itemp_tune_backend_t)backend);
+    if (ok) {
+      tune->backends[kernel] = (itemp_tune_backend_t)backend;
+    }
+  }
+  fclose(fp);
+  return ok;
+}
+
+void itemp_tune_signature(char *buf, size_t size) {
+  char cpu[49] = "unknown";
+  long l1d = 0;
+  long l2 = 0;
+  long l3 = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+  unsigned int brand[12];
+  if (__get_cpuid_max(0x80000000, NULL) >= 0x80000004) {
+    for (unsigned int i = 0; i < 3; i++) {
+      __get_cpuid(0x80000002 + i, &brand[4 * i], &brand[4 * i + 1],
+                  &brand[4 * i + 2], &brand[4 * i + 3]);
+    }
+    memcpy(cpu, brand, 48);
+    cpu[48] = '\0';
+  }
+#endif
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+  l1d = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+  l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+  const char *name = cpu;
+  while (*name == ' ') {
+    name++;
+  }
+  snprintf(buf, size, "%s %s l1d=%ld l2=%ld l3=%ld %s", ARCH, ISA, l1d, l2,
+           l3, name);
+  // a brand string could in principle hold a newline, which would split the
+  // signature line of the cache
+  for (char *p = buf; *p != '\0'; p++) {
+    *p = (*p == '\n' || *p == '\r') ? ' ' : *p;
+  }
+}
+
+const char *itemp_tune_kernel_name(int kernel) {
+  return (kernel >= 0 && kernel < ITEMP_TUNE_KERNELS) ? s_kernel_names[kernel]
+                                                      : "unknown";
+}
+
+const char *itemp_tune_backend_name(itemp_tune_backend_t backend) {
+  return ((unsigned)backend < ITEMP_TUNE_BACKEND_COUNT)
+             ? s_backend_names[backend]
+             : "unknown";
+}
+
+// =============================================================================
+// local (static) code
+
+static uint64_t now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static uint32_t xorshift32(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *state = x;
+}
+
+static const uint16_t *table_for(itemp_conversion_t conversion) {
+  if (s_tables[conversion] == NULL) {
+    uint16_t *table = malloc(TABLE_SIZE * sizeof(uint16_t));
+    if (table == NULL) {
+      return NULL;
+    }
+    for (size_t i = 0; i < TABLE_SIZE; i++) {
+      table[i] = (uint16_t)i;
+    }
+    s_loops[conversion](table, table, TABLE_SIZE);
+    s_tables[conversion] = table;
+  }
+  return s_tables[conversion];
+}
+
+static void table_convert(const uint16_t *table, const uint16_t *src,
+                          uint16_t *dst, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    dst[i] = table[src[i]];
+  }
+}
+
+static void tune_conversion(itemp_tune_t *tune, itemp_conversion_t conversion,
+                            const itemp_t *itemps, uint16_t *src,
+                            uint16_t *dst, uint16_t *all, uint16_t *expected,
+                            size_t n, int repetitions) {
+  const itemp_batch_fn_t fns[ITEMP_TUNE_BACKEND_COUNT] = {
+      s_loops[conversion], s_table_fns[conversion], s_scalars[conversion],
+      NULL};
+
+  // Inputs to itemp are readings in range, converted from the itemps.
+  memcpy(src, itemps, n * sizeof(itemp_t));
+  if (conversion >= FAHRENHEIT_1_TO_ITEMP) {
+    s_loops[conversion - FAHRENHEIT_1_TO_ITEMP + ITEMP_TO_FAHRENHEIT_1](
+        itemps, src, n);
+  }
+  s_loops[conversion](all, expected, TABLE_SIZE);
+  for (int b = 0; b < ITEMP_TUNE_BACKEND_COUNT; b++) {
+    if (fns[b] == NULL) {
+      continue;
+    }
+    // A candidate must match the loop for every input, not just these.
+    uint16_t *out = malloc(TABLE_SIZE * sizeof(uint16_t));
+    bool same = out != NULL;
+    if (same) {
+      fns[b](all, out, TABLE_SIZE);
+      same = memcmp(out, expected, TABLE_SIZE * sizeof(uint16_t)) == 0;
+    }
+    free(out);
+    tune->ns[conversion][b] =
+        same ? time_conversion(fns[b], src, dst, n, repetitions) : -1.0;
+  }
+  choose(tune, conversion);
+}
+
+static double time_conversion(itemp_batch_fn_t fn, const uint16_t *src,
+                              uint16_t *dst, size_t n, int repetitions) {
+  double best = INFINITY;
+
+  fn(src, dst, n);  // warm up
+  for (int r = 0; r < repetitions; r++) {
+    uint64_t start = now_ns();
+    fn(src, dst, n);
+    double ns = (double)(now_ns() - start) / n;
+    best = (ns < best) ? ns : best;
+  }
+  return best;
+}
+
+static void tune_histogram(itemp_tune_t *tune, itemp_histogram_t *histograms,
+                           const itemp_t *itemps, size_t n, int repetitions) {
+  const itemp_histogram_fn_t fns[ITEMP_TUNE_BACKEND_COUNT] = {
+      histogram_loop, NULL, NULL, histogram_paired};
+
+  for (int b = 0; b < ITEMP_TUNE_BACKEND_COUNT; b++) {
+    if (fns[b] == NULL) {
+      continue;
+    }
+    itemp_histogram_init(&histograms[0]);
+    itemp_histogram_init(&histograms[1]);
+    histogram_loop(&histograms[0], itemps, n);
+    fns[b](&histograms[1], itemps, n);
+    bool same = memcmp(&histograms[0], &histograms[1],
+                       sizeof(itemp_histogram_t)) == 0;
+    tune->ns[ITEMP_TUNE_HISTOGRAM][b] =
+        same ? time_histogram(fns[b], &histograms[1], itemps, n, repetitions)
+             : -1.0;
+  }
+  choose(tune, ITEMP_TUNE_HISTOGRAM);
+}
+
+static double time_histogram(itemp_histogram_fn_t fn,
+                             itemp_histogram_t *histogram,
+                             const itemp_t *itemps, size_t n,
+                             int repetitions) {
+  double best = INFINITY;
+
+  for (int r = 0; r < repetitions; r++) {
+    uint64_t start = now_ns();
+    fn(histogram, itemps, n);
+    double ns = (double)(now_ns() - start) / n;
+    best = (ns < best) ? ns : best;
+  }
+  return best;
+}
+
+static void histogram_loop(itemp_histogram_t *histogram, const itemp_t *itemps,
+                           size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    histogram->bins[itemps[i]] += 1;
+  }
+}
+
+static void histogram_paired(itemp_histogram_t *histogram,
+                             const itemp_t *itemps, size_t n) {
+  size_t i = 0;
+
+  for (; i + 1 < n; i += 2) {
+    itemp_t a = itemps[i];
+    itemp_t b = itemps[i + 1];
+    if (a == b) {
+      histogram->bins[a] += 2;
+    } else {
+      histogram->bins[a] += 1;
+      histogram->bins[b] += 1;
+    }
+  }
+  if (i < n) {
+    histogram->bins[itemps[i]] += 1;
+  }
+}
+
+static bool applies(int kernel, itemp_tune_backend_t backend) {
+  if (backend == ITEMP_TUNE_LOOP) {
+    return true;
+  }
+  if (kernel == ITEMP_TUNE_HISTOGRAM) {
+    return backend == ITEMP_TUNE_PAIRED;
+  }
+  return backend == ITEMP_TUNE_TABLE || backend == ITEMP_TUNE_SCALAR;
+}
+
+static void choose(itemp_tune_t *tune, int kernel) {
+  const double *ns = tune->ns[kernel];
+  int best = ITEMP_TUNE_LOOP;
+
+  for (int b = 0; b < ITEMP_TUNE_BACKEND_COUNT; b++) {
+    if (b != best && applies(kernel, (itemp_tune_backend_t)b) && ns[b] > 0 &&
+        ns[b] < ns[best] * (best == ITEMP_TUNE_LOOP ? 1.0 - MARGIN : 1.0)) {
+      best = b;
+    }
+  }
+  tune->backends[kernel] = (itemp_tune_backend_t)best;
+}
+
+// None of these count or trace, so neither tuning nor a tuned backend counts
+// a value twice: itemp_convert_batch() counts the batch once.
+#define DEFINE_CANDIDATES(conversion, fn)                         \
+  static void loop_##fn(const void *src, void *dst, size_t n) {   \
+    itemp_convert_loop(conversion, src, dst, n);                  \
+  }                                                               \
+  static void scalar_##fn(const void *src, void *dst, size_t n) { \
+    const uint16_t *in = src;                                     \
+    uint16_t *out = dst;                                          \
+    for (size_t i = 0; i < n; i++) {                              \
+      out[i] = itemp_convert_value(conversion, in[i]);            \
+    }                                                             \
+  }                                                               \
+  static void table_##fn(const void *src, void *dst, size_t n) {  \
+    table_convert(s_tables[conversion], src, dst, n);             \
+  }
+CONVERSIONS(DEFINE_CANDIDATES)
+
+// =============================================================================
+// self test
+//
+// To run the self test on a unix-like system:
+//   cc -Wall -O2 -c itemp.c itemp_batch.c itemp_stats.c
+//   cc -Wall -O2 -DUNIT_TEST -c itemp_tune.c
+//   cc -o itemp_tune itemp_tune.o itemp.o itemp_batch.o itemp_stats.o -lm
+//   ./itemp_tune
+// Add -DITEMP_INSTRUMENT to each step, and itemp_counters.c to the first, to
+// check that tuning is not counted.
+
+#ifdef UNIT_TEST
+
+#include "itemp_counters.h"
+#include "itemp_unit_test.h"
+
+#define TEST_CACHE "itemp_tune_test.cache"
+
+static uint16_t s_all[TABLE_SIZE];
+static uint16_t s_expected[TABLE_SIZE];
+static uint16_t s_observed[TABLE_SIZE];
+static itemp_histogram_t s_histograms[2];
+
+// Return the number of inputs for which itemp_convert_batch() differs from
+// the named batch function.
+static int count_mismatches(itemp_conversion_t conversion) {
+  int mismatches = 0;
+  s_loops[conversion](s_all, s_expected, TABLE_SIZE);
+  itemp_convert_batch(conversion, s_all, s_observed, TABLE_SIZE);
+  for (int i = 0; i < TABLE_SIZE; i++) {
+    mismatches += s_expected[i] != s_observed[i];
+  }
+  return mismatches;
+}
+
+int main() {
+  printf("Beginning unit tests...");
+
+  itemp_tune_t tune;
+  itemp_tune_t loaded;
+
+  for (int i = 0; i < TABLE_SIZE; i++) {
+    s_all[i] = (uint16_t)i;
+  }
+
+  // every kernel gets a backend that applies, and the loop is always timed
+  ASSERT_INT(itemp_tune_measure(&tune, 4096, 3), true);
+  for (int k = 0; k < ITEMP_TUNE_KERNELS; k++) {
+    ASSERT_INT(applies(k, tune.backends[k]), true);
+    ASSERT_INT(tune.ns[k][ITEMP_TUNE_LOOP] > 0, true);
+    ASSERT_INT(tune.ns[k][tune.backends[k]] > 0, true);
+  }
+  // a table is built from the loop, so it always matches
+  for (int c = 0; c < ITEMP_CONVERSION_COUNT; c++) {
+    ASSERT_INT(tune.ns[c][ITEMP_TUNE_TABLE] > 0, true);
+  }
+
+  // each backend, installed, gives the loop's results for every input
+  for (int b = ITEMP_TUNE_LOOP; b <= ITEMP_TUNE_SCALAR; b++) {
+    for (int c = 0; c < ITEMP_CONVERSION_COUNT; c++) {
+      tune.backends[c] = (itemp_tune_backend_t)b;
+      if (b == ITEMP_TUNE_SCALAR && tune.ns[c][b] < 0) {
+        tune.backends[c] = ITEMP_TUNE_LOOP;  // ruled out by the tuner
+      }
+    }
+    ASSERT_INT(itemp_tune_apply(&tune), true);
+    for (int c = 0; c < ITEMP_CONVERSION_COUNT; c++) {
+      ASSERT_INT(count_mismatches((itemp_conversion_t)c), 0);
+    }
+  }
+
+  // the paired histogram matches, with repeats and an odd count
+  const itemp_t itemps[] = {7, 7, 7, 9, 65535, 0, 0, 7, 9};
+  const size_t n_itemps = sizeof(itemps) / sizeof(itemps[0]);
+  itemp_histogram_init(&s_histograms[0]);
+  itemp_histogram_init(&s_histograms[1]);
+  histogram_loop(&s_histograms[0], itemps, n_itemps);
+  tune.backends[ITEMP_TUNE_HISTOGRAM] = ITEMP_TUNE_PAIRED;
+  ASSERT_INT(itemp_tune_apply(&tune), true);
+  itemp_histogram_update(&s_histograms[1], itemps, n_itemps);
+  ASSERT_INT(s_histograms[1].bins[7], 4);
+  ASSERT_INT(memcmp(&s_histograms[0], &s_histograms[1],
+                    sizeof(itemp_histogram_t)),
+             0);
+
+  // the choices survive a round trip through the cache
+  tune.backends[ITEMP_TO_CELSIUS_10] = ITEMP_TUNE_TABLE;
+  tune.backends[FAHRENHEIT_1_TO_ITEMP] = ITEMP_TUNE_LOOP;
+  ASSERT_INT(itemp_tune_save(&tune, TEST_CACHE), true);
+  ASSERT_INT(itemp_tune_load(&loaded, TEST_CACHE), true);
+  for (int k = 0; k < ITEMP_TUNE_KERNELS; k++) {
+    ASSERT_INT(loaded.backends[k], tune.backends[k]);
+  }
+  ASSERT_INT(strcmp(loaded.signature, tune.signature), 0);
+
+  // a cache from another host, or a damaged one, is ignored
+  strcpy(tune.signature, "another host");
+  ASSERT_INT(itemp_tune_save(&tune, TEST_CACHE), true);
+  ASSERT_INT(itemp_tune_load(&loaded, TEST_CACHE), false);
+  FILE *fp = fopen(TEST_CACHE, "w");
+  itemp_tune_signature(tune.signature, sizeof(tune.signature));
+  fprintf(fp, "%s\nsignature %s\nhistogram table\n", CACHE_HEADER,
+          tune.signature);
+  fclose(fp);
+  ASSERT_INT(itemp_tune_load(&loaded, TEST_CACHE), false);
+  ASSERT_INT(itemp_tune_load(&loaded, "no such file"), false);
+
+  // itemp_tune_init() writes the cache, then reads it back
+  remove(TEST_CACHE);
+  ASSERT_INT(itemp_tune_init(TEST_CACHE), true);
+  ASSERT_INT(itemp_tune_load(&loaded, TEST_CACHE), true);
+  ASSERT_INT(itemp_tune_init(TEST_CACHE), true);
+  for (int c = 0; c < ITEMP_CONVERSION_COUNT; c++) {
+    ASSERT_INT(count_mismatches((itemp_conversion_t)c), 0);
+  }
+  remove(TEST_CACHE);
+
+  // reset restores the loops
+  itemp_tune_reset();
+  for (int c = 0; c < ITEMP_CONVERSION_COUNT; c++) {
+    ASSERT_INT(s_tables[c] == NULL, true);
+    ASSERT_INT(count_mismatches((itemp_conversion_t)c), 0);
+  }
+
+#ifdef ITEMP_INSTRUMENT
+  // tuning converts every input, none of which should be counted, and a
+  // scalar backend counts each value once, as part of its batch
+  itemp_counters_t before;
+  itemp_counters_t after;
+  itemp_counters_snapshot(&before);
+  ASSERT_INT(itemp_tune_measure(&tune, 4096, 3), true);
+  for (int c = 0; c < ITEMP_CONVERSION_COUNT; c++) {
+    tune.backends[c] = ITEMP_TUNE_SCALAR;
+  }
+  ASSERT_INT(itemp_tune_apply(&tune), true);
+  itemp_convert_batch(CELSIUS_1_TO_ITEMP, &s_all[100], s_observed, 4);
+  itemp_counters_snapshot(&after);
+  ASSERT_INT(itemp_counters_conversions(&after) -
+                 itemp_counters_conversions(&before),
+             4);
+  ASSERT_INT(after.calls[CELSIUS_1_TO_ITEMP] - before.calls[CELSIUS_1_TO_ITEMP],
+             0);
+  ASSERT_INT(after.batch_values[CELSIUS_1_TO_ITEMP] -
+                 before.batch_values[CELSIUS_1_TO_ITEMP],
+             4);
+  // 100 to 103 C are all too hot
+  ASSERT_INT(after.out_of_range[CELSIUS_1_TO_ITEMP] -
+                 before.out_of_range[CELSIUS_1_TO_ITEMP],
+             4);
+  itemp_tune_reset();
+#endif
+
+  printf("\r\n...unit tests complete.\r\n");
+  return 0;
+}
+
+#endif
@@ -0,0 +1,172 @@
+/** @file itemp_tune.h
+ * Choose the fastest backend for each batch conversion, and for histogram
+ * updates, by timing the candidates on the host.
+ *
+ * Which one wins depends on the host: a table is one load per value but takes
+ * 128K bytes of cache, while the arithmetic loop costs a few multiplies per
+ * value and vectorizes to whatever instruction set the build allows.
+ * itemp_tune_init() times each candidate, keeps the choice in a small cache
+ * file so that later runs skip the timing, and installs it with
+ * itemp_set_batch_backend() and itemp_set_histogram_backend():
+ *
+ * @code
+ * itemp_tune_init("itemp_tune.cache");   // at startup, before other threads
+ * itemp_convert_batch(ITEMP_TO_FAHRENHEIT_10, itemps, f10, n);
+ * @endcode
+ *
+ * The backends installed apply to itemp_convert_batch(),
+ * itemp_convert_strided() and itemp_histogram_update(); the named xxx_batch()
+ * functions always run their own loop.  The cache records the CPU, its cache sizes and the
+ * instruction set the library was built for, and is ignored when any of them
+ * change.  `itemp_bench -T file` tunes offline and prints the timings.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_TUNE_H_
+#define _ITEMP_TUNE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// includes
+
+#include "itemp_batch.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// =============================================================================
+// types and definitions
+
+/**
+ * @brief The candidate implementations of a kernel.  Not every backend
+ * applies to every kernel.
+ */
+typedef enum {
+  ITEMP_TUNE_LOOP,    // the built in loop, vectorized by the compiler
+  ITEMP_TUNE_TABLE,   // conversions: one load from a 65536 entry table
+  ITEMP_TUNE_SCALAR,  // conversions: the itemp.h function, once per value
+  ITEMP_TUNE_PAIRED,  // histograms: two values per step, merging repeats
+  ITEMP_TUNE_BACKEND_COUNT
+} itemp_tune_backend_t;
+
+/**
+ * @brief The kernels tuned are each itemp_conversion_t, in order, then
+ * histogram updates.
+ */
+#define ITEMP_TUNE_HISTOGRAM ITEMP_CONVERSION_COUNT
+#define ITEMP_TUNE_KERNELS (ITEMP_CONVERSION_COUNT + 1)
+
+#define ITEMP_TUNE_SIGNATURE_MAX 160
+
+// Defaults for itemp_tune_init(): values per timed call, and timed calls per
+// candidate, of which the fastest counts.
+#define ITEMP_TUNE_ELEMENTS 16384
+#define ITEMP_TUNE_REPETITIONS 15
+
+/**
+ * @brief The backend chosen for each kernel, and the timings behind it.
+ */
+typedef struct {
+  char signature[ITEMP_TUNE_SIGNATURE_MAX];  // see itemp_tune_signature()
+  itemp_tune_backend_t backends[ITEMP_TUNE_KERNELS];
+  // ns per value of each candidate: 0 if it was not timed, as after
+  // itemp_tune_load() or for a backend that does not apply, and negative if
+  // it gave different results from the loop and was ruled out
+  double ns[ITEMP_TUNE_KERNELS][ITEMP_TUNE_BACKEND_COUNT];
+} itemp_tune_t;
+
+// =============================================================================
+// declarations
+
+/**
+ * Load the choices from path if it was written on this host and build, or
+ * else time the candidates and try to save the choices to path, then install
+ * them.  A cache that cannot be written is not an error; the next run times
+ * the candidates again.
+ *
+ * This is not thread safe: call it before other threads convert.
+ *
+ * @param path The cache file, or NULL to time the candidates every time.
+ * @returns false if out of memory, leaving the built in loops in place.
+ */
+bool itemp_tune_init(const char *path);
+
+/**
+ * Time each candidate of each kernel on n values, keeping the fastest of
+ * repetitions calls, and choose the fastest.  Another backend must beat the
+ * loop by more than 5% to be chosen, so that noise does not trade the loop
+ * for a 128K byte table.  Candidates are first checked against the loop over
+ * every possible input.
+ *
+ * @returns false if out of memory.
+ */
+bool itemp_tune_measure(itemp_tune_t *tune, size_t n, int repetitions);
+
+/**
+ * Install the backends chosen in tune, building any tables they need.
+ * @returns false if out of memory, leaving the built in loops in place.
+ */
+bool itemp_tune_apply(const itemp_tune_t *tune);
+
+/**
+ * Restore the built in loops and free the tables.
+ */
+void itemp_tune_reset(void);
+
+/**
+ * Write the choices in tune to path as text.
+ * @returns false if the file could not be written.
+ */
+bool itemp_tune_save(const itemp_tune_t *tune, const char *path);
+
+/**
+ * Read the choices written by itemp_tune_save().
+ * @returns false if path cannot be read, is malformed, or was written for a
+ * different signature.
+ */
+bool itemp_tune_load(itemp_tune_t *tune, const char *path);
+
+/**
+ * Describe the host and build, e.g. "x86_64 avx2 l1d=49152 l2=2097152
+ * l3=0 Intel(R) Xeon(R) ...", always null terminated.
+ */
+void itemp_tune_signature(char *buf, size_t size);
+
+/**
+ * Return the name of a kernel, e.g. "itemp_to_celsius_10" or "histogram".
+ */
+const char *itemp_tune_kernel_name(int kernel);
+
+/**
+ * Return the name of a backend, e.g. "table".
+ */
+const char *itemp_tune_backend_name(itemp_tune_backend_t backend);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _ITEMP_TUNE_H_ */
@@ -0,0 +1,265 @@
+/** @file itemp_views.hpp
+ * C++20 range adaptors that convert itemp values lazily, without building a
+ * temporary container:
+ *
+ * @code
+ * std::vector<itemp_t> itemps = ...;
+ * for (int16_t c100 : itemps | itemp::views::to_celsius_100) { ... }
+ * int16_t c100 = (itemps | itemp::views::to_celsius_100)[42];
+ * @endcode
+ *
+ * The views are random access and sized whenever the underlying range is.  To
+ * fill a contiguous output, use itemp::ranges::copy(): when the underlying range
+ * is contiguous it hands the whole range to the batch (SIMD) conversions in
+ * itemp_batch.h instead of converting one element at a time.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_VIEWS_HPP_
+#define _ITEMP_VIEWS_HPP_
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include "itemp_batch.h"
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+namespace itemp {
+
+// =============================================================================
+// types and definitions
+
+namespace detail {
+
+/**
+ * @brief Ties a scalar conversion to its batch equivalent.
+ */
+template <class In, class Out, Out (*Scalar)(In),
+          void (*Batch)(const In *, Out *, size_t)>
+struct conversion {
+  using input_type = In;
+  using output_type = Out;
+
+  Out operator()(In value) const { return Scalar(value); }
+
+  static void batch(const In *in, Out *out, size_t n) { Batch(in, out, n); }
+};
+
+}  // namespace detail
+
+/**
+ * @brief A view of another range with Conversion applied to each element.
+ */
+template <std::ranges::view V, class Conversion>
+  requires std::ranges::input_range<V> &&
+           std::same_as<std::ranges::range_value_t<V>,
+                        typename Conversion::input_type>
+class convert_view
+    : public std::ranges::view_interface<convert_view<V, Conversion>> {
+ public:
+  using conversion_type = Conversion;
+
+  convert_view()
+    requires std::default_initializable<V>
+  = default;
+
+  constexpr explicit convert_view(V base)
+      : transformed_(std::move(base), Conversion{}) {}
+
+  constexpr V base() const &
+    requires std::copy_constructible<V>
+  {
+    return transformed_.base();
+  }
+  constexpr V base() && { return std::move(transformed_).base(); }
+
+  constexpr auto begin() { return transformed_.begin(); }
+  constexpr auto begin() const
+    requires std::ranges::range<const V>
+  {
+    return transformed_.begin();
+  }
+  constexpr auto end() { return transformed_.end(); }
+  constexpr auto end() const
+    requires std::ranges::range<const V>
+  {
+    return transformed_.end();
+  }
+
+  constexpr auto size()
+    requires std::ranges::sized_range<V>
+  {
+    return transformed_.size();
+  }
+  constexpr auto size() const
+    requires std::ranges::sized_range<const V>
+  {
+    return transformed_.size();
+  }
+
+ private:
+  std::ranges::transform_view<V, Conversion> transformed_;
+};
+
+namespace detail {
+
+template <class Conversion>
+struct convert_adaptor {
+  template <std::ranges::viewable_range R>
+    requires std::same_as<std::ranges::range_value_t<R>,
+                          typename Conversion::input_type>
+  constexpr auto operator()(R &&r) const {
+    return convert_view<std::views::all_t<R>, Conversion>(
+        std::views::all(std::forward<R>(r)));
+  }
+
+  template <std::ranges::viewable_range R>
+    requires std::same_as<std::ranges::range_value_t<R>,
+                          typename Conversion::input_type>
+  friend constexpr auto operator|(R &&r, const convert_adaptor &adaptor) {
+    return adaptor(std::forward<R>(r));
+  }
+};
+
+template <class T>
+inline constexpr bool is_convert_view = false;
+
+template <class V, class Conversion>
+inline constexpr bool is_convert_view<convert_view<V, Conversion>> = true;
+
+/**
+ * @brief True when copying View to O can be done by one batch conversion.
+ */
+template <class View, class O>
+concept batch_copyable =
+    is_convert_view<View> &&
+    std::ranges::contiguous_range<
+        decltype(std::declval<const View &>().base())> &&
+    std::ranges::sized_range<decltype(std::declval<const View &>().base())> &&
+    std::contiguous_iterator<O> &&
+    std::same_as<std::iter_value_t<O>,
+                 typename View::conversion_type::output_type>;
+
+}  // namespace detail
+
+// =============================================================================
+// adaptors
+
+namespace views {
+
+inline constexpr detail::convert_adaptor<
+    detail::conversion<itemp_t, int16_t, itemp_to_fahrenheit_1,
+                       itemp_to_fahrenheit_1_batch>>
+    to_fahrenheit_1{};
+inline constexpr detail::convert_adaptor<
+    detail::conversion<itemp_t, int16_t, itemp_to_fahrenheit_10,
+                       itemp_to_fahrenheit_10_batch>>
+    to_fahrenheit_10{};
+inline constexpr detail::convert_adaptor<
+    detail::conversion<itemp_t, int16_t, itemp_to_fahrenheit_100,
+                       itemp_to_fahrenheit_100_batch>>
+    to_fahrenheit_100{};
+inline constexpr detail::convert_adaptor<
+    detail::conversion<itemp_t, int16_t, itemp_to_celsius_1,
+                       itemp_to_celsius_1_batch>>
+    to_celsius_1{};
+inline constexpr detail::convert_adaptor<
+    detail::conversion<itemp_t, int16_t, itemp_to_celsius_10,
+                       itemp_to_celsius_10_batch>>
+    to_celsius_10{};
+inline constexpr detail::convert_adaptor<
+    detail::conversion<itemp_t, int16_t, itemp_to_celsius_100,
+                       itemp_to_celsius_100_batch>>
+    to_celsius_100{};
+
+inline constexpr detail::convert_adaptor<
+    detail::conversion<int16_t, itemp_t, fahrenheit_1_to_itemp,
+                       fahrenheit_1_to_itemp_batch>>
+    from_fahrenheit_1{};
+inline constexpr detail::convert_adaptor<
+    detail::conversion<int16_t, itemp_t, fahrenheit_10_to_itemp,
+                       fahrenheit_10_to_itemp_batch>>
+    from_fahrenheit_10{};
+inline constexpr detail::convert_adaptor<
+    detail::conversion<int16_t, itemp_t, fahrenheit_100_to_itemp,
+                       fahrenheit_100_to_itemp_batch>>
+    from_fahrenheit_100{};
+inline constexpr detail::convert_adaptor<
+    detail::conversion<int16_t, itemp_t, celsius_1_to_itemp,
+                       celsius_1_to_itemp_batch>>
+    from_celsius_1{};
+inline constexpr detail::convert_adaptor<
+    detail::conversion<int16_t, itemp_t, celsius_10_to_itemp,
+                       celsius_10_to_itemp_batch>>
+    from_celsius_10{};
+inline constexpr detail::convert_adaptor<
+    detail::conversion<int16_t, itemp_t, celsius_100_to_itemp,
+                       celsius_100_to_itemp_batch>>
+    from_celsius_100{};
+
+}  // namespace views
+
+// =============================================================================
+// algorithms
+
+namespace ranges {
+
+/**
+ * Copy r to out, like std::ranges::copy(r, out).out.
+ *
+ * If r is one of the itemp views over a contiguous, sized range and out is a
+ * contiguous iterator of the converted type, the whole range is converted by
+ * a single call to the matching batch function.
+ *
+ * @returns An iterator one past the last element written.
+ */
+template <std::ranges::input_range R, std::weakly_incrementable O>
+  requires std::indirectly_copyable<std::ranges::iterator_t<R>, O>
+O copy(R &&r, O out) {
+  using view_type = std::remove_cvref_t<R>;
+  if constexpr (detail::batch_copyable<view_type, O>) {
+    auto base = r.base();
+    size_t n = std::ranges::size(base);
+    view_type::conversion_type::batch(std::ranges::data(base),
+                                      std::to_address(out), n);
+    return out + n;
+  } else {
+    return std::ranges::copy(std::forward<R>(r), std::move(out)).out;
+  }
+}
+
+}  // namespace ranges
+
+}  // namespace itemp
+
+#endif /* #ifndef _ITEMP_VIEWS_HPP_ */
@@ -0,0 +1,117 @@
+/** @file itemp_views_test.cpp
+ * Unit tests for itemp_views.hpp.
+ *
+ * To run tests on a unix-like system:
+ *   cc -Wall -c itemp.c itemp_batch.c
+ *   c++ -std=c++20 -Wall -o itemp_views_test itemp_views_test.cpp itemp.o \
+ *       itemp_batch.o && ./itemp_views_test
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp_views.hpp"
+#include "itemp_unit_test.h"
+#include <array>
+#include <list>
+#include <vector>
+
+// =============================================================================
+// self test
+
+static_assert(std::ranges::random_access_range<
+              decltype(std::declval<std::vector<itemp_t> &>() |
+                       itemp::views::to_celsius_100)>);
+static_assert(std::ranges::sized_range<
+              decltype(std::declval<std::vector<itemp_t> &>() |
+                       itemp::views::to_celsius_100)>);
+static_assert(std::ranges::view<
+              decltype(std::declval<std::vector<itemp_t> &>() |
+                       itemp::views::to_celsius_100)>);
+
+static_assert(itemp::detail::batch_copyable<
+              decltype(std::declval<std::vector<itemp_t> &>() |
+                       itemp::views::to_celsius_100),
+              std::vector<int16_t>::iterator>);
+static_assert(!itemp::detail::batch_copyable<
+              decltype(std::declval<std::list<itemp_t> &>() |
+                       itemp::views::to_celsius_100),
+              int16_t *>);
+
+int main() {
+  printf("Beginning unit tests...");
+
+  std::vector<itemp_t> itemps = {fahrenheit_1_to_itemp(70),
+                                 fahrenheit_1_to_itemp(68),
+                                 celsius_1_to_itemp(0)};
+
+  // lazy iteration and random access
+  auto f100 = itemps | itemp::views::to_fahrenheit_100;
+  ASSERT_INT(f100.size(), 3);
+  ASSERT_INT(f100[0], 7000);
+  ASSERT_INT(f100[1], 6800);
+  ASSERT_INT(*(f100.end() - 1), 3200);
+
+  int n = 0;
+  for (int16_t c1 : itemps | itemp::views::to_celsius_1) {
+    ASSERT_INT(c1, itemp_to_celsius_1(itemps[n++]));
+  }
+  ASSERT_INT(n, 3);
+
+  // composes with the standard adaptors
+  auto tail = itemps | itemp::views::to_fahrenheit_1 | std::views::drop(1);
+  ASSERT_INT(*tail.begin(), 68);
+
+  // round trip through both directions
+  std::array<int16_t, 3> c100 = {2000, -150, 0};
+  auto back =
+      c100 | itemp::views::from_celsius_100 | itemp::views::to_celsius_100;
+  ASSERT_INT(back[1], -150);
+
+  // contiguous input and output: converted by the batch function
+  std::vector<itemp_t> all(65536);
+  for (size_t i = 0; i < all.size(); i++) {
+    all[i] = (itemp_t)i;
+  }
+  std::vector<int16_t> out(all.size());
+  auto last = itemp::ranges::copy(all | itemp::views::to_fahrenheit_10,
+                                  out.begin());
+  ASSERT_INT(last == out.end(), 1);
+  int mismatches = 0;
+  for (size_t i = 0; i < all.size(); i++) {
+    mismatches += (out[i] != itemp_to_fahrenheit_10(all[i]));
+  }
+  ASSERT_INT(mismatches, 0);
+
+  // non-contiguous input or output falls back to element by element
+  std::list<itemp_t> listed(itemps.begin(), itemps.end());
+  std::vector<int16_t> converted;
+  itemp::ranges::copy(listed | itemp::views::to_celsius_100,
+                      std::back_inserter(converted));
+  ASSERT_INT(converted.size(), 3);
+  ASSERT_INT(converted[2], 0);
+
+  printf("\r\n...unit tests complete.\r\n");
+}
@@ -0,0 +1,517 @@
+/** @file itemp_workload.c
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// =============================================================================
+// includes
+
+#include "itemp_workload.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// =============================================================================
+// local types and definitions
+
+#define ITEMP_MAX 65535
+#define SECONDS_PER_DAY 86400
+#define DAY_SHIFT 22 // 32 bit phase to a table index
+#define TILE_SENSORS 16 // a fleet is generated a tile of sensors at a time,
+#define TILE_ROUNDS 64  // and this many readings of each
+
+// =============================================================================
+// local (forward) declarations
+
+/**
+ * @brief xorshift64*, which is fast and good enough for noise.
+ */
+static inline uint64_t next_random(uint64_t *state);
+
+/**
+ * @brief A 32 bit integer hash (lowbias32), which vectorizes.
+ */
+static inline uint32_t hash_32(uint32_t x);
+
+/**
+ * @brief Return a random gap until the next event, averaging 10^6 / rate
+ * readings, or UINT32_MAX if rate is 0.
+ */
+static uint32_t event_gap(uint64_t *rng, uint32_t rate);
+
+/**
+ * @brief Return a sensor's reading `ahead` readings from now, without events:
+ * its base, plus the points in the day and in the thermostat's cycle, plus
+ * triangular noise.  Depending only on the step, rather than on a chain of
+ * random numbers, lets a run of readings vectorize.
+ */
+static inline int32_t reading(const itemp_workload_t *workload,
+                              const itemp_workload_sensor_t *sensor,
+                              uint32_t ahead);
+
+static inline itemp_t clamp(int32_t value);
+
+/**
+ * @brief Move a sensor's clocks forward by some number of readings.
+ */
+static inline void advance(const itemp_workload_t *workload,
+                           itemp_workload_sensor_t *sensor, uint32_t readings);
+
+/**
+ * @brief Produce n readings, none of which has an event due.
+ */
+static void generate_run(itemp_workload_t *workload,
+                         itemp_workload_sensor_t *sensor, itemp_t *itemps,
+                         uint32_t *timestamps, size_t n);
+
+/**
+ * @brief Produce one reading, with whatever events are due.
+ */
+static void generate_one(itemp_workload_t *workload,
+                         itemp_workload_sensor_t *sensor, itemp_t *itemp,
+                         uint32_t *timestamp);
+
+// =============================================================================
+// local storage
+
+// =============================================================================
+// public code
+
+void itemp_workload_config_init(itemp_workload_config_t *config,
+                                size_t n_sensors, uint64_t seed) {
+  memset(config, 0, sizeof(*config));
+  config->seed = seed;
+  config->n_sensors = n_sensors;
+  config->start_time = 1577836800; // 2020-01-01T00:00:00Z
+  config->interval = 60;
+  config->base_min = fahrenheit_1_to_itemp(65);
+  config->base_max = fahrenheit_1_to_itemp(75);
+  config->diurnal_amplitude = 3 * ITEMP_ONE_DEGREE_F / 2;
+  config->hvac_amplitude = ITEMP_ONE_DEGREE_F / 2;
+  config->hvac_period = 20 * 60;
+  config->noise_amplitude = ITEMP_ONE_TENTH_DEGREE_F;
+  config->spike_rate = 100;
+  config->spike_amplitude = 10 * ITEMP_ONE_DEGREE_F;
+  config->dropout_rate = 200;
+  config->dropout_length = 30;
+  config->excursion_rate = 10;
+  config->excursion_length = 20;
+}
+
+bool itemp_workload_init(itemp_workload_t *workload,
+                         const itemp_workload_config_t *config) {
+  const double pi = 3.14159265358979323846;
+
+  workload->config = *config;
+  workload->sensors = calloc(config->n_sensors ? config->n_sensors : 1,
+                             sizeof(itemp_workload_sensor_t));
+  if (workload->sensors == NULL) {
+    return false;
+  }
+  // coldest at 4am, warmest at 4pm
+  for (int i = 0; i < ITEMP_WORKLOAD_DAY_STEPS; i++) {
+    double hours = 24.0 * i / ITEMP_WORKLOAD_DAY_STEPS;
+    workload->day[i] = (int16_t)lrint(32767 * sin(2 * pi * (hours - 10) / 24));
+  }
+  workload->day_step =
+      (uint32_t)(((uint64_t)config->interval << 32) / SECONDS_PER_DAY);
+
+  uint64_t seeder = config->seed ^ 0x9e3779b97f4a7c15u;
+  for (size_t i = 0; i < config->n_sensors; i++) {
+    itemp_workload_sensor_t *sensor = &workload->sensors[i];
+    sensor->rng = next_random(&seeder) | 1;  // never zero
+    sensor->noise_key = (uint32_t)next_random(&sensor->rng);
+    uint64_t r = next_random(&sensor->rng);
+    uint32_t span = (uint32_t)config->base_max - config->base_min + 1;
+    sensor->base = config->base_min + (int32_t)((r & 0xffffffff) % span);
+    sensor->time = config->start_time;
+    // local time varies a little with the sensor's position
+    sensor->day_phase = (uint32_t)(config->start_time % SECONDS_PER_DAY) *
+                            (uint32_t)(((uint64_t)1 << 32) / SECONDS_PER_DAY) +
+                        (uint32_t)(r >> 32) / 16;
+    // a period of 0.75 to 1.25 times hvac_period
+    uint64_t period = config->hvac_period ? config->hvac_period : 1;
+    period = period * (3 * 1024 + (next_random(&sensor->rng) & 2047)) / 4096;
+    sensor->hvac_step = (uint32_t)(((uint64_t)config->interval << 32) /
+                                   (period ? period : 1));
+    sensor->hvac_phase = (uint32_t)next_random(&sensor->rng);
+    sensor->until_spike = event_gap(&sensor->rng, config->spike_rate);
+    sensor->until_dropout = event_gap(&sensor->rng, config->dropout_rate);
+    sensor->until_excursion = event_gap(&sensor->rng, config->excursion_rate);
+  }
+  return true;
+}
+
+void itemp_workload_free(itemp_workload_t *workload) {
+  free(workload->sensors);
+  workload->sensors = NULL;
+}
+
+void itemp_workload_generate(itemp_workload_t *workload, size_t sensor_index,
+                             itemp_t *itemps, uint32_t *timestamps, size_t n) {
+  itemp_workload_sensor_t *sensor = &workload->sensors[sensor_index];
+  size_t i = 0;
+  while (i < n) {
+    // Events are rare, so most readings come from the branch free run
+    // between them.
+    uint32_t until = sensor->until_spike;
+    until = (sensor->until_dropout < until) ? sensor->until_dropout : until;
+    until = (sensor->until_excursion < until) ? sensor->until_excursion : until;
+    if (sensor->excursion_left > 0 || until <= 1) {
+      generate_one(workload, sensor, &itemps[i],
+                   timestamps ? &timestamps[i] : NULL);
+      i++;
+      continue;
+    }
+    size_t run = (n - i < until - 1) ? n - i : until - 1;
+    generate_run(workload, sensor, itemps + i,
+                 timestamps ? timestamps + i : NULL, run);
+    sensor->until_spike -= (uint32_t)run;
+    sensor->until_dropout -= (uint32_t)run;
+    sensor->until_excursion -= (uint32_t)run;
+    i += run;
+  }
+}
+
+void itemp_workload_generate_fleet(itemp_workload_t *workload, itemp_t *itemps,
+                                   uint32_t *timestamps, uint32_t *sensors,
+                                   size_t n) {
+  size_t n_sensors = workload->config.n_sensors;
+  itemp_t tile[TILE_SENSORS][TILE_ROUNDS];
+  uint32_t tile_times[TILE_SENSORS][TILE_ROUNDS];
+  if (n_sensors == 0) {
+    return;
+  }
+  // Generate a tile of sensors' next rounds with itemp_workload_generate(),
+  // which checks for events once per run rather than once per reading, then
+  // write the tile out a round at a time.
+  size_t rounds = (n + n_sensors - 1) / n_sensors;
+  for (size_t round = 0; round < rounds; round += TILE_ROUNDS) {
+    size_t n_rounds =
+        (rounds - round < TILE_ROUNDS) ? rounds - round : TILE_ROUNDS;
+    for (size_t first = 0; first < n_sensors; first += TILE_SENSORS) {
+      size_t width = (n_sensors - first < TILE_SENSORS) ? n_sensors - first
+                                                        : TILE_SENSORS;
+      for (size_t s = 0; s < width; s++) {
+        // the last round may hold readings from only the first sensors
+        size_t j = (round + n_rounds - 1) * n_sensors + first + s;
+        size_t count = (j < n) ? n_rounds : n_rounds - 1;
+        itemp_workload_generate(workload, first + s, tile[s],
+                                timestamps ? tile_times[s] : NULL, count);
+      }
+      for (size_t r = 0; r < n_rounds; r++) {
+        size_t j = (round + r) * n_sensors + first;
+        if (j >= n) {
+          break;
+        }
+        size_t m = (n - j < width) ? n - j : width;
+        for (size_t s = 0; s < m; s++) {
+          itemps[j + s] = tile[s][r];
+        }
+        if (timestamps != NULL) {
+          for (size_t s = 0; s < m; s++) {
+            timestamps[j + s] = tile_times[s][r];
+          }
+        }
+        if (sensors != NULL) {
+          for (size_t s = 0; s < m; s++) {
+            sensors[j + s] = (uint32_t)(first + s);
+          }
+        }
+      }
+    }
+  }
+}
+
+// =============================================================================
+// local (static) code
+
+static inline uint64_t next_random(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  return x * 0x2545f4914f6cdd1du;
+}
+
+static inline uint32_t hash_32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+static uint32_t event_gap(uint64_t *rng, uint32_t rate) {
+  if (rate == 0) {
+    return UINT32_MAX;
+  }
+  // uniform over 1..2 * mean, which has the right mean
+  uint64_t mean = 1000000 / rate;
+  mean = (mean > 0) ? mean : 1;
+  uint64_t gap = 1 + next_random(rng) % (2 * mean);
+  return (gap < UINT32_MAX) ? (uint32_t)gap : UINT32_MAX - 1;
+}
+
+static inline int32_t reading(const itemp_workload_t *workload,
+                              const itemp_workload_sensor_t *sensor,
+                              uint32_t ahead) {
+  const itemp_workload_config_t *config = &workload->config;
+  uint32_t day_phase = sensor->day_phase + ahead * workload->day_step;
+  uint32_t hvac_phase = sensor->hvac_phase + ahead * sensor->hvac_step;
+  uint32_t random = hash_32(sensor->noise_key + sensor->step + ahead);
+
+  int32_t day = workload->day[day_phase >> DAY_SHIFT];
+  // a triangle wave, -32768..32767
+  int32_t hvac =
+      (int32_t)((hvac_phase ^ (uint32_t)((int32_t)hvac_phase >> 31)) >> 15) -
+      32768;
+  int32_t noise =
+      (int32_t)(random & 0xffff) + (int32_t)((random >> 16) & 0xffff) - 65535;
+  return sensor->base + ((day * config->diurnal_amplitude) >> 15) +
+         ((hvac * config->hvac_amplitude) >> 15) +
+         ((noise * (int32_t)config->noise_amplitude) >> 16);
+}
+
+static inline itemp_t clamp(int32_t value) {
+  return (value < 0) ? 0 : (value > ITEMP_MAX) ? ITEMP_MAX : (itemp_t)value;
+}
+
+static inline void advance(const itemp_workload_t *workload,
+                           itemp_workload_sensor_t *sensor, uint32_t readings) {
+  sensor->step += readings;
+  sensor->time += readings * workload->config.interval;
+  sensor->day_phase += readings * workload->day_step;
+  sensor->hvac_phase += readings * sensor->hvac_step;
+}
+
+static void generate_run(itemp_workload_t *workload,
+                         itemp_workload_sensor_t *sensor, itemp_t *itemps,
+                         uint32_t *timestamps, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    itemps[i] = clamp(reading(workload, sensor, (uint32_t)i));
+  }
+  if (timestamps != NULL) {
+    for (size_t i = 0; i < n; i++) {
+      timestamps[i] = sensor->time + (uint32_t)i * workload->config.interval;
+    }
+  }
+  advance(workload, sensor, (uint32_t)n);
+}
+
+static void generate_one(itemp_workload_t *workload,
+                         itemp_workload_sensor_t *sensor, itemp_t *itemp,
+                         uint32_t *timestamp) {
+  const itemp_workload_config_t *config = &workload->config;
+
+  if (sensor->until_dropout <= 1) {
+    // lose some readings
+    uint64_t r = next_random(&sensor->rng);
+    uint32_t length = config->dropout_length ? config->dropout_length : 1;
+    advance(workload, sensor, 1 + (uint32_t)(r % length));
+    sensor->until_dropout = event_gap(&sensor->rng, config->dropout_rate);
+  } else {
+    sensor->until_dropout--;
+  }
+
+  // Only events draw from rng, so a reading is the same whether it is made
+  // here or in generate_run().
+  int32_t value = reading(workload, sensor, 0);
+
+  if (sensor->until_spike <= 1) {
+    int32_t spike = config->spike_amplitude;
+    value += (next_random(&sensor->rng) >> 63) ? spike : -spike;
+    sensor->until_spike = event_gap(&sensor->rng, config->spike_rate);
+  } else {
+    sensor->until_spike--;
+  }
+
+  if (sensor->excursion_left > 0) {
+    value = sensor->excursion_value;
+    sensor->excursion_left--;
+  } else if (sensor->until_excursion <= 1) {
+    sensor->excursion_value = (next_random(&sensor->rng) >> 63) ? ITEMP_MAX : 0;
+    sensor->excursion_left = config->excursion_length;
+    if (sensor->excursion_left > 0) {
+      value = sensor->excursion_value;
+      sensor->excursion_left--;
+    }
+    sensor->until_excursion = event_gap(&sensor->rng, config->excursion_rate);
+  } else {
+    sensor->until_excursion--;
+  }
+
+  *itemp = clamp(value);
+  if (timestamp != NULL) {
+    *timestamp = sensor->time;
+  }
+  advance(workload, sensor, 1);
+}
+
+// =============================================================================
+// self test
+
+// To run tests on a unix-like system:
+//   cc -Wall -c itemp.c
+//   cc -Wall -DUNIT_TEST -c itemp_workload.c
+//   cc -o itemp_workload itemp_workload.o itemp.o -lm && ./itemp_workload
+
+#ifdef UNIT_TEST
+
+#include "itemp_unit_test.h"
+#include <stdio.h>
+
+#define N_READINGS 1000000
+#define N_SENSORS 8
+
+static itemp_t s_a[N_READINGS];
+static itemp_t s_b[N_READINGS];
+static uint32_t s_ta[N_READINGS];
+static uint32_t s_tb[N_READINGS];
+static uint32_t s_sensors[N_READINGS];
+
+int main() {
+  printf("Beginning unit tests...");
+
+  itemp_workload_config_t config;
+  itemp_workload_t w1;
+  itemp_workload_t w2;
+
+  // the same seed gives the same readings, however they are requested
+  itemp_workload_config_init(&config, N_SENSORS, 42);
+  itemp_workload_init(&w1, &config);
+  itemp_workload_init(&w2, &config);
+  itemp_workload_generate(&w1, 3, s_a, s_ta, N_READINGS);
+  itemp_workload_generate(&w2, 3, s_b, s_tb, 1000);
+  itemp_workload_generate(&w2, 3, s_b + 1000, s_tb + 1000, 1);
+  itemp_workload_generate(&w2, 3, s_b + 1001, s_tb + 1001, N_READINGS - 1001);
+  ASSERT_INT(memcmp(s_a, s_b, sizeof(s_a)), 0);
+  ASSERT_INT(memcmp(s_ta, s_tb, sizeof(s_ta)), 0);
+
+  // events at about the configured rates
+  int excursions = 0;
+  int gaps = 0;
+  int spikes = 0;
+  int64_t sum = 0;
+  int64_t count = 0;
+  for (int i = 0; i < N_READINGS; i++) {
+    if (s_a[i] == 0 || s_a[i] == ITEMP_MAX) {
+      excursions++;
+      continue;
+    }
+    if (i > 0 && s_ta[i] - s_ta[i - 1] != config.interval) {
+      gaps++;
+    }
+    if (i > 0 && s_a[i - 1] != 0 && s_a[i - 1] != ITEMP_MAX &&
+        abs((int)s_a[i] - (int)s_a[i - 1]) > 5 * ITEMP_ONE_DEGREE_F) {
+      spikes++; // counts both edges of each spike
+    }
+    sum += s_a[i];
+    count++;
+  }
+  ASSERT_INT(excursions > N_READINGS / 1000000 * 10 * 20 / 2, 1);
+  ASSERT_INT(excursions < N_READINGS / 1000000 * 10 * 20 * 2, 1);
+  ASSERT_INT(gaps > N_READINGS / 1000000 * 200 / 2, 1);
+  ASSERT_INT(gaps < N_READINGS / 1000000 * 200 * 2, 1);
+  ASSERT_INT(spikes > N_READINGS / 1000000 * 100 * 2 / 2, 1);
+  ASSERT_INT(spikes < N_READINGS / 1000000 * 100 * 2 * 2, 1);
+  // about two years of minutes, so the cycles average out
+  ASSERT_INT(abs((int)(sum / count) - w1.sensors[3].base) <
+                 ITEMP_ONE_TENTH_DEGREE_F,
+             1);
+
+  // different seeds differ
+  itemp_workload_free(&w2);
+  config.seed = 43;
+  itemp_workload_init(&w2, &config);
+  itemp_workload_generate(&w2, 3, s_b, NULL, 1000);
+  ASSERT_INT(memcmp(s_a, s_b, 1000 * sizeof(itemp_t)) != 0, 1);
+  itemp_workload_free(&w1);
+  itemp_workload_free(&w2);
+
+  // without events, every reading is within the amplitudes of its base and
+  // one interval after the last
+  itemp_workload_config_init(&config, N_SENSORS, 7);
+  config.spike_rate = 0;
+  config.dropout_rate = 0;
+  config.excursion_rate = 0;
+  itemp_workload_init(&w1, &config);
+  itemp_workload_generate(&w1, 0, s_a, s_ta, N_READINGS);
+  int32_t reach = config.diurnal_amplitude + config.hvac_amplitude +
+                  config.noise_amplitude;
+  int out_of_reach = 0;
+  int bad_times = 0;
+  for (int i = 0; i < N_READINGS; i++) {
+    out_of_reach += abs((int)s_a[i] - w1.sensors[0].base) > reach;
+    bad_times += s_ta[i] != config.start_time + (uint32_t)i * config.interval;
+  }
+  ASSERT_INT(out_of_reach, 0);
+  ASSERT_INT(bad_times, 0);
+  itemp_workload_free(&w1);
+
+  // a fleet is each sensor's readings in turn
+  itemp_workload_config_init(&config, N_SENSORS, 99);
+  itemp_workload_init(&w1, &config);
+  itemp_workload_init(&w2, &config);
+  itemp_workload_generate_fleet(&w1, s_a, s_ta, s_sensors, N_READINGS);
+  int mismatches = 0;
+  for (int s = 0; s < N_SENSORS; s++) {
+    itemp_workload_generate(&w2, s, s_b, s_tb, N_READINGS / N_SENSORS);
+    for (int i = 0; i < N_READINGS / N_SENSORS; i++) {
+      size_t j = (size_t)i * N_SENSORS + s;
+      mismatches += s_a[j] != s_b[i] || s_ta[j] != s_tb[i] ||
+                    s_sensors[j] != (uint32_t)s;
+    }
+  }
+  ASSERT_INT(mismatches, 0);
+  itemp_workload_free(&w1);
+  itemp_workload_free(&w2);
+
+  // and so is one whose sensors and rounds do not fill whole tiles, with a
+  // last round cut short
+  itemp_workload_config_init(&config, 40, 5);
+  itemp_workload_init(&w1, &config);
+  itemp_workload_init(&w2, &config);
+  size_t n_fleet = 40 * 1000 + 7;
+  itemp_workload_generate_fleet(&w1, s_a, s_ta, s_sensors, n_fleet);
+  mismatches = 0;
+  for (int s = 0; s < 40; s++) {
+    size_t count = (s < 7) ? 1001 : 1000;
+    itemp_workload_generate(&w2, s, s_b, s_tb, count);
+    for (size_t i = 0; i < count; i++) {
+      size_t j = i * 40 + s;
+      mismatches += s_a[j] != s_b[i] || s_ta[j] != s_tb[i] ||
+                    s_sensors[j] != (uint32_t)s;
+    }
+  }
+  ASSERT_INT(mismatches, 0);
+  itemp_workload_free(&w1);
+  itemp_workload_free(&w2);
+
+  printf("\r\n...unit tests complete.\r\n");
+  return 0;
+}
+
+#endif
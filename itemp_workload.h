@@ -0,0 +1,153 @@
+/** @file itemp_workload.h
+ * A fast, deterministic generator of realistic temperature readings from a
+ * fleet of sensors, for benchmarks and tests.
+ *
+ * Uniformly random itemp values have none of the structure of real readings,
+ * so they misrepresent anything that depends on it: branch prediction, value
+ * ranges, deltas between readings.  Each simulated sensor has a diurnal cycle,
+ * a thermostat (HVAC) sawtooth, noise, and occasional spikes, dropouts (gaps
+ * in the timestamps) and excursions to the ends of the itemp range, as from a
+ * disconnected probe.  The same seed always produces the same readings.
+ *
+ * MIT License
+ *
+ * Copyright (c) 2020 R. Dunbar Poor
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ITEMP_WORKLOAD_H_
+#define _ITEMP_WORKLOAD_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// =============================================================================
+// includes
+
+#include "itemp.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// =============================================================================
+// types and definitions
+
+// The number of entries in the table of one day's cycle.
+#define ITEMP_WORKLOAD_DAY_STEPS 1024
+
+/**
+ * @brief The shape of a fleet.  Temperatures and amplitudes are in itemp
+ * units, e.g. 3 * ITEMP_ONE_DEGREE_F; amplitudes are from the middle to the
+ * peak and must be less than 16384.  Rates are events per million readings.
+ */
+typedef struct {
+  uint64_t seed;
+  size_t n_sensors;
+  uint32_t start_time;    // timestamp of the first reading, in seconds
+  uint32_t interval;      // seconds between readings
+  itemp_t base_min;       // each sensor's mean lies in base_min..base_max
+  itemp_t base_max;
+  uint16_t diurnal_amplitude;
+  uint16_t hvac_amplitude;
+  uint32_t hvac_period;   // seconds per thermostat cycle, varied per sensor
+  uint16_t noise_amplitude;
+  uint32_t spike_rate;
+  uint16_t spike_amplitude;
+  uint32_t dropout_rate;
+  uint32_t dropout_length; // the longest gap, in readings
+  uint32_t excursion_rate;
+  uint32_t excursion_length; // readings pinned at 0 or 65535
+} itemp_workload_config_t;
+
+/**
+ * @brief The state of one sensor.
+ */
+typedef struct {
+  uint64_t rng;             // for events
+  uint32_t noise_key;       // noise is a hash of noise_key + the step
+  uint32_t step;            // readings so far, including any dropped
+  uint32_t time;            // timestamp of the next reading
+  uint32_t day_phase;       // 2^32 per day
+  uint32_t hvac_phase;      // 2^32 per thermostat cycle
+  uint32_t hvac_step;
+  int32_t base;
+  uint32_t until_spike;     // readings until the next event of each kind
+  uint32_t until_dropout;
+  uint32_t until_excursion;
+  uint32_t excursion_left;  // readings left in the current excursion
+  itemp_t excursion_value;
+} itemp_workload_sensor_t;
+
+typedef struct {
+  itemp_workload_config_t config;
+  itemp_workload_sensor_t *sensors;
+  uint32_t day_step;        // day_phase increment per reading
+  int16_t day[ITEMP_WORKLOAD_DAY_STEPS]; // the diurnal cycle, -32767..32767
+} itemp_workload_t;
+
+// =============================================================================
+// declarations
+
+/**
+ * Fill in a fleet of indoor sensors read once a minute: 65-75F, a 3F daily
+ * swing, a 1F thermostat cycle every 20 minutes, 0.1F of noise, and rare
+ * spikes, dropouts and excursions.
+ */
+void itemp_workload_config_init(itemp_workload_config_t *config,
+                                size_t n_sensors, uint64_t seed);
+
+/**
+ * Set up a workload.
+ *
+ * @returns false if the sensors cannot be allocated.
+ */
+bool itemp_workload_init(itemp_workload_t *workload,
+                         const itemp_workload_config_t *config);
+
+void itemp_workload_free(itemp_workload_t *workload);
+
+/**
+ * Generate the next n readings of one sensor.  Readings lost to a dropout
+ * are skipped, so their timestamps jump forward by more than the interval.
+ *
+ * Generating 1000 readings, then 1000 more, gives the same readings as
+ * generating 2000 at once.
+ *
+ * @param timestamps Receives the time of each reading, or may be NULL.
+ */
+void itemp_workload_generate(itemp_workload_t *workload, size_t sensor,
+                             itemp_t *itemps, uint32_t *timestamps, size_t n);
+
+/**
+ * Generate n readings from every sensor in turn, a round at a time, as a
+ * collector would receive them.
+ *
+ * @param sensors Receives the sensor index of each reading, or may be NULL.
+ */
+void itemp_workload_generate_fleet(itemp_workload_t *workload, itemp_t *itemps,
+                                   uint32_t *timestamps, uint32_t *sensors,
+                                   size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef _ITEMP_WORKLOAD_H_ */